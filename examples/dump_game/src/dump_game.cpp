@@ -35,6 +35,16 @@ int main(int argc, char** argv)
                                    + dump_folder);
         }
 
+        /* Lets MockProcess::loadDump give the areas their paths back */
+        std::ifstream maps_file("/proc/" + game_pid + "/maps");
+
+        if (maps_file.is_open())
+        {
+            std::ofstream maps_copy(dump_folder
+                                    + Asura::MockProcess::DUMP_MAPS_NAME);
+            maps_copy << maps_file.rdbuf();
+        }
+
         for (auto&& area : mmap.areas())
         {
             std::cout << std::hex << "[ 0x" << area->begin() << " - 0x"
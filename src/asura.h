@@ -9,27 +9,51 @@
 #include "circularbuffer.h"
 #include "custom_linux_syscalls.h"
 #include "detourx86.h"
+#include "elfview.h"
+#include "entropymap.h"
 #include "exception.h"
+#include "expected.h"
+#include "instrumentation.h"
 #include "kokabiel.h"
+#include "mappedfile.h"
 #include "memoryarea.h"
+#include "memorybackend.h"
 #include "memorymap.h"
+#include "memoryresource.h"
+#include "memorytrace.h"
 #include "memoryutils.h"
+#include "mockprocess.h"
+#include "moduleintegrity.h"
 #include "networkreadbuffer.h"
 #include "networkwritebuffer.h"
+#include "obfuscatedstring.h"
+#include "objectenumerator.h"
 #include "offset.h"
 #include "osutils.h"
+#include "packetauthenticator.h"
 #include "patternbyte.h"
 #include "patternscanning.h"
+#include "peimage.h"
+#include "pointerchainresolver.h"
 #include "process.h"
 #include "processbase.h"
 #include "processmemoryarea.h"
 #include "processmemorymap.h"
+#include "processsnapshot.h"
+#include "profiler.h"
 #include "readbuffer.h"
+#include "remoteview.h"
 #include "runnabletask.h"
 #include "simd.h"
+#include "spscqueue.h"
+#include "structdissector.h"
+#include "symbolindex.h"
 #include "task.h"
 #include "timer.h"
 #include "types.h"
+#include "udptransport.h"
+#include "valuewatcher.h"
+#include "virtualmachine.h"
 #include "virtualtabletools.h"
 #include "writebuffer.h"
 #include "xkc.h"
@@ -0,0 +1,145 @@
+#include "pch.h"
+
+#include "asura.h"
+
+using namespace Asura;
+
+#define ConsoleOutput(format) std::cout << "[Asura] -> " << format
+
+#ifndef WINDOWS
+/* Loopback, sendto/recv per packet against UDPTransport batches */
+static auto BenchmarkUDPTransport() -> void
+{
+    constexpr std::size_t packets_count = 0x10000;
+    constexpr std::size_t packet_size   = 64;
+    constexpr auto batch_size           = UDPTransport::BATCH_SIZE;
+
+    const auto packets_per_second = [](const Timer& timer)
+    {
+        return packets_count * 1000000000 / timer.difference();
+    };
+
+    Timer bench_timer {};
+
+    /* One syscall per packet */
+    {
+        const auto sender   = socket(AF_INET, SOCK_DGRAM, 0);
+        const auto receiver = socket(AF_INET, SOCK_DGRAM, 0);
+
+        auto to           = UDPTransport::Address("127.0.0.1", 0);
+        socklen_t to_size = sizeof(to);
+        bind(receiver, view_as<sockaddr*>(&to), sizeof(to));
+        getsockname(receiver, view_as<sockaddr*>(&to), &to_size);
+
+        /* Same as UDPTransport::receive, a lost packet can't block */
+        timeval timeout {};
+        timeout.tv_usec = 100000;
+        setsockopt(receiver,
+                   SOL_SOCKET,
+                   SO_RCVTIMEO,
+                   &timeout,
+                   sizeof(timeout));
+
+        std::array<byte_t, UDPTransport::PACKET_SIZE> packet {};
+        std::size_t lost = 0;
+
+        bench_timer.start();
+
+        for (std::size_t i = 0; i < packets_count; i += batch_size)
+        {
+            for (std::size_t j = 0; j < batch_size; j++)
+            {
+                sendto(sender,
+                       packet.data(),
+                       packet_size,
+                       0,
+                       view_as<sockaddr*>(&to),
+                       sizeof(to));
+            }
+
+            for (std::size_t j = 0; j < batch_size; j++)
+            {
+                if (recv(receiver, packet.data(), packet.size(), 0) < 0)
+                {
+                    lost += batch_size - j;
+                    break;
+                }
+            }
+        }
+
+        bench_timer.end();
+
+        close(sender);
+        close(receiver);
+
+        ConsoleOutput("sendto/recv: ")
+          << std::dec << packets_per_second(bench_timer)
+          << " packets per second, " << lost << " lost" << std::endl;
+    }
+
+    /* One syscall per batch */
+    {
+        UDPTransport sender, receiver;
+        const auto to = UDPTransport::Address("127.0.0.1", receiver.port());
+
+        std::size_t checksum = 0;
+
+        bench_timer.start();
+
+        for (std::size_t i = 0; i < packets_count; i += batch_size)
+        {
+            for (std::size_t j = 0; j < batch_size; j++)
+            {
+                auto&& packet = sender.acquire();
+                packet.writeVar<type_32us>(view_as<std::uint32_t>(j));
+                packet.pos(packet_size * CHAR_BIT);
+                sender.send(packet, to);
+            }
+
+            std::size_t received = 0;
+
+            while (received < batch_size)
+            {
+                const auto packets = receiver.receive(
+                  std::chrono::milliseconds(100));
+
+                /* Lost */
+                if (packets.empty())
+                {
+                    break;
+                }
+
+                for (auto&& packet : packets)
+                {
+                    checksum += packet.buffer.readVar<type_32us>();
+                }
+
+                received += packets.size();
+            }
+        }
+
+        bench_timer.end();
+
+        ConsoleOutput("UDPTransport: ")
+          << std::dec << packets_per_second(bench_timer)
+          << " packets per second, checksum " << checksum << std::endl;
+    }
+}
+#endif
+
+auto main() -> int
+{
+    try
+    {
+#ifndef WINDOWS
+        BenchmarkUDPTransport();
+#endif
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -7,7 +7,7 @@
 namespace Asura
 {
 #ifdef DEBUG
-    inline std::vector<ptr_t> tracking_memory_allocs;
+    inline std::unordered_set<ptr_t> tracking_memory_allocs;
 #endif
 
     constexpr auto UDPSize = 508;
@@ -18,7 +18,7 @@ namespace Asura
         const auto ptr = view_as<T>(::operator new(size));
 
 #ifdef DEBUG
-        tracking_memory_allocs.push_back(view_as<ptr_t>(ptr));
+        tracking_memory_allocs.insert(view_as<ptr_t>(ptr));
 #endif
 
         return ptr;
@@ -27,9 +27,7 @@ namespace Asura
     constexpr inline auto free(auto& pBuf)
     {
 #ifdef DEBUG
-        const auto it = std::find(tracking_memory_allocs.begin(),
-                                  tracking_memory_allocs.end(),
-                                  view_as<ptr_t>(pBuf));
+        const auto it = tracking_memory_allocs.find(view_as<ptr_t>(pBuf));
 
         if (it != tracking_memory_allocs.end())
         {
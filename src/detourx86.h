@@ -31,6 +31,22 @@ namespace Asura
                                   + (view_as<std::uintptr_t>(fromPtr)
                                      + 5);
 
+            /**
+             * In 64 bits, a pointer can't be cast to int32_t, the
+             * displacement is computed on the full addresses and must
+             * fit in the rel32.
+             */
+            const auto displacement = view_as<std::intptr_t>(
+              view_as<std::uintptr_t>(to)
+              - (view_as<std::uintptr_t>(fromPtr) + 5));
+
+            if (displacement < std::numeric_limits<std::int32_t>::min()
+                or displacement > std::numeric_limits<std::int32_t>::max())
+            {
+                ASURA_EXCEPTION("Can't reach the new function with a rel32, "
+                                "it's more than 2 GiB away");
+            }
+
             mapf_t flags;
             std::shared_ptr<ProcessMemoryArea> area;
 
@@ -51,8 +67,7 @@ namespace Asura
             }
 
             *view_as<std::int32_t*>(view_as<std::uintptr_t>(fromPtr) + 1)
-              = view_as<std::int32_t>(to)
-                - (view_as<std::int32_t>(fromPtr) + 5);
+              = view_as<std::int32_t>(displacement);
 
             if (afterOverride)
             {
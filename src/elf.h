@@ -51,9 +51,35 @@ namespace Asura
             PT_PHDR,
             PT_LOPROC,
             PT_HIPROC,
-            PT_GNU_STACK
+            PT_GNU_STACK,
+            PT_GNU_RELRO = 0x6474e552
         };
 
+        enum : std::uint32_t
+        {
+            PF_X = 1,
+            PF_W = 2,
+            PF_R = 4
+        };
+
+        /* Symbol types, in the low bits of st_info */
+        enum : std::uint8_t
+        {
+            STT_FUNC      = 2,
+            STT_GNU_IFUNC = 10
+        };
+
+        enum : std::uint16_t
+        {
+            EM_386     = 3,
+            EM_X86_64  = 62,
+            EM_AARCH64 = 183
+        };
+
+        /* Same for EM_386 and EM_X86_64 */
+        constexpr inline std::uint32_t R_X86_RELATIVE     = 8;
+        constexpr inline std::uint32_t R_AARCH64_RELATIVE = 1027;
+
         enum : int
         {
             DT_NULL,
@@ -84,6 +110,8 @@ namespace Asura
             DT_RUNPATH,
             DT_LOPROC,
             DT_HIPROC,
+            DT_RELRSZ   = 35,
+            DT_RELR     = 36,
             DT_GNU_HASH = 0x6ffffef5
         };
 
@@ -0,0 +1,23 @@
+#include "pch.h"
+
+#include "elfview.h"
+#include "memoryutils.h"
+
+using namespace Asura;
+
+#ifndef WINDOWS
+ELFView::ELFView(const MappedFile& file)
+ : _data(file.data()),
+   _size(file.size())
+{
+}
+
+auto ELFView::LoadBias(const std::uintptr_t baseAddress,
+                       const std::uintptr_t firstLoadAddress)
+  -> std::uintptr_t
+{
+    /* The base address maps the first page of the first segment */
+    return baseAddress
+           - (firstLoadAddress & ~(MemoryUtils::GetPageSize() - 1));
+}
+#endif
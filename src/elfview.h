@@ -0,0 +1,85 @@
+#ifndef ASURA_ELFVIEW_H
+#define ASURA_ELFVIEW_H
+
+#include "elf.h"
+#include "mappedfile.h"
+
+#ifndef WINDOWS
+namespace Asura
+{
+    /**
+     * Bounds checked reads of an ELF file mapped from disk, the headers
+     * and tables come from the file so none of their offsets can be
+     * trusted:
+     *
+     * const ELFView view(file);
+     * const auto header = view.at<ELF::Elf_Ehdr<T>>(0);
+     * const auto program_headers = view.at<ELF::Elf_Phdr<T>>(
+     *   header->e_phoff,
+     *   header->e_phnum);
+     */
+    class ELFView
+    {
+      public:
+        explicit ELFView(const MappedFile& file);
+
+      public:
+        /* count S at offset, throws when they go past the file */
+        template <typename S>
+        auto at(const std::size_t offset, const std::size_t count = 1) const
+          -> const S*
+        {
+            if (offset > _size or count > (_size - offset) / sizeof(S))
+            {
+                ASURA_EXCEPTION("Malformed ELF, " + std::to_string(offset)
+                                + " is out of the file");
+            }
+
+            return view_as<const S*>(_data + offset);
+        }
+
+        /* Lowest address of the PT_LOAD segments, if there's one */
+        template <ELF::IntType T>
+        auto firstLoadAddress() const -> std::optional<std::uintptr_t>
+        {
+            const auto header          = at<ELF::Elf_Ehdr<T>>(0);
+            const auto program_headers = at<ELF::Elf_Phdr<T>>(
+              header->e_phoff,
+              header->e_phnum);
+
+            std::optional<std::uintptr_t> first_address;
+
+            for (std::uint16_t i = 0; i < header->e_phnum; i++)
+            {
+                if (program_headers[i].p_type != ELF::PT_LOAD)
+                {
+                    continue;
+                }
+
+                const auto address = view_as<std::uintptr_t>(
+                  program_headers[i].p_vaddr);
+
+                first_address = std::min(first_address.value_or(address),
+                                         address);
+            }
+
+            return first_address;
+        }
+
+      public:
+        /**
+         * What the loader added to every address of the file, from
+         * where the module starts in memory.
+         */
+        static auto LoadBias(const std::uintptr_t baseAddress,
+                             const std::uintptr_t firstLoadAddress)
+          -> std::uintptr_t;
+
+      private:
+        const byte_t* _data;
+        std::size_t _size;
+    };
+}
+#endif
+
+#endif
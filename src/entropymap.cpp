@@ -0,0 +1,412 @@
+#include "pch.h"
+
+#include "entropymap.h"
+#include "exception.h"
+#include "mappedfile.h"
+#include "memoryutils.h"
+
+using namespace Asura;
+
+static constexpr std::size_t TABLES_COUNT = 4;
+
+using tables_t = std::uint32_t[TABLES_COUNT][256];
+
+/* One chunk of one region */
+struct MapJob
+{
+    std::size_t region;
+    std::size_t offset;
+    std::size_t size;
+    EntropyMap::histogram_t histogram {};
+};
+
+static inline auto CountWord(tables_t& tables, const std::uint64_t word)
+  -> void
+{
+    tables[0][word & 0xFF]++;
+    tables[1][(word >> 8) & 0xFF]++;
+    tables[2][(word >> 16) & 0xFF]++;
+    tables[3][(word >> 24) & 0xFF]++;
+    tables[0][(word >> 32) & 0xFF]++;
+    tables[1][(word >> 40) & 0xFF]++;
+    tables[2][(word >> 48) & 0xFF]++;
+    tables[3][word >> 56]++;
+}
+
+/* The counts of a table must stay under 2^32 */
+static auto CountBytes(const byte_t* data,
+                       const std::size_t size,
+                       tables_t& tables) -> void
+{
+    std::size_t i = 0;
+
+    for (; i + 2 * sizeof(std::uint64_t) <= size;
+         i += 2 * sizeof(std::uint64_t))
+    {
+        std::uint64_t first, second;
+        std::memcpy(&first, data + i, sizeof(first));
+        std::memcpy(&second, data + i + sizeof(first), sizeof(second));
+
+        CountWord(tables, first);
+        CountWord(tables, second);
+    }
+
+    for (; i < size; i++)
+    {
+        tables[i % TABLES_COUNT][data[i]]++;
+    }
+}
+
+/* Gives up on the first block with a byte set, most pages have one */
+static auto IsZero(const byte_t* data, const std::size_t size) -> bool
+{
+    constexpr std::size_t block_size = 8 * sizeof(std::uint64_t);
+
+    std::size_t i = 0;
+
+    for (; i + block_size <= size; i += block_size)
+    {
+        std::uint64_t words[8];
+        std::memcpy(words, data + i, sizeof(words));
+
+        std::uint64_t bits = 0;
+
+        for (const auto word : words)
+        {
+            bits |= word;
+        }
+
+        if (bits != 0)
+        {
+            return false;
+        }
+    }
+
+    for (; i < size; i++)
+    {
+        if (data[i] != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* count * log2(count) for every count a page can have */
+static auto GetCountLogs() -> const std::vector<float>&
+{
+    static const auto count_logs = []()
+    {
+        std::vector<float> logs(MemoryUtils::GetPageSize() + 1);
+
+        for (std::size_t i = 1; i < logs.size(); i++)
+        {
+            logs[i] = view_as<float>(view_as<double>(i)
+                                     * std::log2(view_as<double>(i)));
+        }
+
+        return logs;
+    }();
+
+    return count_logs;
+}
+
+static auto ToEntropy(const double bits) -> std::uint8_t
+{
+    return view_as<std::uint8_t>(
+      std::clamp(std::lround(bits * EntropyMap::MAX_ENTROPY / 8),
+                 0l,
+                 view_as<long>(EntropyMap::MAX_ENTROPY)));
+}
+
+/* data starts at the page firstPage of the region */
+static auto MapPages(const byte_t* data,
+                     const std::size_t size,
+                     const std::size_t firstPage,
+                     std::vector<std::uint8_t>& entropies,
+                     EntropyMap::histogram_t& histogram) -> void
+{
+    const auto page_size   = MemoryUtils::GetPageSize();
+    const auto& count_logs = GetCountLogs();
+
+    for (std::size_t offset = 0; offset < size; offset += page_size)
+    {
+        const auto page       = data + offset;
+        const auto page_bytes = std::min(page_size, size - offset);
+        auto&& entropy        = entropies[firstPage + offset / page_size];
+
+        if (IsZero(page, page_bytes))
+        {
+            histogram[0] += page_bytes;
+            entropy       = 0;
+            continue;
+        }
+
+        tables_t tables {};
+        CountBytes(page, page_bytes, tables);
+
+        /**
+         * -sum(p log2 p) with p = count / n is
+         * log2 n - sum(count log2 count) / n
+         */
+        float count_logs_sum = 0;
+
+        for (std::size_t value = 0; value < 256; value++)
+        {
+            const auto count = tables[0][value] + tables[1][value]
+                               + tables[2][value] + tables[3][value];
+
+            histogram[value] += count;
+            count_logs_sum   += count_logs[count];
+        }
+
+        entropy = ToEntropy(std::log2(view_as<double>(page_bytes))
+                            - count_logs_sum
+                                / view_as<double>(page_bytes));
+    }
+}
+
+template <typename F>
+static auto RunJobs(std::vector<MapJob>& jobs,
+                    const std::size_t threadsCount,
+                    const F& runJob) -> void
+{
+    const auto threads_count = std::max<std::size_t>(
+      1,
+      std::min<std::size_t>(threadsCount ?
+                              threadsCount :
+                              std::thread::hardware_concurrency(),
+                            jobs.size()));
+
+    std::atomic<std::size_t> next_job = 0;
+    std::vector<std::future<void>> workers;
+
+    for (std::size_t i = 0; i < threads_count; i++)
+    {
+        workers.push_back(std::async(
+          std::launch::async,
+          [&]()
+          {
+              bytes_t buffer(EntropyMap::CHUNK_SIZE);
+
+              for (auto index = next_job++; index < jobs.size();
+                   index      = next_job++)
+              {
+                  runJob(jobs[index], buffer);
+              }
+          }));
+    }
+
+    for (auto&& worker : workers)
+    {
+        worker.get();
+    }
+}
+
+static auto MakeJobs(const std::vector<EntropyMap::Region>& regions)
+  -> std::vector<MapJob>
+{
+    std::vector<MapJob> jobs;
+
+    for (std::size_t i = 0; i < regions.size(); i++)
+    {
+        for (std::size_t offset = 0; offset < regions[i].size;
+             offset += EntropyMap::CHUNK_SIZE)
+        {
+            jobs.push_back(
+              { i,
+                offset,
+                std::min(EntropyMap::CHUNK_SIZE, regions[i].size - offset) });
+        }
+    }
+
+    return jobs;
+}
+
+/* Jobs of a region are in order, their histograms are added in order */
+static auto MergeHistograms(const std::vector<MapJob>& jobs,
+                            std::vector<EntropyMap::Region>& regions)
+  -> void
+{
+    for (const auto& job : jobs)
+    {
+        auto&& histogram = regions[job.region].histogram;
+
+        for (std::size_t value = 0; value < histogram.size(); value++)
+        {
+            histogram[value] += job.histogram[value];
+        }
+    }
+}
+
+auto EntropyMap::Histogram(const byte_t* data,
+                           const std::size_t size,
+                           histogram_t& histogram) -> void
+{
+    /* Keeps the 32 bits counters of the tables from overflowing */
+    constexpr std::size_t block_size = std::size_t { 1 } << 30;
+
+    for (std::size_t offset = 0; offset < size; offset += block_size)
+    {
+        tables_t tables {};
+        CountBytes(data + offset, std::min(block_size, size - offset), tables);
+
+        for (std::size_t value = 0; value < histogram.size(); value++)
+        {
+            histogram[value] += view_as<std::uint64_t>(tables[0][value])
+                                + tables[1][value] + tables[2][value]
+                                + tables[3][value];
+        }
+    }
+}
+
+auto EntropyMap::Entropy(const histogram_t& histogram) -> double
+{
+    const auto total = std::accumulate(histogram.begin(),
+                                       histogram.end(),
+                                       std::uint64_t { 0 });
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    double entropy = 0;
+
+    for (const auto count : histogram)
+    {
+        if (count != 0)
+        {
+            const auto probability = view_as<double>(count)
+                                     / view_as<double>(total);
+            entropy -= probability * std::log2(probability);
+        }
+    }
+
+    return entropy;
+}
+
+auto EntropyMap::ToBits(const std::uint8_t entropy) -> double
+{
+    return view_as<double>(entropy) * 8 / MAX_ENTROPY;
+}
+
+auto EntropyMap::Map(const Process& process, const std::size_t threadsCount)
+  -> std::vector<Region>
+{
+    const auto page_size = MemoryUtils::GetPageSize();
+
+    std::vector<Region> regions;
+
+    for (const auto& area : process.mmap().areas())
+    {
+        if (area->category() == ProcessMemoryArea::GUARD
+            or not(area->protectionFlags().cachedValue()
+                   & MemoryArea::ProtectionFlags::READ))
+        {
+            continue;
+        }
+
+        regions.push_back({ area->begin(),
+                            area->size(),
+                            area->name(),
+                            std::vector<std::uint8_t>(
+                              (area->size() + page_size - 1) / page_size),
+                            {} });
+    }
+
+    auto jobs = MakeJobs(regions);
+
+    RunJobs(jobs,
+            threadsCount,
+            [&](MapJob& job, bytes_t& buffer)
+            {
+                auto&& region      = regions[job.region];
+                const auto address = region.address + job.offset;
+
+                if (MemoryUtils::TryReadProcessMemoryArea(process.id(),
+                                                          address,
+                                                          buffer.data(),
+                                                          job.size))
+                {
+                    MapPages(buffer.data(),
+                             job.size,
+                             job.offset / page_size,
+                             region.entropies,
+                             job.histogram);
+                    return;
+                }
+
+                /* Some pages of the chunk can still be read */
+                for (std::size_t offset = 0; offset < job.size;
+                     offset += page_size)
+                {
+                    const auto page = (job.offset + offset) / page_size;
+
+                    if (MemoryUtils::TryReadProcessMemoryArea(
+                          process.id(),
+                          address + offset,
+                          buffer.data(),
+                          page_size))
+                    {
+                        MapPages(buffer.data(),
+                                 page_size,
+                                 page,
+                                 region.entropies,
+                                 job.histogram);
+                    }
+                    else
+                    {
+                        region.entropies[page] = UNREADABLE;
+                    }
+                }
+            });
+
+    MergeHistograms(jobs, regions);
+
+    return regions;
+}
+
+#ifndef WINDOWS
+auto EntropyMap::MapFile(const std::string& path,
+                         const std::size_t threadsCount) -> Region
+{
+    const auto page_size = MemoryUtils::GetPageSize();
+
+    struct stat file_stat;
+
+    if (stat(path.c_str(), &file_stat) < 0)
+    {
+        ASURA_EXCEPTION("Couldn't stat " + path);
+    }
+
+    const MappedFile file(path, file_stat.st_dev, file_stat.st_ino);
+
+    std::vector<Region> regions {
+        { 0,
+         file.size(),
+         path,
+         std::vector<std::uint8_t>((file.size() + page_size - 1)
+                                   / page_size),
+         {} }
+    };
+
+    auto jobs = MakeJobs(regions);
+
+    RunJobs(jobs,
+            threadsCount,
+            [&](MapJob& job, bytes_t&)
+            {
+                MapPages(file.data() + job.offset,
+                         job.size,
+                         job.offset / page_size,
+                         regions.front().entropies,
+                         job.histogram);
+            });
+
+    MergeHistograms(jobs, regions);
+
+    return std::move(regions.front());
+}
+#endif
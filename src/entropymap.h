@@ -0,0 +1,71 @@
+#ifndef ASURA_ENTROPYMAP_H
+#define ASURA_ENTROPYMAP_H
+
+#include "process.h"
+
+namespace Asura
+{
+    /**
+     * Byte histograms and Shannon entropy of every page of a process or
+     * a file, to tell code and plain data from packed, encrypted or
+     * compressed regions without looking at them:
+     *
+     * for (const auto& region : EntropyMap::Map(process))
+     *     for (const auto entropy : region.entropies)
+     *         EntropyMap::ToBits(entropy) > 7.5 -> probably random
+     *
+     * Each page gets its entropy on a byte, a GB of memory maps to 256KB.
+     * Areas are cut in chunks read on every core. Bytes are counted into
+     * 4 tables, runs of the same byte would make every increment wait
+     * for the store of the previous one in a single table; zero pages,
+     * the most common ones, skip the counting.
+     */
+    class EntropyMap
+    {
+      public:
+        static constexpr std::size_t CHUNK_SIZE = 0x40000;
+        /* 8 bits per byte */
+        static constexpr std::uint8_t MAX_ENTROPY = 254;
+        /* Pages that couldn't be read */
+        static constexpr std::uint8_t UNREADABLE = 255;
+
+        using histogram_t = std::array<std::uint64_t, 256>;
+
+        struct Region
+        {
+            /* 0 for files */
+            std::uintptr_t address;
+            std::size_t size;
+            /* Area name, or the path of the file */
+            std::string name;
+            /* One per page, from 0 to MAX_ENTROPY, or UNREADABLE */
+            std::vector<std::uint8_t> entropies;
+            /* Of the pages that could be read */
+            histogram_t histogram;
+        };
+
+      public:
+        /* Adds the bytes of data to histogram */
+        static auto Histogram(const byte_t* data,
+                              const std::size_t size,
+                              histogram_t& histogram) -> void;
+        /* In bits per byte, from 0 to 8 */
+        static auto Entropy(const histogram_t& histogram) -> double;
+        static auto ToBits(const std::uint8_t entropy) -> double;
+
+        /**
+         * Every readable area in address order, threadsCount at 0 uses
+         * every core.
+         */
+        static auto Map(const Process& process,
+                        const std::size_t threadsCount = 0)
+          -> std::vector<Region>;
+
+#ifndef WINDOWS
+        static auto MapFile(const std::string& path,
+                            const std::size_t threadsCount = 0) -> Region;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "pch.h"
+
+#include "expected.h"
+
+using namespace Asura;
+
+auto Asura::ErrorCodeStr(const ErrorCode errorCode) -> const char*
+{
+    switch (errorCode)
+    {
+        case ErrorCode::NONE:
+            return "none";
+        case ErrorCode::BAD_ADDRESS:
+            return "bad address";
+        case ErrorCode::PARTIAL_TRANSFER:
+            return "partial transfer";
+        case ErrorCode::PERMISSION_DENIED:
+            return "permission denied";
+        case ErrorCode::NO_SUCH_PROCESS:
+            return "no such process";
+        case ErrorCode::INVALID_ARGUMENT:
+            return "invalid argument";
+        default:
+            return "unknown";
+    }
+}
+
+auto Asura::ErrorCodeFromOS(const int osError) -> ErrorCode
+{
+    switch (osError)
+    {
+#ifndef WINDOWS
+        case 0:
+            return ErrorCode::NONE;
+        /* mprotect & co report unmapped pages with ENOMEM */
+        case EFAULT:
+        case ENOMEM:
+            return ErrorCode::BAD_ADDRESS;
+        case EPERM:
+        case EACCES:
+            return ErrorCode::PERMISSION_DENIED;
+        case ESRCH:
+            return ErrorCode::NO_SUCH_PROCESS;
+        case EINVAL:
+            return ErrorCode::INVALID_ARGUMENT;
+#else
+        case ERROR_SUCCESS:
+            return ErrorCode::NONE;
+        case ERROR_PARTIAL_COPY:
+            return ErrorCode::PARTIAL_TRANSFER;
+        case ERROR_NOACCESS:
+        case ERROR_INVALID_ADDRESS:
+            return ErrorCode::BAD_ADDRESS;
+        case ERROR_ACCESS_DENIED:
+            return ErrorCode::PERMISSION_DENIED;
+        case ERROR_INVALID_PARAMETER:
+            return ErrorCode::INVALID_ARGUMENT;
+#endif
+        default:
+            return ErrorCode::UNKNOWN;
+    }
+}
+
+auto Asura::LastErrorCode() -> ErrorCode
+{
+#ifndef WINDOWS
+    return ErrorCodeFromOS(errno);
+#else
+    return ErrorCodeFromOS(view_as<int>(GetLastError()));
+#endif
+}
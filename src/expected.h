@@ -0,0 +1,206 @@
+#ifndef ASURA_EXPECTED_H
+#define ASURA_EXPECTED_H
+
+#include "exception.h"
+
+namespace Asura
+{
+    /**
+     * Why an operation failed. Returning one costs nothing, the message
+     * is only built when someone asks for it.
+     */
+    enum class ErrorCode : std::int32_t
+    {
+        NONE,
+        BAD_ADDRESS,
+        PARTIAL_TRANSFER,
+        PERMISSION_DENIED,
+        NO_SUCH_PROCESS,
+        INVALID_ARGUMENT,
+        UNKNOWN
+    };
+
+    auto ErrorCodeStr(const ErrorCode errorCode) -> const char*;
+    /* errno on Linux, GetLastError() on Windows */
+    auto ErrorCodeFromOS(const int osError) -> ErrorCode;
+    auto LastErrorCode() -> ErrorCode;
+
+    template <typename E>
+    class Unexpected
+    {
+      public:
+        constexpr explicit Unexpected(E error)
+         : _error(std::move(error))
+        {
+        }
+
+        constexpr auto error() const -> const E&
+        {
+            return _error;
+        }
+
+      private:
+        E _error;
+    };
+
+    /**
+     * The part of C++23 std::expected we need, our compilers don't ship
+     * it yet. Same names so it can be swapped later on.
+     */
+    template <typename T, typename E = ErrorCode>
+    class Expected
+    {
+      public:
+        constexpr Expected()
+          requires std::default_initializable<T>
+         : _storage(std::in_place_index<0>)
+        {
+        }
+
+        constexpr Expected(T value)
+         : _storage(std::in_place_index<0>, std::move(value))
+        {
+        }
+
+        constexpr Expected(Unexpected<E> unexpected)
+         : _storage(std::in_place_index<1>, unexpected.error())
+        {
+        }
+
+      public:
+        constexpr auto has_value() const -> bool
+        {
+            return _storage.index() == 0;
+        }
+
+        constexpr explicit operator bool() const
+        {
+            return has_value();
+        }
+
+        constexpr auto error() const -> const E&
+        {
+            return std::get<1>(_storage);
+        }
+
+        constexpr auto value() const& -> const T&
+        {
+            throwIfError();
+            return std::get<0>(_storage);
+        }
+
+        constexpr auto value() & -> T&
+        {
+            throwIfError();
+            return std::get<0>(_storage);
+        }
+
+        constexpr auto value() && -> T&&
+        {
+            throwIfError();
+            return std::move(std::get<0>(_storage));
+        }
+
+        constexpr auto value_or(T defaultValue) const -> T
+        {
+            return has_value() ? std::get<0>(_storage) :
+                                 std::move(defaultValue);
+        }
+
+        constexpr auto operator*() const& -> const T&
+        {
+            return *std::get_if<0>(&_storage);
+        }
+
+        constexpr auto operator*() & -> T&
+        {
+            return *std::get_if<0>(&_storage);
+        }
+
+        constexpr auto operator->() const -> const T*
+        {
+            return std::get_if<0>(&_storage);
+        }
+
+        constexpr auto operator->() -> T*
+        {
+            return std::get_if<0>(&_storage);
+        }
+
+      private:
+        constexpr auto throwIfError() const -> void
+        {
+            if (has_value())
+            {
+                return;
+            }
+
+            if constexpr (std::is_same_v<E, ErrorCode>)
+            {
+                ASURA_EXCEPTION(std::string("Expected has no value: ")
+                                + ErrorCodeStr(error()));
+            }
+            else
+            {
+                ASURA_EXCEPTION("Expected has no value");
+            }
+        }
+
+      private:
+        /* Indexed, T and E could be the same type */
+        std::variant<T, E> _storage;
+    };
+
+    template <typename E>
+    class Expected<void, E>
+    {
+      public:
+        constexpr Expected() = default;
+
+        constexpr Expected(Unexpected<E> unexpected)
+         : _has_value(false),
+           _error(unexpected.error())
+        {
+        }
+
+      public:
+        constexpr auto has_value() const -> bool
+        {
+            return _has_value;
+        }
+
+        constexpr explicit operator bool() const
+        {
+            return has_value();
+        }
+
+        constexpr auto error() const -> const E&
+        {
+            return _error;
+        }
+
+        constexpr auto value() const -> void
+        {
+            if (has_value())
+            {
+                return;
+            }
+
+            if constexpr (std::is_same_v<E, ErrorCode>)
+            {
+                ASURA_EXCEPTION(std::string("Expected has no value: ")
+                                + ErrorCodeStr(error()));
+            }
+            else
+            {
+                ASURA_EXCEPTION("Expected has no value");
+            }
+        }
+
+      private:
+        bool _has_value = true;
+        E _error {};
+    };
+}
+
+#endif
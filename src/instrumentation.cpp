@@ -0,0 +1,181 @@
+#include "pch.h"
+
+#include "instrumentation.h"
+
+using namespace Asura;
+
+/* Locked when registering and reading only, never by the hooks */
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<Instrumentation::Probe*> probes;
+};
+
+/* Probes can be static too, it must exist before the first one */
+static auto GetRegistry() -> Registry&
+{
+    static Registry registry;
+    return registry;
+}
+
+/* Slots of the exited threads are handed out first */
+struct Slots
+{
+    std::mutex mutex;
+    std::size_t next {};
+    std::vector<std::size_t> free;
+};
+
+static auto GetSlots() -> Slots&
+{
+    static Slots slots;
+    return slots;
+}
+
+Instrumentation::SlotOwner::SlotOwner()
+{
+    auto&& slots = GetSlots();
+
+    std::scoped_lock lock(slots.mutex);
+
+    if (not slots.free.empty())
+    {
+        slot = slots.free.back();
+        slots.free.pop_back();
+    }
+    else if (slots.next < MAX_THREADS)
+    {
+        slot = slots.next++;
+    }
+    else
+    {
+        slot = MAX_THREADS;
+    }
+}
+
+Instrumentation::SlotOwner::~SlotOwner()
+{
+    if (slot == MAX_THREADS)
+    {
+        return;
+    }
+
+    auto&& slots = GetSlots();
+
+    /* The lock orders our last counts before the next owner's */
+    std::scoped_lock lock(slots.mutex);
+    slots.free.push_back(slot);
+}
+
+Instrumentation::Probe::Probe(const std::string& name, const bool timed)
+ : _name(name),
+   _timed(timed),
+   _counters(std::make_unique<Counter[]>(MAX_THREADS + 1)),
+   _baselines(std::make_unique<Baseline[]>(MAX_THREADS + 1))
+{
+    auto&& registry = GetRegistry();
+
+    std::scoped_lock lock(registry.mutex);
+    registry.probes.push_back(this);
+}
+
+Instrumentation::Probe::~Probe()
+{
+    auto&& registry = GetRegistry();
+
+    std::scoped_lock lock(registry.mutex);
+    registry.probes.erase(std::find(registry.probes.begin(),
+                                    registry.probes.end(),
+                                    this));
+}
+
+auto Instrumentation::Probe::name() const -> const std::string&
+{
+    return _name;
+}
+
+auto Instrumentation::Probe::timed() const -> bool
+{
+    return _timed;
+}
+
+auto Instrumentation::Probe::original() const -> ptr_t
+{
+    return _original.load(std::memory_order_relaxed);
+}
+
+auto Instrumentation::Probe::setOriginal(const ptr_t original) -> void
+{
+    _original.store(original, std::memory_order_relaxed);
+}
+
+auto Instrumentation::Probe::read() const -> Stats
+{
+    Stats stats { _name, 0, 0, 0 };
+
+    for (std::size_t i = 0; i <= MAX_THREADS; i++)
+    {
+        const auto calls = _counters[i].calls.load(
+                             std::memory_order_relaxed)
+                           - _baselines[i].calls;
+
+        stats.calls   += calls;
+        stats.cycles  += _counters[i].cycles.load(
+                          std::memory_order_relaxed)
+                        - _baselines[i].cycles;
+        stats.threads += calls != 0;
+    }
+
+    return stats;
+}
+
+auto Instrumentation::Probe::reset() -> void
+{
+    for (std::size_t i = 0; i <= MAX_THREADS; i++)
+    {
+        _baselines[i].calls  = _counters[i].calls.load(
+          std::memory_order_relaxed);
+        _baselines[i].cycles = _counters[i].cycles.load(
+          std::memory_order_relaxed);
+    }
+}
+
+auto Instrumentation::TimestampsPerSecond() -> std::uint64_t
+{
+    static const auto timestamps_per_second = []()
+    {
+        constexpr std::chrono::milliseconds duration { 20 };
+
+        const auto start_time = std::chrono::steady_clock::now();
+        const auto start      = Timestamp();
+
+        std::this_thread::sleep_for(duration);
+
+        const auto elapsed = std::chrono::duration_cast<
+          std::chrono::nanoseconds>(std::chrono::steady_clock::now()
+                                    - start_time);
+
+        return view_as<std::uint64_t>(
+          view_as<long double>(Timestamp() - start) * 1'000'000'000
+          / view_as<long double>(elapsed.count()));
+    }();
+
+    return timestamps_per_second;
+}
+
+auto Instrumentation::Read() -> std::vector<Stats>
+{
+    auto&& registry = GetRegistry();
+
+    std::scoped_lock lock(registry.mutex);
+
+    std::vector<Stats> result;
+    result.reserve(registry.probes.size());
+
+    for (const auto probe : registry.probes)
+    {
+        result.push_back(probe->read());
+    }
+
+    return result;
+}
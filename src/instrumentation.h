@@ -0,0 +1,216 @@
+#ifndef ASURA_INSTRUMENTATION_H
+#define ASURA_INSTRUMENTATION_H
+
+#include "detourx86.h"
+
+namespace Asura
+{
+    /**
+     * Counts the calls of hooked functions and the TSC cycles they
+     * take:
+     *
+     * static Instrumentation::Probe update_probe("Update");
+     * Instrumentation::HookCall<update_probe, int, float>(call_site);
+     * ...
+     * for (auto&& stats : Instrumentation::Read())
+     *     stats.name, stats.calls, stats.cycles / stats.calls
+     *
+     * Hook is a plain function calling the original one, it can be the
+     * new function of a detour as well. Every thread has its own
+     * counters in each probe, on their own cache line, only that thread
+     * writes them, so a call costs two increments and two rdtsc, no
+     * lock, no atomic read-modify-write and no allocation. Reading sums
+     * the counters of every thread, while the hooks keep running.
+     * A thread gives its counters back when it exits, the next thread
+     * carries on from their counts. Past MAX_THREADS threads alive at
+     * once, the others share one more counter with atomic increments.
+     */
+    class Instrumentation
+    {
+      public:
+        static constexpr std::size_t CACHE_LINE_SIZE = 64;
+        static constexpr std::size_t MAX_THREADS     = 256;
+
+        struct Stats
+        {
+            std::string name;
+            std::uint64_t calls;
+            /* 0 when the probe isn't timed */
+            std::uint64_t cycles;
+            /**
+             * That called it at least once, a thread reusing the
+             * counters of an exited one isn't counted again.
+             */
+            std::size_t threads;
+        };
+
+        class Probe
+        {
+          public:
+            explicit Probe(const std::string& name, const bool timed = true);
+            ~Probe();
+
+            Probe(const Probe&)                    = delete;
+            auto operator=(const Probe&) -> Probe& = delete;
+
+          public:
+            auto name() const -> const std::string&;
+            auto timed() const -> bool;
+            auto original() const -> ptr_t;
+            auto setOriginal(const ptr_t original) -> void;
+
+          public:
+            inline auto record(const std::uint64_t cycles) -> void
+            {
+                const auto slot = ThreadSlot();
+
+                if (slot < MAX_THREADS) [[likely]]
+                {
+                    auto&& counter = _counters[slot];
+
+                    /* Only this thread writes, no need for a lock add */
+                    counter.calls.store(counter.calls.load(
+                                          std::memory_order_relaxed)
+                                          + 1,
+                                        std::memory_order_relaxed);
+                    counter.cycles.store(counter.cycles.load(
+                                           std::memory_order_relaxed)
+                                           + cycles,
+                                         std::memory_order_relaxed);
+                }
+                else
+                {
+                    _counters[MAX_THREADS].calls.fetch_add(
+                      1,
+                      std::memory_order_relaxed);
+                    _counters[MAX_THREADS].cycles.fetch_add(
+                      cycles,
+                      std::memory_order_relaxed);
+                }
+            }
+
+            /* Since the last reset */
+            auto read() const -> Stats;
+            /* Later reads start from the current counts */
+            auto reset() -> void;
+
+          private:
+            struct alignas(CACHE_LINE_SIZE) Counter
+            {
+                std::atomic<std::uint64_t> calls {};
+                std::atomic<std::uint64_t> cycles {};
+            };
+
+            /* Counts at the last reset, only touched by the readers */
+            struct Baseline
+            {
+                std::uint64_t calls {};
+                std::uint64_t cycles {};
+            };
+
+          private:
+            std::string _name;
+            bool _timed;
+            std::atomic<ptr_t> _original {};
+            /* One per thread, and the shared one */
+            std::unique_ptr<Counter[]> _counters;
+            std::unique_ptr<Baseline[]> _baselines;
+        };
+
+      public:
+        static inline auto Timestamp() -> std::uint64_t
+        {
+#if defined(__x86_64__) or defined(__i386__)
+            return __rdtsc();
+#else
+            return view_as<std::uint64_t>(
+              std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        /* Measured once, to turn cycles into time */
+        static auto TimestampsPerSecond() -> std::uint64_t;
+
+        /**
+         * Of the calling thread, given on its first call and taken back
+         * when it exits. MAX_THREADS for the shared counter.
+         */
+        static inline auto ThreadSlot() -> std::size_t
+        {
+            static thread_local const SlotOwner owner;
+            return owner.slot;
+        }
+
+        /* Every probe alive, in creation order */
+        static auto Read() -> std::vector<Stats>;
+
+      public:
+        template <Probe& P, typename T, typename... A>
+        static auto Hook(A... args) -> T
+        {
+            const auto original = view_as<T (*)(A...)>(
+              P.original());
+
+            if (not P.timed())
+            {
+                P.record(0);
+                return original(args...);
+            }
+
+            const auto start = Timestamp();
+
+            if constexpr (std::is_void<T>::value)
+            {
+                original(args...);
+                P.record(Timestamp() - start);
+            }
+            else
+            {
+                const auto result = original(args...);
+                P.record(Timestamp() - start);
+
+                return result;
+            }
+        }
+
+        /**
+         * Redirects the call rel32 at callSite to Hook, the function it
+         * was calling becomes the original of the probe.
+         * Hook follows the calling convention and nothing more, callers
+         * built assuming what registers the callee spares (gcc's
+         * -fipa-ra in the same unit) can't be hooked this way.
+         * Throws when Hook is more than 2 GiB away from callSite.
+         * beforeOverride and afterOverride replace the protection
+         * changes, like for X86_CALL::override_rel32.
+         */
+        template <Probe& P, typename T, typename... A>
+        static auto HookCall(
+          const ptr_t callSite,
+          const std::function<void(ptr_t, T (*)(A...))> beforeOverride
+          = nullptr,
+          const std::function<void(ptr_t, T (*)(A...))> afterOverride
+          = nullptr) -> void
+        {
+            P.setOriginal(view_as<ptr_t>(
+              X86_CALL::override_rel32(callSite,
+                                       &Hook<P, T, A...>,
+                                       beforeOverride,
+                                       afterOverride)));
+        }
+
+      private:
+        /* Holds a slot for the lifetime of its thread */
+        struct SlotOwner
+        {
+            SlotOwner();
+            ~SlotOwner();
+
+            SlotOwner(const SlotOwner&)                    = delete;
+            auto operator=(const SlotOwner&) -> SlotOwner& = delete;
+
+            std::size_t slot;
+        };
+    };
+}
+
+#endif
@@ -32,5 +32,5 @@ auto main() -> int
         task.freeStack();
     */
 
-    return 0;
+    return Asura::g_PassedTests ? 0 : 1;
 }
@@ -0,0 +1,64 @@
+#include "pch.h"
+
+#include "exception.h"
+#include "mappedfile.h"
+
+using namespace Asura;
+
+#ifndef WINDOWS
+MappedFile::MappedFile(const std::string& path,
+                       const std::uint64_t device,
+                       const std::uint64_t inode)
+{
+    const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        ASURA_EXCEPTION("Couldn't open " + path);
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) < 0 or file_stat.st_dev != device
+        or file_stat.st_ino != inode)
+    {
+        close(fd);
+        ASURA_EXCEPTION(path + " isn't the file that got mapped");
+    }
+
+    _size = view_as<std::size_t>(file_stat.st_size);
+
+    if (_size > 0)
+    {
+        const auto data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            ASURA_EXCEPTION("Couldn't map " + path);
+        }
+
+        _data = view_as<const byte_t*>(data);
+    }
+
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data)
+    {
+        munmap(view_as<void*>(_data), _size);
+    }
+}
+
+auto MappedFile::data() const -> const byte_t*
+{
+    return _data;
+}
+
+auto MappedFile::size() const -> std::size_t
+{
+    return _size;
+}
+#endif
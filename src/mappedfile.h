@@ -0,0 +1,36 @@
+#ifndef ASURA_MAPPEDFILE_H
+#define ASURA_MAPPEDFILE_H
+
+#include "types.h"
+
+#ifndef WINDOWS
+namespace Asura
+{
+    /**
+     * Read only mapping of a whole file, checked against the device and
+     * inode it should have, so it's the file a process mapped and not
+     * one that replaced it since.
+     */
+    class MappedFile
+    {
+      public:
+        MappedFile(const std::string& path,
+                   const std::uint64_t device,
+                   const std::uint64_t inode);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&)                    = delete;
+        auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+      public:
+        auto data() const -> const byte_t*;
+        auto size() const -> std::size_t;
+
+      private:
+        const byte_t* _data {};
+        std::size_t _size {};
+    };
+}
+#endif
+
+#endif
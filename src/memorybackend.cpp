@@ -0,0 +1,41 @@
+#include "pch.h"
+
+#include "memorybackend.h"
+
+using namespace Asura;
+
+static std::mutex attached_backends_mutex;
+static std::map<process_id_t, MemoryBackend*> attached_backends;
+static process_id_t next_process_id = MemoryBackend::FIRST_PROCESS_ID;
+
+std::atomic<std::size_t> MemoryBackend::_attached_count = 0;
+
+auto MemoryBackend::Attach(MemoryBackend* const backend) -> process_id_t
+{
+    const std::lock_guard lock(attached_backends_mutex);
+
+    const auto pid = next_process_id++;
+    attached_backends[pid] = backend;
+    _attached_count.store(attached_backends.size(),
+                          std::memory_order_release);
+
+    return pid;
+}
+
+auto MemoryBackend::Detach(const process_id_t pid) -> void
+{
+    const std::lock_guard lock(attached_backends_mutex);
+
+    attached_backends.erase(pid);
+    _attached_count.store(attached_backends.size(),
+                          std::memory_order_release);
+}
+
+auto MemoryBackend::FindAttached(const process_id_t pid) -> MemoryBackend*
+{
+    const std::lock_guard lock(attached_backends_mutex);
+
+    const auto it = attached_backends.find(pid);
+
+    return it == attached_backends.end() ? nullptr : it->second;
+}
@@ -0,0 +1,99 @@
+#ifndef ASURA_MEMORYBACKEND_H
+#define ASURA_MEMORYBACKEND_H
+
+#include "expected.h"
+#include "memoryarea.h"
+
+namespace Asura
+{
+    /**
+     * Something that isn't an OS process but can be used like one.
+     * A backend gets attached to a fake pid, every memory operation on
+     * that pid (MemoryUtils, ProcessMemoryMap, Process...) goes to the
+     * backend instead of the system.
+     * Fake pids are above any pid the kernel can give (PID_MAX_LIMIT),
+     * so real processes never pay more than a comparison.
+     */
+    class MemoryBackend
+    {
+      public:
+        static constexpr process_id_t FIRST_PROCESS_ID = 0x40000000;
+
+        /* One line of /proc/pid/maps */
+        struct AreaDescription
+        {
+            std::uintptr_t begin;
+            std::size_t size;
+            mapf_t flags;
+            std::uintptr_t offset;
+            std::uint64_t device;
+            std::uint64_t inode;
+            std::string name;
+        };
+
+      public:
+        static auto Attach(MemoryBackend* const backend) -> process_id_t;
+        static auto Detach(const process_id_t pid) -> void;
+
+        static inline auto Find(const process_id_t pid) -> MemoryBackend*
+        {
+            /* No lock as long as nothing is attached */
+            if (pid < FIRST_PROCESS_ID
+                or _attached_count.load(std::memory_order_acquire) == 0)
+            {
+                return nullptr;
+            }
+
+            return FindAttached(pid);
+        }
+
+      public:
+        virtual ~MemoryBackend() = default;
+
+      public:
+        virtual auto name() const -> std::string                  = 0;
+        virtual auto areas() const -> std::vector<AreaDescription> = 0;
+        virtual auto residentPages(const std::uintptr_t address,
+                                   const std::size_t size) const
+          -> std::vector<bool> = 0;
+        virtual auto tryRead(const std::uintptr_t address,
+                             const ptr_t buffer,
+                             const std::size_t size) const
+          -> Expected<void> = 0;
+        /**
+         * size bytes at each address, a failed address is zeroed and
+         * flagged as such in valids. Counts as a single call.
+         */
+        virtual auto tryReadBatch(
+          const std::vector<std::uintptr_t>& addresses,
+          const std::size_t size,
+          const data_t buffer,
+          std::vector<bool>& valids) const -> void = 0;
+
+      public:
+        virtual auto tryWrite(const std::uintptr_t address,
+                              const void* const buffer,
+                              const std::size_t size) -> Expected<void>
+          = 0;
+        virtual auto tryProtect(const std::uintptr_t address,
+                                const std::size_t size,
+                                const mapf_t flags) -> Expected<void>
+          = 0;
+        /* Any address when address is null */
+        virtual auto tryAlloc(const std::uintptr_t address,
+                              const std::size_t size,
+                              const mapf_t flags) -> Expected<ptr_t>
+          = 0;
+        virtual auto tryFree(const std::uintptr_t address,
+                             const std::size_t size) -> Expected<void>
+          = 0;
+
+      private:
+        static auto FindAttached(const process_id_t pid) -> MemoryBackend*;
+
+      private:
+        static std::atomic<std::size_t> _attached_count;
+    };
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include "pch.h"
+
+#include "memoryresource.h"
+
+using namespace Asura;
+
+/* Blocks start on a cache line, most allocations won't need padding */
+static constexpr std::size_t BLOCK_ALIGNMENT = 64;
+
+/* Memory resources only get power of two alignments */
+static constexpr auto AlignUp(const std::uintptr_t value,
+                              const std::size_t alignment) -> std::uintptr_t
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+thread_local std::pmr::memory_resource* MemoryResource::_current = nullptr;
+
+auto MemoryResource::current() -> std::pmr::memory_resource*
+{
+    return _current ? _current : std::pmr::get_default_resource();
+}
+
+auto MemoryResource::set(std::pmr::memory_resource* const resource)
+  -> std::pmr::memory_resource*
+{
+    const auto previous = _current;
+    _current            = resource;
+    return previous;
+}
+
+auto MemoryResource::threadPool() -> std::pmr::memory_resource*
+{
+    thread_local std::pmr::unsynchronized_pool_resource pool(
+      std::pmr::new_delete_resource());
+
+    return &pool;
+}
+
+ScopedMemoryResource::ScopedMemoryResource(
+  std::pmr::memory_resource* const resource)
+ : _previous(MemoryResource::set(resource))
+{
+}
+
+ScopedMemoryResource::~ScopedMemoryResource()
+{
+    MemoryResource::set(_previous);
+}
+
+MonotonicArena::MonotonicArena(const std::size_t blockSize,
+                               std::pmr::memory_resource* upstream)
+ : _block_size(std::max(blockSize, BLOCK_ALIGNMENT)),
+   _upstream(upstream)
+{
+}
+
+MonotonicArena::~MonotonicArena()
+{
+    release();
+}
+
+auto MonotonicArena::used() const -> std::size_t
+{
+    return _used;
+}
+
+auto MonotonicArena::capacity() const -> std::size_t
+{
+    std::size_t result = 0;
+
+    for (const auto& block : _blocks)
+    {
+        result += block.size;
+    }
+
+    return result;
+}
+
+auto MonotonicArena::reset() -> void
+{
+    /* Merge the blocks so the next frame fits in a single one */
+    if (_blocks.size() > 1)
+    {
+        const auto total_size = capacity();
+
+        release();
+
+        _blocks.push_back(
+          { view_as<data_t>(
+              _upstream->allocate(total_size, BLOCK_ALIGNMENT)),
+            total_size });
+    }
+
+    _current_block  = 0;
+    _current_offset = 0;
+    _used           = 0;
+}
+
+auto MonotonicArena::release() -> void
+{
+    for (const auto& block : _blocks)
+    {
+        _upstream->deallocate(block.data, block.size, BLOCK_ALIGNMENT);
+    }
+
+    _blocks.clear();
+    _current_block  = 0;
+    _current_offset = 0;
+    _used           = 0;
+}
+
+auto MonotonicArena::do_allocate(std::size_t bytes,
+                                 std::size_t alignment) -> void*
+{
+    /* Try the current block, then the ones kept from the last frames */
+    while (_current_block < _blocks.size())
+    {
+        const auto& block  = _blocks[_current_block];
+        const auto address = view_as<std::uintptr_t>(block.data)
+                             + _current_offset;
+        const auto padding = AlignUp(address, alignment) - address;
+
+        if (_current_offset + padding + bytes <= block.size)
+        {
+            _current_offset += padding + bytes;
+            _used += bytes;
+            return view_as<ptr_t>(address + padding);
+        }
+
+        _current_block++;
+        _current_offset = 0;
+    }
+
+    /* Grow geometrically so big frames don't end up with many blocks */
+    const auto block_size = AlignUp(
+      std::max({ _block_size,
+                 bytes + alignment,
+                 _blocks.empty() ? 0 : _blocks.back().size * 2 }),
+      BLOCK_ALIGNMENT);
+
+    _blocks.push_back(
+      { view_as<data_t>(_upstream->allocate(block_size, BLOCK_ALIGNMENT)),
+        block_size });
+
+    _current_block  = _blocks.size() - 1;
+    _current_offset = 0;
+
+    return do_allocate(bytes, alignment);
+}
+
+auto MonotonicArena::do_deallocate(void* /* ptr */,
+                                   std::size_t /* bytes */,
+                                   std::size_t /* alignment */) -> void
+{
+}
+
+auto MonotonicArena::do_is_equal(
+  const std::pmr::memory_resource& other) const noexcept -> bool
+{
+    return this == &other;
+}
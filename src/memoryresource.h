@@ -0,0 +1,108 @@
+#ifndef ASURA_MEMORYRESOURCE_H
+#define ASURA_MEMORYRESOURCE_H
+
+#include "types.h"
+
+namespace Asura
+{
+    /**
+     * Where the library takes its scratch memory from (scanning buffers,
+     * reads that don't outlive a call...).
+     * It's per thread, so a caller can pin all the work of a frame to an
+     * arena and reset it at the end of the frame. Anything allocated
+     * while an arena is current must be gone before the arena is reset,
+     * which is why state that lives longer, like memory maps or codec
+     * trees, never comes from it.
+     */
+    class MemoryResource
+    {
+      public:
+        /* Defaults to std::pmr::get_default_resource() */
+        static auto current() -> std::pmr::memory_resource*;
+        /* Returns the previous one */
+        static auto set(std::pmr::memory_resource* const resource)
+          -> std::pmr::memory_resource*;
+        /**
+         * Size class pool of the calling thread, allocating from it
+         * never takes a lock. Memory must be given back by the thread
+         * that allocated it.
+         */
+        static auto threadPool() -> std::pmr::memory_resource*;
+
+      private:
+        static thread_local std::pmr::memory_resource* _current;
+    };
+
+    class ScopedMemoryResource
+    {
+      public:
+        explicit ScopedMemoryResource(
+          std::pmr::memory_resource* const resource);
+        ~ScopedMemoryResource();
+
+        ScopedMemoryResource(const ScopedMemoryResource&) = delete;
+        auto operator=(const ScopedMemoryResource&)
+          -> ScopedMemoryResource& = delete;
+
+      private:
+        std::pmr::memory_resource* _previous;
+    };
+
+    /**
+     * Bump allocator, deallocating does nothing and everything is given
+     * back at once with reset().
+     * Blocks are kept across resets and merged into a single one, so an
+     * arena reset every frame stops allocating once it has grown to the
+     * size of a frame.
+     */
+    class MonotonicArena : public std::pmr::memory_resource
+    {
+      public:
+        static constexpr std::size_t DEFAULT_BLOCK_SIZE = 0x10000;
+
+      public:
+        explicit MonotonicArena(
+          const std::size_t blockSize          = DEFAULT_BLOCK_SIZE,
+          std::pmr::memory_resource* upstream = std::pmr::
+            new_delete_resource());
+        ~MonotonicArena() override;
+
+        MonotonicArena(const MonotonicArena&) = delete;
+        auto operator=(const MonotonicArena&) -> MonotonicArena& = delete;
+
+      public:
+        auto used() const -> std::size_t;
+        auto capacity() const -> std::size_t;
+
+      public:
+        auto reset() -> void;
+        /* Gives every block back to the upstream resource */
+        auto release() -> void;
+
+      private:
+        struct Block
+        {
+            data_t data;
+            std::size_t size;
+        };
+
+      private:
+        auto do_allocate(std::size_t bytes, std::size_t alignment)
+          -> void* override;
+        auto do_deallocate(void* ptr,
+                           std::size_t bytes,
+                           std::size_t alignment) -> void override;
+        auto do_is_equal(const std::pmr::memory_resource& other) const
+          noexcept -> bool override;
+
+      private:
+        std::vector<Block> _blocks;
+        std::size_t _current_block {};
+        std::size_t _current_offset {};
+        std::size_t _used {};
+        std::size_t _block_size;
+        std::pmr::memory_resource* _upstream;
+    };
+}
+
+#endif
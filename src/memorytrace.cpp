@@ -0,0 +1,1043 @@
+#include "pch.h"
+
+#include "memorytrace.h"
+#include "memoryutils.h"
+#include "processmemorymap.h"
+
+using namespace Asura;
+
+using Event = MemoryTrace::Event;
+
+/* Nothing yet, room for compressed contents and such */
+static constexpr std::uint64_t TRACE_FLAGS = 0;
+
+class TraceWriter
+{
+  public:
+    explicit TraceWriter(bytes_t& bytes)
+     : _bytes(bytes)
+    {
+    }
+
+    auto number(std::uint64_t value) -> void
+    {
+        while (value >= 0x80)
+        {
+            _bytes.push_back(view_as<byte_t>(value | 0x80));
+            value >>= 7;
+        }
+
+        _bytes.push_back(view_as<byte_t>(value));
+    }
+
+    /* Zigzag encoded difference with the previous address */
+    auto address(const std::uintptr_t value) -> void
+    {
+        const auto delta = view_as<std::int64_t>(value - _previous_address);
+
+        number((view_as<std::uint64_t>(delta) << 1)
+               ^ view_as<std::uint64_t>(delta >> 63));
+
+        _previous_address = value;
+    }
+
+    auto data(const void* const buffer, const std::size_t size) -> void
+    {
+        const auto bytes = view_as<const byte_t*>(buffer);
+        _bytes.insert(_bytes.end(), bytes, bytes + size);
+    }
+
+    auto string(const std::string& value) -> void
+    {
+        number(value.size());
+        data(value.data(), value.size());
+    }
+
+    auto bits(const std::vector<bool>& values) -> void
+    {
+        number(values.size());
+
+        for (std::size_t i = 0; i < values.size(); i += CHAR_BIT)
+        {
+            byte_t packed = 0;
+
+            for (std::size_t bit = 0;
+                 bit < CHAR_BIT and i + bit < values.size();
+                 bit++)
+            {
+                packed |= view_as<byte_t>(values[i + bit] << bit);
+            }
+
+            _bytes.push_back(packed);
+        }
+    }
+
+  private:
+    bytes_t& _bytes;
+    std::uintptr_t _previous_address {};
+};
+
+class TraceReader
+{
+  public:
+    explicit TraceReader(const bytes_t& bytes)
+     : _bytes(bytes)
+    {
+    }
+
+    auto finished() const -> bool
+    {
+        return _cursor == _bytes.size();
+    }
+
+    auto byte() -> byte_t
+    {
+        require(1);
+        return _bytes[_cursor++];
+    }
+
+    auto number() -> std::uint64_t
+    {
+        std::uint64_t value = 0;
+
+        for (std::size_t shift = 0; shift < 64; shift += 7)
+        {
+            const auto current = byte();
+
+            value |= view_as<std::uint64_t>(current & 0x7F) << shift;
+
+            if (not(current & 0x80))
+            {
+                return value;
+            }
+        }
+
+        ASURA_EXCEPTION("Trace number is too long");
+    }
+
+    auto address() -> std::uintptr_t
+    {
+        const auto zigzag = number();
+        const auto delta  = view_as<std::int64_t>(zigzag >> 1)
+                           ^ -view_as<std::int64_t>(zigzag & 1);
+
+        _previous_address += view_as<std::uintptr_t>(delta);
+
+        return _previous_address;
+    }
+
+    auto data(const std::size_t size) -> bytes_t
+    {
+        require(size);
+
+        bytes_t result(_bytes.begin() + view_as<std::ptrdiff_t>(_cursor),
+                       _bytes.begin()
+                         + view_as<std::ptrdiff_t>(_cursor + size));
+        _cursor += size;
+
+        return result;
+    }
+
+    auto string() -> std::string
+    {
+        const auto bytes = data(number());
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    auto bits() -> std::vector<bool>
+    {
+        std::vector<bool> values(number());
+
+        for (std::size_t i = 0; i < values.size(); i += CHAR_BIT)
+        {
+            const auto packed = byte();
+
+            for (std::size_t bit = 0;
+                 bit < CHAR_BIT and i + bit < values.size();
+                 bit++)
+            {
+                values[i + bit] = (packed >> bit) & 1;
+            }
+        }
+
+        return values;
+    }
+
+  private:
+    auto require(const std::size_t size) const -> void
+    {
+        if (size > _bytes.size() - _cursor)
+        {
+            ASURA_EXCEPTION("Trace is truncated");
+        }
+    }
+
+  private:
+    const bytes_t& _bytes;
+    std::size_t _cursor {};
+    std::uintptr_t _previous_address {};
+};
+
+auto MemoryTrace::TypeStr(const Event::Type type) -> std::string
+{
+    switch (type)
+    {
+        case Event::AREAS:
+            return "areas";
+        case Event::RESIDENT_PAGES:
+            return "resident pages";
+        case Event::READ:
+            return "read";
+        case Event::READ_BATCH:
+            return "read batch";
+        case Event::WRITE:
+            return "write";
+        case Event::PROTECT:
+            return "protect";
+        case Event::ALLOC:
+            return "alloc";
+        case Event::FREE:
+            return "free";
+        default:
+            return "unknown";
+    }
+}
+
+auto MemoryTrace::encode() const -> bytes_t
+{
+    bytes_t result;
+    TraceWriter writer(result);
+
+    writer.data(&MAGIC, sizeof(MAGIC));
+    writer.number(VERSION);
+    writer.number(TRACE_FLAGS);
+    writer.string(process_name);
+
+    for (const auto& event : events)
+    {
+        writer.number(event.type);
+        writer.number(view_as<std::uint64_t>(event.duration.count()));
+        writer.number(view_as<std::uint32_t>(event.error));
+
+        switch (event.type)
+        {
+            case Event::AREAS:
+            {
+                writer.number(event.areas.size());
+
+                for (const auto& area : event.areas)
+                {
+                    writer.address(area.begin);
+                    writer.number(area.size);
+                    writer.number(area.flags);
+                    writer.number(area.offset);
+                    writer.number(area.device);
+                    writer.number(area.inode);
+                    writer.string(area.name);
+                }
+
+                break;
+            }
+            case Event::RESIDENT_PAGES:
+            {
+                writer.address(event.address);
+                writer.number(event.size);
+                writer.bits(event.valids);
+                break;
+            }
+            case Event::READ:
+            case Event::WRITE:
+            {
+                writer.address(event.address);
+                writer.number(event.size);
+                writer.number(event.has_contents);
+                writer.data(event.contents.data(), event.contents.size());
+                break;
+            }
+            case Event::READ_BATCH:
+            {
+                writer.number(event.size);
+                writer.number(event.addresses.size());
+
+                for (const auto address : event.addresses)
+                {
+                    writer.address(address);
+                }
+
+                writer.bits(event.valids);
+                writer.number(event.has_contents);
+                writer.data(event.contents.data(), event.contents.size());
+                break;
+            }
+            case Event::PROTECT:
+            case Event::ALLOC:
+            {
+                writer.address(event.address);
+                writer.number(event.size);
+                writer.number(event.flags);
+
+                if (event.type == Event::ALLOC)
+                {
+                    writer.address(event.result);
+                }
+
+                break;
+            }
+            case Event::FREE:
+            {
+                writer.address(event.address);
+                writer.number(event.size);
+                break;
+            }
+            default:
+            {
+                ASURA_EXCEPTION("Unknown trace event type");
+            }
+        }
+    }
+
+    return result;
+}
+
+auto MemoryTrace::Decode(const bytes_t& bytes) -> MemoryTrace
+{
+    TraceReader reader(bytes);
+    MemoryTrace trace;
+
+    std::uint32_t magic;
+    const auto magic_bytes = reader.data(sizeof(magic));
+    std::memcpy(&magic, magic_bytes.data(), sizeof(magic));
+
+    if (magic != MAGIC)
+    {
+        ASURA_EXCEPTION("Not a memory trace");
+    }
+
+    const auto version = reader.number();
+
+    if (version != VERSION)
+    {
+        ASURA_EXCEPTION("Unsupported memory trace version "
+                        + std::to_string(version));
+    }
+
+    reader.number();
+    trace.process_name = reader.string();
+
+    while (not reader.finished())
+    {
+        Event event {};
+
+        event.type = view_as<Event::Type>(reader.number());
+        event.duration = std::chrono::nanoseconds(reader.number());
+        event.error    = view_as<ErrorCode>(reader.number());
+
+        /* Contents are only there on success */
+        const auto read_contents = [&](const std::size_t size)
+        {
+            event.has_contents = reader.number();
+
+            if (event.has_contents and event.error == ErrorCode::NONE)
+            {
+                event.contents = reader.data(size);
+            }
+        };
+
+        switch (event.type)
+        {
+            case Event::AREAS:
+            {
+                event.areas.resize(reader.number());
+
+                for (auto& area : event.areas)
+                {
+                    area.begin  = reader.address();
+                    area.size   = reader.number();
+                    area.flags  = view_as<mapf_t>(reader.number());
+                    area.offset = reader.number();
+                    area.device = reader.number();
+                    area.inode  = reader.number();
+                    area.name   = reader.string();
+                }
+
+                break;
+            }
+            case Event::RESIDENT_PAGES:
+            {
+                event.address = reader.address();
+                event.size    = reader.number();
+                event.valids  = reader.bits();
+                break;
+            }
+            case Event::READ:
+            case Event::WRITE:
+            {
+                event.address = reader.address();
+                event.size    = reader.number();
+                read_contents(event.size);
+                break;
+            }
+            case Event::READ_BATCH:
+            {
+                event.size = reader.number();
+                event.addresses.resize(reader.number());
+
+                for (auto& address : event.addresses)
+                {
+                    address = reader.address();
+                }
+
+                event.valids = reader.bits();
+
+                /* Replaying indexes them with the addresses */
+                if (event.valids.size() != event.addresses.size())
+                {
+                    ASURA_EXCEPTION("Read batch event has "
+                                    + std::to_string(event.valids.size())
+                                    + " validity bits for "
+                                    + std::to_string(event.addresses.size())
+                                    + " addresses");
+                }
+
+                read_contents(event.size * event.addresses.size());
+                break;
+            }
+            case Event::PROTECT:
+            case Event::ALLOC:
+            {
+                event.address = reader.address();
+                event.size    = reader.number();
+                event.flags   = view_as<mapf_t>(reader.number());
+
+                if (event.type == Event::ALLOC)
+                {
+                    event.result = reader.address();
+                }
+
+                break;
+            }
+            case Event::FREE:
+            {
+                event.address = reader.address();
+                event.size    = reader.number();
+                break;
+            }
+            default:
+            {
+                ASURA_EXCEPTION("Unknown trace event type "
+                                + std::to_string(event.type));
+            }
+        }
+
+        trace.events.push_back(std::move(event));
+    }
+
+    return trace;
+}
+
+auto MemoryTrace::save(const std::string& path) const -> void
+{
+    std::ofstream file(path, std::ios::binary);
+
+    if (not file.is_open())
+    {
+        ASURA_EXCEPTION("Couldn't open " + path);
+    }
+
+    const auto bytes = encode();
+    file.write(view_as<const char*>(bytes.data()),
+               view_as<std::streamsize>(bytes.size()));
+}
+
+auto MemoryTrace::Load(const std::string& path) -> MemoryTrace
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (not file.is_open())
+    {
+        ASURA_EXCEPTION("Couldn't open " + path);
+    }
+
+    const bytes_t bytes((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+
+    return Decode(bytes);
+}
+
+MemoryRecorder::MemoryRecorder(const ProcessBase& target,
+                               const bool recordContents)
+ : _target(target.id()),
+   _record_contents(recordContents),
+   _pid(Attach(this))
+{
+    _trace.process_name = name();
+}
+
+MemoryRecorder::~MemoryRecorder()
+{
+    Detach(_pid);
+}
+
+auto MemoryRecorder::id() const -> process_id_t
+{
+    return _pid;
+}
+
+auto MemoryRecorder::process() const -> Process
+{
+    return Process(_pid);
+}
+
+auto MemoryRecorder::trace() const -> MemoryTrace
+{
+    const std::lock_guard lock(_mutex);
+
+    return _trace;
+}
+
+auto MemoryRecorder::clear() -> void
+{
+    const std::lock_guard lock(_mutex);
+
+    _trace.events.clear();
+}
+
+auto MemoryRecorder::name() const -> std::string
+{
+    return std::get<0>(Process::name(_target.id()));
+}
+
+auto MemoryRecorder::areas() const -> std::vector<AreaDescription>
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const ProcessMemoryMap memory_map(_target);
+    std::vector<AreaDescription> result;
+
+    for (const auto& area : memory_map.areas())
+    {
+        result.push_back({ area->begin(),
+                           area->size(),
+                           area->protectionFlags().cachedValue(),
+                           area->offset(),
+                           area->device(),
+                           area->inode(),
+                           area->name() });
+    }
+
+    record({ .type = Event::AREAS, .areas = result }, start);
+
+    return result;
+}
+
+auto MemoryRecorder::residentPages(const std::uintptr_t address,
+                                   const std::size_t size) const
+  -> std::vector<bool>
+{
+    const auto start  = std::chrono::steady_clock::now();
+    const auto result = MemoryUtils::ResidentPages(_target.id(),
+                                                   address,
+                                                   size);
+
+    record({ .type    = Event::RESIDENT_PAGES,
+             .address = address,
+             .size    = size,
+             .valids  = result },
+           start);
+
+    return result;
+}
+
+auto MemoryRecorder::tryRead(const std::uintptr_t address,
+                             const ptr_t buffer,
+                             const std::size_t size) const
+  -> Expected<void>
+{
+    const auto start  = std::chrono::steady_clock::now();
+    const auto result = MemoryUtils::TryReadProcessMemoryArea(_target.id(),
+                                                              address,
+                                                              buffer,
+                                                              size);
+
+    Event event { .type         = Event::READ,
+                  .error        = result ? ErrorCode::NONE : result.error(),
+                  .address      = address,
+                  .size         = size,
+                  .has_contents = _record_contents };
+
+    if (_record_contents and result)
+    {
+        event.contents.assign(view_as<data_t>(buffer),
+                              view_as<data_t>(buffer) + size);
+    }
+
+    record(std::move(event), start);
+
+    return result;
+}
+
+auto MemoryRecorder::tryReadBatch(
+  const std::vector<std::uintptr_t>& addresses,
+  const std::size_t size,
+  const data_t buffer,
+  std::vector<bool>& valids) const -> void
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    auto [bytes, result_valids] = MemoryUtils::ReadProcessMemoryAreas(
+      _target.id(),
+      addresses,
+      size);
+
+    std::memcpy(buffer, bytes.data(), bytes.size());
+    valids = result_valids;
+
+    Event event { .type         = Event::READ_BATCH,
+                  .size         = size,
+                  .addresses    = addresses,
+                  .valids       = std::move(result_valids),
+                  .has_contents = _record_contents };
+
+    if (_record_contents)
+    {
+        event.contents = std::move(bytes);
+    }
+
+    record(std::move(event), start);
+}
+
+auto MemoryRecorder::tryWrite(const std::uintptr_t address,
+                              const void* const buffer,
+                              const std::size_t size) -> Expected<void>
+{
+    const auto start  = std::chrono::steady_clock::now();
+    const auto result = MemoryUtils::TryWriteProcessMemoryArea(
+      _target.id(),
+      address,
+      buffer,
+      size);
+
+    Event event { .type         = Event::WRITE,
+                  .error        = result ? ErrorCode::NONE : result.error(),
+                  .address      = address,
+                  .size         = size,
+                  .has_contents = _record_contents };
+
+    if (_record_contents and result)
+    {
+        event.contents.assign(view_as<const byte_t*>(buffer),
+                              view_as<const byte_t*>(buffer) + size);
+    }
+
+    record(std::move(event), start);
+
+    return result;
+}
+
+auto MemoryRecorder::tryProtect(const std::uintptr_t address,
+                                const std::size_t size,
+                                const mapf_t flags) -> Expected<void>
+{
+    const auto start  = std::chrono::steady_clock::now();
+    const auto result = MemoryUtils::TryProtectMemoryArea(_target.id(),
+                                                          address,
+                                                          size,
+                                                          flags);
+
+    record({ .type    = Event::PROTECT,
+             .error   = result ? ErrorCode::NONE : result.error(),
+             .address = address,
+             .size    = size,
+             .flags   = flags },
+           start);
+
+    return result;
+}
+
+auto MemoryRecorder::tryAlloc(const std::uintptr_t address,
+                              const std::size_t size,
+                              const mapf_t flags) -> Expected<ptr_t>
+{
+    const auto start  = std::chrono::steady_clock::now();
+    const auto result = MemoryUtils::TryAllocArea(_target.id(),
+                                                  address,
+                                                  size,
+                                                  flags);
+
+    record({ .type    = Event::ALLOC,
+             .error   = result ? ErrorCode::NONE : result.error(),
+             .address = address,
+             .size    = size,
+             .flags   = flags,
+             .result  = result ? view_as<std::uintptr_t>(*result) : 0 },
+           start);
+
+    return result;
+}
+
+auto MemoryRecorder::tryFree(const std::uintptr_t address,
+                             const std::size_t size) -> Expected<void>
+{
+    const auto start  = std::chrono::steady_clock::now();
+    const auto result = MemoryUtils::TryFreeArea(_target.id(),
+                                                 address,
+                                                 size);
+
+    record({ .type    = Event::FREE,
+             .error   = result ? ErrorCode::NONE : result.error(),
+             .address = address,
+             .size    = size },
+           start);
+
+    return result;
+}
+
+auto MemoryRecorder::record(
+  MemoryTrace::Event event,
+  const std::chrono::steady_clock::time_point start) const -> void
+{
+    event.duration = std::chrono::steady_clock::now() - start;
+
+    const std::lock_guard lock(_mutex);
+
+    _trace.events.push_back(std::move(event));
+}
+
+MemoryReplayer::MemoryReplayer(MemoryTrace trace, const bool replayTiming)
+ : _trace(std::move(trace)),
+   _replay_timing(replayTiming),
+   _pid(Attach(this)),
+   _memory(_trace.process_name)
+{
+    prime();
+}
+
+MemoryReplayer::~MemoryReplayer()
+{
+    Detach(_pid);
+}
+
+auto MemoryReplayer::id() const -> process_id_t
+{
+    return _pid;
+}
+
+auto MemoryReplayer::process() const -> Process
+{
+    return Process(_pid);
+}
+
+auto MemoryReplayer::callsCount() const -> std::size_t
+{
+    const std::lock_guard lock(_mutex);
+
+    return _calls_count;
+}
+
+auto MemoryReplayer::matchedCount() const -> std::size_t
+{
+    const std::lock_guard lock(_mutex);
+
+    return _matched_count;
+}
+
+auto MemoryReplayer::finished() const -> bool
+{
+    const std::lock_guard lock(_mutex);
+
+    return _cursor == _trace.events.size();
+}
+
+auto MemoryReplayer::rewind() -> void
+{
+    const std::lock_guard lock(_mutex);
+
+    _cursor        = 0;
+    _calls_count   = 0;
+    _matched_count = 0;
+    _memory.setAreas({});
+    prime();
+}
+
+auto MemoryReplayer::name() const -> std::string
+{
+    return _trace.process_name;
+}
+
+auto MemoryReplayer::areas() const -> std::vector<AreaDescription>
+{
+    /* The event has been applied already, the memory has its areas */
+    next(Event::AREAS, 0, 0);
+
+    return _memory.areas();
+}
+
+auto MemoryReplayer::residentPages(const std::uintptr_t address,
+                                   const std::size_t size) const
+  -> std::vector<bool>
+{
+    if (const auto event = next(Event::RESIDENT_PAGES, address, size))
+    {
+        return event->valids;
+    }
+
+    return _memory.residentPages(address, size);
+}
+
+auto MemoryReplayer::tryRead(const std::uintptr_t address,
+                             const ptr_t buffer,
+                             const std::size_t size) const
+  -> Expected<void>
+{
+    if (const auto event = next(Event::READ, address, size))
+    {
+        if (event->error != ErrorCode::NONE)
+        {
+            return Unexpected(event->error);
+        }
+
+        _memory.forceRead(address, buffer, size);
+        return {};
+    }
+
+    return _memory.tryRead(address, buffer, size);
+}
+
+auto MemoryReplayer::tryReadBatch(
+  const std::vector<std::uintptr_t>& addresses,
+  const std::size_t size,
+  const data_t buffer,
+  std::vector<bool>& valids) const -> void
+{
+    const auto event = next(Event::READ_BATCH,
+                            addresses.empty() ? 0 : addresses.front(),
+                            size,
+                            addresses);
+
+    if (not event)
+    {
+        _memory.tryReadBatch(addresses, size, buffer, valids);
+        return;
+    }
+
+    for (std::size_t i = 0; i < addresses.size(); i++)
+    {
+        valids[i] = event->valids[i];
+
+        if (valids[i])
+        {
+            _memory.forceRead(addresses[i], &buffer[i * size], size);
+        }
+        else
+        {
+            std::memset(&buffer[i * size], 0, size);
+        }
+    }
+}
+
+auto MemoryReplayer::tryWrite(const std::uintptr_t address,
+                              const void* const buffer,
+                              const std::size_t size) -> Expected<void>
+{
+    if (const auto event = next(Event::WRITE, address, size))
+    {
+        if (event->error != ErrorCode::NONE)
+        {
+            return Unexpected(event->error);
+        }
+
+        _memory.forceWrite(address, buffer, size);
+        return {};
+    }
+
+    return _memory.tryWrite(address, buffer, size);
+}
+
+auto MemoryReplayer::tryProtect(const std::uintptr_t address,
+                                const std::size_t size,
+                                const mapf_t flags) -> Expected<void>
+{
+    if (const auto event = next(Event::PROTECT, address, size))
+    {
+        if (event->error != ErrorCode::NONE)
+        {
+            return Unexpected(event->error);
+        }
+
+        return {};
+    }
+
+    return _memory.tryProtect(address, size, flags);
+}
+
+auto MemoryReplayer::tryAlloc(const std::uintptr_t address,
+                              const std::size_t size,
+                              const mapf_t flags) -> Expected<ptr_t>
+{
+    if (const auto event = next(Event::ALLOC, address, size))
+    {
+        if (event->error != ErrorCode::NONE)
+        {
+            return Unexpected(event->error);
+        }
+
+        return view_as<ptr_t>(event->result);
+    }
+
+    return _memory.tryAlloc(address, size, flags);
+}
+
+auto MemoryReplayer::tryFree(const std::uintptr_t address,
+                             const std::size_t size) -> Expected<void>
+{
+    if (const auto event = next(Event::FREE, address, size))
+    {
+        if (event->error != ErrorCode::NONE)
+        {
+            return Unexpected(event->error);
+        }
+
+        return {};
+    }
+
+    return _memory.tryFree(address, size);
+}
+
+auto MemoryReplayer::next(const Event::Type type,
+                          const std::uintptr_t address,
+                          const std::size_t size,
+                          const std::vector<std::uintptr_t>& addresses) const
+  -> const Event*
+{
+    const Event* matched = nullptr;
+
+    {
+        const std::lock_guard lock(_mutex);
+
+        _calls_count++;
+
+        if (_cursor == _trace.events.size())
+        {
+            return nullptr;
+        }
+
+        const auto& event = _trace.events[_cursor++];
+
+        apply(event);
+
+        if (event.type == type and event.address == address
+            and event.size == size and event.addresses == addresses)
+        {
+            matched = &event;
+            _matched_count++;
+        }
+    }
+
+    /* Outside the lock, calls of other threads would overlap */
+    if (matched and _replay_timing)
+    {
+        const auto until = std::chrono::steady_clock::now()
+                           + matched->duration;
+
+        while (std::chrono::steady_clock::now() < until)
+        {
+        }
+    }
+
+    return matched;
+}
+
+auto MemoryReplayer::prime() const -> void
+{
+    /**
+     * Going backward, the earliest content of each byte ends up on top.
+     * Writes aren't used, their content comes from the workload itself.
+     */
+    for (auto it = _trace.events.rbegin(); it != _trace.events.rend(); it++)
+    {
+        if (it->type == Event::READ or it->type == Event::READ_BATCH)
+        {
+            apply(*it);
+        }
+    }
+
+    const auto first_areas = std::find_if(_trace.events.begin(),
+                                          _trace.events.end(),
+                                          [](const Event& event)
+                                          {
+                                              return event.type
+                                                     == Event::AREAS;
+                                          });
+
+    if (first_areas != _trace.events.end())
+    {
+        apply(*first_areas);
+    }
+}
+
+auto MemoryReplayer::apply(const Event& event) const -> void
+{
+    if (event.error != ErrorCode::NONE)
+    {
+        return;
+    }
+
+    switch (event.type)
+    {
+        case Event::AREAS:
+        {
+            _memory.setAreas(event.areas);
+            break;
+        }
+        case Event::READ:
+        case Event::WRITE:
+        {
+            if (event.has_contents)
+            {
+                _memory.forceWrite(event.address,
+                                   event.contents.data(),
+                                   event.contents.size());
+            }
+
+            break;
+        }
+        case Event::READ_BATCH:
+        {
+            if (not event.has_contents)
+            {
+                break;
+            }
+
+            for (std::size_t i = 0; i < event.addresses.size(); i++)
+            {
+                if (event.valids[i])
+                {
+                    _memory.forceWrite(event.addresses[i],
+                                       &event.contents[i * event.size],
+                                       event.size);
+                }
+            }
+
+            break;
+        }
+        case Event::PROTECT:
+        {
+            (void)_memory.tryProtect(event.address, event.size, event.flags);
+            break;
+        }
+        case Event::ALLOC:
+        {
+            (void)_memory.tryAlloc(event.result, event.size, event.flags);
+            break;
+        }
+        case Event::FREE:
+        {
+            (void)_memory.tryFree(event.address, event.size);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
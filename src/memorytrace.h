@@ -0,0 +1,234 @@
+#ifndef ASURA_MEMORYTRACE_H
+#define ASURA_MEMORYTRACE_H
+
+#include "memorybackend.h"
+#include "mockprocess.h"
+#include "processbase.h"
+
+namespace Asura
+{
+    /**
+     * Remote memory traffic of a process: reads, writes, maps refreshes
+     * and protection changes, with how long each of them took and
+     * optionally the bytes that went through.
+     *
+     * Saved as a compact binary file, numbers are LEB128 varints and
+     * addresses are stored as the difference with the previous one, so
+     * a scan going through memory costs a couple of bytes per call.
+     */
+    class MemoryTrace
+    {
+      public:
+        static constexpr std::uint32_t MAGIC   = 0x54525341; /* ASRT */
+        static constexpr std::uint32_t VERSION = 1;
+
+        struct Event
+        {
+            enum Type : byte_t
+            {
+                AREAS,
+                RESIDENT_PAGES,
+                READ,
+                READ_BATCH,
+                WRITE,
+                PROTECT,
+                ALLOC,
+                FREE,
+                MAX_TYPES
+            };
+
+            Type type {};
+            std::chrono::nanoseconds duration {};
+            ErrorCode error {};
+            std::uintptr_t address {};
+            std::size_t size {};
+            mapf_t flags {};
+            /* Allocated address */
+            std::uintptr_t result {};
+            std::vector<std::uintptr_t> addresses {};
+            /* Per address for READ_BATCH, per page for RESIDENT_PAGES */
+            std::vector<bool> valids {};
+            std::vector<MemoryBackend::AreaDescription> areas {};
+            bool has_contents {};
+            bytes_t contents {};
+        };
+
+      public:
+        static auto TypeStr(const Event::Type type) -> std::string;
+        static auto Decode(const bytes_t& bytes) -> MemoryTrace;
+        static auto Load(const std::string& path) -> MemoryTrace;
+
+      public:
+        std::string process_name;
+        std::vector<Event> events;
+
+      public:
+        auto encode() const -> bytes_t;
+        auto save(const std::string& path) const -> void;
+    };
+
+    /**
+     * Records everything done to a process through its own pid:
+     *
+     * MemoryRecorder recorder(Process::find("game"));
+     * const auto process = recorder.process();
+     * ... scan, read, write process as usual ...
+     * recorder.trace().save("game.trace");
+     *
+     * Works on real processes as well as on other backends.
+     */
+    class MemoryRecorder : public MemoryBackend
+    {
+      public:
+        explicit MemoryRecorder(const ProcessBase& target,
+                                const bool recordContents = true);
+        ~MemoryRecorder() override;
+
+        MemoryRecorder(const MemoryRecorder&)                    = delete;
+        auto operator=(const MemoryRecorder&) -> MemoryRecorder& = delete;
+
+      public:
+        auto id() const -> process_id_t;
+        auto process() const -> Process;
+        /* Copy, the recording can still go on from other threads */
+        auto trace() const -> MemoryTrace;
+
+      public:
+        auto name() const -> std::string override;
+        auto areas() const -> std::vector<AreaDescription> override;
+        auto residentPages(const std::uintptr_t address,
+                           const std::size_t size) const
+          -> std::vector<bool> override;
+        auto tryRead(const std::uintptr_t address,
+                     const ptr_t buffer,
+                     const std::size_t size) const
+          -> Expected<void> override;
+        auto tryReadBatch(const std::vector<std::uintptr_t>& addresses,
+                          const std::size_t size,
+                          const data_t buffer,
+                          std::vector<bool>& valids) const
+          -> void override;
+
+      public:
+        auto clear() -> void;
+
+      public:
+        auto tryWrite(const std::uintptr_t address,
+                      const void* const buffer,
+                      const std::size_t size) -> Expected<void> override;
+        auto tryProtect(const std::uintptr_t address,
+                        const std::size_t size,
+                        const mapf_t flags) -> Expected<void> override;
+        auto tryAlloc(const std::uintptr_t address,
+                      const std::size_t size,
+                      const mapf_t flags) -> Expected<ptr_t> override;
+        auto tryFree(const std::uintptr_t address, const std::size_t size)
+          -> Expected<void> override;
+
+      private:
+        auto record(MemoryTrace::Event event,
+                    const std::chrono::steady_clock::time_point start) const
+          -> void;
+
+      private:
+        ProcessBase _target;
+        bool _record_contents;
+        process_id_t _pid;
+        mutable std::mutex _mutex;
+        mutable MemoryTrace _trace;
+    };
+
+    /**
+     * Plays a trace back as a process, so new scanners or caches can be
+     * benchmarked against a real workload, deterministically:
+     *
+     * MemoryReplayer replayer(MemoryTrace::Load("game.trace"));
+     * const auto process = replayer.process();
+     *
+     * The n-th call applies the n-th event of the trace to the replayed
+     * memory. When the call is the same as the event, the recorded
+     * result is returned, otherwise it's served from the memory as it
+     * was at that point of the recording, so code that doesn't do the
+     * exact same calls still sees realistic contents. Memory that's
+     * only read later in the trace starts with its first recorded
+     * contents.
+     * With replayTiming, matched calls take as long as they did.
+     */
+    class MemoryReplayer : public MemoryBackend
+    {
+      public:
+        explicit MemoryReplayer(MemoryTrace trace,
+                                const bool replayTiming = false);
+        ~MemoryReplayer() override;
+
+        MemoryReplayer(const MemoryReplayer&)                    = delete;
+        auto operator=(const MemoryReplayer&) -> MemoryReplayer& = delete;
+
+      public:
+        auto id() const -> process_id_t;
+        auto process() const -> Process;
+        auto callsCount() const -> std::size_t;
+        /* Calls that were the same as their event */
+        auto matchedCount() const -> std::size_t;
+        auto finished() const -> bool;
+
+      public:
+        auto rewind() -> void;
+
+      public:
+        auto name() const -> std::string override;
+        auto areas() const -> std::vector<AreaDescription> override;
+        auto residentPages(const std::uintptr_t address,
+                           const std::size_t size) const
+          -> std::vector<bool> override;
+        auto tryRead(const std::uintptr_t address,
+                     const ptr_t buffer,
+                     const std::size_t size) const
+          -> Expected<void> override;
+        auto tryReadBatch(const std::vector<std::uintptr_t>& addresses,
+                          const std::size_t size,
+                          const data_t buffer,
+                          std::vector<bool>& valids) const
+          -> void override;
+
+      public:
+        auto tryWrite(const std::uintptr_t address,
+                      const void* const buffer,
+                      const std::size_t size) -> Expected<void> override;
+        auto tryProtect(const std::uintptr_t address,
+                        const std::size_t size,
+                        const mapf_t flags) -> Expected<void> override;
+        auto tryAlloc(const std::uintptr_t address,
+                      const std::size_t size,
+                      const mapf_t flags) -> Expected<ptr_t> override;
+        auto tryFree(const std::uintptr_t address, const std::size_t size)
+          -> Expected<void> override;
+
+      private:
+        /**
+         * Applies the next event to the memory, returns it when it's the
+         * same call, nullptr otherwise.
+         */
+        auto next(const MemoryTrace::Event::Type type,
+                  const std::uintptr_t address,
+                  const std::size_t size,
+                  const std::vector<std::uintptr_t>& addresses = {}) const
+          -> const MemoryTrace::Event*;
+        auto apply(const MemoryTrace::Event& event) const -> void;
+        /* Fills the memory with the first contents known of it */
+        auto prime() const -> void;
+
+      private:
+        MemoryTrace _trace;
+        bool _replay_timing;
+        process_id_t _pid;
+        mutable std::mutex _mutex;
+        mutable std::size_t _cursor {};
+        mutable std::size_t _calls_count {};
+        mutable std::size_t _matched_count {};
+        /* Memory as it was at _cursor */
+        mutable MockProcess _memory;
+    };
+}
+
+#endif
@@ -2,7 +2,9 @@
 #define ASURA_MEMORYUTILS_H
 
 #include "exception.h"
+#include "expected.h"
 #include "memoryarea.h"
+#include "memorybackend.h"
 #include "types.h"
 
 #include "custom_linux_syscalls.h"
@@ -34,16 +36,25 @@ namespace Asura
               * pageSize);
         }
 
-        static auto ProtectMemoryArea(const process_id_t pid,
-                                      const auto address,
-                                      const std::size_t size,
-                                      const mapf_t flags) -> void
+        static auto TryProtectMemoryArea(const process_id_t pid,
+                                         const auto address,
+                                         const std::size_t size,
+                                         const mapf_t flags)
+          -> Expected<void>
         {
             const auto aligned_address = Align<ptr_t>(
               view_as<ptr_t>(address),
               GetPageSize());
             const auto aligned_size = AlignToPageSize(size,
                                                       GetPageSize());
+
+            if (const auto backend = MemoryBackend::Find(pid))
+            {
+                return backend->tryProtect(
+                  view_as<std::uintptr_t>(aligned_address),
+                  aligned_size,
+                  flags);
+            }
 #ifdef WINDOWS
             const auto process_handle = GetCurrentProcessId() == pid ?
                                           GetCurrentProcess() :
@@ -54,7 +65,7 @@ namespace Asura
 
             if (process_handle == nullptr)
             {
-                ASURA_EXCEPTION("Couldn't open process");
+                return Unexpected(LastErrorCode());
             }
 
             DWORD dwOldFlags;
@@ -65,12 +76,14 @@ namespace Asura
               MemoryArea::ProtectionFlags::ToOS(flags),
               &dwOldFlags);
 
+            const auto error_code = LastErrorCode();
+
+            CloseHandle(process_handle);
+
             if (not ret)
             {
-                ASURA_EXCEPTION("VirtualProtectEx failed");
+                return Unexpected(error_code);
             }
-
-            CloseHandle(process_handle);
 #else
             const auto ret = syscall(
               __NR_rmprotect,
@@ -81,16 +94,42 @@ namespace Asura
 
             if (ret < 0)
             {
-                ASURA_EXCEPTION("System call rmprotect failed");
+                return Unexpected(LastErrorCode());
             }
 #endif
+
+            return {};
         }
 
-        static auto AllocArea(const process_id_t pid,
-                              const auto address,
-                              const std::size_t size,
-                              const mapf_t flags) -> ptr_t
+        static auto ProtectMemoryArea(const process_id_t pid,
+                                      const auto address,
+                                      const std::size_t size,
+                                      const mapf_t flags) -> void
         {
+            const auto result = TryProtectMemoryArea(pid,
+                                                     address,
+                                                     size,
+                                                     flags);
+
+            if (not result)
+            {
+                ASURA_EXCEPTION(std::string("Memory protection failed: ")
+                                + ErrorCodeStr(result.error()));
+            }
+        }
+
+        static auto TryAllocArea(const process_id_t pid,
+                                 const auto address,
+                                 const std::size_t size,
+                                 const mapf_t flags) -> Expected<ptr_t>
+        {
+            if (const auto backend = MemoryBackend::Find(pid))
+            {
+                return backend->tryAlloc(view_as<std::uintptr_t>(address),
+                                         size,
+                                         flags);
+            }
+
 #ifdef WINDOWS
             const auto process_handle = GetCurrentProcessId() == pid ?
                                           GetCurrentProcess() :
@@ -101,7 +140,7 @@ namespace Asura
 
             if (process_handle == nullptr)
             {
-                ASURA_EXCEPTION("Couldn't open process");
+                return Unexpected(LastErrorCode());
             }
 
             const auto ret = VirtualAllocEx(
@@ -111,7 +150,14 @@ namespace Asura
               MEM_COMMIT | MEM_RESERVE,
               MemoryArea::ProtectionFlags::ToOS(flags));
 
+            const auto error_code = LastErrorCode();
+
             CloseHandle(process_handle);
+
+            if (ret == nullptr)
+            {
+                return Unexpected(error_code);
+            }
 #else
             struct
             {
@@ -132,19 +178,47 @@ namespace Asura
                      0 };
 
             const auto ret = syscall(__NR_rmmap, &args, sizeof(args));
+
+            if (ret == -1)
+            {
+                return Unexpected(LastErrorCode());
+            }
 #endif
             return view_as<ptr_t>(ret);
         }
 
-        static auto FreeArea(const process_id_t pid,
-                             const auto address,
-                             const std::size_t size) -> void
+        static auto AllocArea(const process_id_t pid,
+                              const auto address,
+                              const std::size_t size,
+                              const mapf_t flags) -> ptr_t
+        {
+            const auto result = TryAllocArea(pid, address, size, flags);
+
+            if (not result)
+            {
+                ASURA_EXCEPTION(std::string("Allocation failed: ")
+                                + ErrorCodeStr(result.error()));
+            }
+
+            return *result;
+        }
+
+        static auto TryFreeArea(const process_id_t pid,
+                                const auto address,
+                                const std::size_t size) -> Expected<void>
         {
             const auto aligned_address = Align<ptr_t>(
               view_as<ptr_t>(address),
               GetPageSize());
             const auto aligned_size = AlignToPageSize(size,
                                                       GetPageSize());
+
+            if (const auto backend = MemoryBackend::Find(pid))
+            {
+                return backend->tryFree(
+                  view_as<std::uintptr_t>(aligned_address),
+                  aligned_size);
+            }
 #ifdef WINDOWS
             const auto process_handle = GetCurrentProcessId() == pid ?
                                           GetCurrentProcess() :
@@ -155,7 +229,7 @@ namespace Asura
 
             if (process_handle == nullptr)
             {
-                ASURA_EXCEPTION("Couldn't open process");
+                return Unexpected(LastErrorCode());
             }
 
             const auto ret = VirtualFreeEx(process_handle,
@@ -163,12 +237,14 @@ namespace Asura
                                            aligned_size,
                                            MEM_RELEASE);
 
+            const auto error_code = LastErrorCode();
+
+            CloseHandle(process_handle);
+
             if (not ret)
             {
-                ASURA_EXCEPTION("VirtualFreeEx failed");
+                return Unexpected(error_code);
             }
-
-            CloseHandle(process_handle);
 #else
             const auto ret = syscall(__NR_rmunmap,
                                      pid,
@@ -177,23 +253,46 @@ namespace Asura
 
             if (ret < 0)
             {
-                ASURA_EXCEPTION(+"System call rmunmap failed");
+                return Unexpected(LastErrorCode());
             }
 #endif
+            return {};
         }
 
-        static auto ReadProcessMemoryArea(const process_id_t pid,
-                                          const auto address,
-                                          const std::size_t size)
-          -> bytes_t
+        static auto FreeArea(const process_id_t pid,
+                             const auto address,
+                             const std::size_t size) -> void
+        {
+            const auto result = TryFreeArea(pid, address, size);
+
+            if (not result)
+            {
+                ASURA_EXCEPTION(std::string("Freeing area failed: ")
+                                + ErrorCodeStr(result.error()));
+            }
+        }
+
+        /**
+         * Non throwing version, for probing addresses that might not be
+         * mapped anymore. Nothing is allocated when it fails.
+         */
+        static auto TryReadProcessMemoryArea(const process_id_t pid,
+                                             const auto address,
+                                             const ptr_t buffer,
+                                             const std::size_t size)
+          -> Expected<void>
         {
-            bytes_t result(size);
+            if (const auto backend = MemoryBackend::Find(pid))
+            {
+                return backend->tryRead(view_as<std::uintptr_t>(address),
+                                        buffer,
+                                        size);
+            }
 
 #ifndef WINDOWS
-            const iovec local  = { .iov_base = result.data(),
-                                   .iov_len  = result.size() };
+            const iovec local  = { .iov_base = buffer, .iov_len = size };
             const iovec remote = { .iov_base = view_as<ptr_t>(address),
-                                   .iov_len  = result.size() };
+                                   .iov_len  = size };
 
             const auto ret = process_vm_readv(pid,
                                               &local,
@@ -202,38 +301,95 @@ namespace Asura
                                               1,
                                               0);
 
-            if (ret != view_as<decltype(ret)>(size))
+            if (ret < 0)
             {
-                std::stringstream ss;
-                ss << std::hex << address;
+                return Unexpected(LastErrorCode());
+            }
 
-                ASURA_EXCEPTION("process_vm_readv failed with: address: "
-                                + ss.str()
-                                + ", size: " + std::to_string(size)
-                                + ", ret: " + std::to_string(ret));
+            if (view_as<std::size_t>(ret) != size)
+            {
+                return Unexpected(ErrorCode::PARTIAL_TRANSFER);
             }
 #else
-
             const auto ret = Toolhelp32ReadProcessMemory(
               view_as<DWORD>(pid),
               view_as<ptr_t>(address),
-              result.data(),
-              result.size(),
+              buffer,
+              size,
               nullptr);
 
             if (not ret)
+            {
+                return Unexpected(LastErrorCode());
+            }
+#endif
+
+            return {};
+        }
+
+        template <typename T>
+          requires std::is_trivially_copyable_v<T>
+        static auto TryReadProcessMemory(const process_id_t pid,
+                                         const auto address)
+          -> Expected<T>
+        {
+            T value {};
+
+            const auto result = TryReadProcessMemoryArea(pid,
+                                                         address,
+                                                         &value,
+                                                         sizeof(T));
+
+            if (not result)
+            {
+                return Unexpected(result.error());
+            }
+
+            return value;
+        }
+
+        static auto ReadProcessMemoryArea(const process_id_t pid,
+                                          const auto address,
+                                          const std::size_t size)
+          -> bytes_t
+        {
+            return ReadProcessMemoryAreaInto(pid, address, bytes_t(size));
+        }
+
+        static auto ReadProcessMemoryArea(
+          const process_id_t pid,
+          const auto address,
+          const std::size_t size,
+          std::pmr::memory_resource* const resource) -> pmr_bytes_t
+        {
+            return ReadProcessMemoryAreaInto(pid,
+                                             address,
+                                             pmr_bytes_t(size, resource));
+        }
+
+        /* Reads straight into the caller's buffer, throws on failure */
+        static auto ReadProcessMemoryAreaInto(const process_id_t pid,
+                                              const auto address,
+                                              const data_t buffer,
+                                              const std::size_t size)
+          -> void
+        {
+            const auto read = TryReadProcessMemoryArea(pid,
+                                                       address,
+                                                       buffer,
+                                                       size);
+
+            if (not read)
             {
                 std::stringstream ss;
                 ss << std::hex << address;
 
-                ASURA_EXCEPTION("ReadProcessMemory failed with: address: "
-                                + ss.str()
-                                + ", size: " + std::to_string(size)
-                                + ", ret: " + std::to_string(ret));
+                ASURA_EXCEPTION("Reading process memory failed with: "
+                                "address: "
+                                + ss.str() + ", size: "
+                                + std::to_string(size)
+                                + ", error: " + ErrorCodeStr(read.error()));
             }
-#endif
-
-            return result;
         }
 
         template <typename A>
@@ -288,18 +444,115 @@ namespace Asura
             return result;
         }
 
-        template <typename T = std::uintptr_t>
-        static auto WriteProcessMemoryArea(const process_id_t pid,
-                                           const bytes_t& bytes,
-                                           const T address) -> void
+        /**
+         * Gathers size bytes at each address into one contiguous buffer,
+         * with as few system calls as possible.
+         * An address that can't be read doesn't fail the whole batch,
+         * its bytes are zeroed and its entry in the validity vector is
+         * set to false.
+         */
+        static auto ReadProcessMemoryAreas(
+          const process_id_t pid,
+          const std::vector<std::uintptr_t>& addresses,
+          const std::size_t size) -> std::tuple<bytes_t, std::vector<bool>>
         {
+            bytes_t result(addresses.size() * size);
+            std::vector<bool> valids(addresses.size(), false);
+
+            if (size == 0)
+            {
+                return { result, valids };
+            }
+
+            if (const auto backend = MemoryBackend::Find(pid))
+            {
+                backend->tryReadBatch(addresses, size, result.data(), valids);
+                return { result, valids };
+            }
+
 #ifndef WINDOWS
-            const iovec local = {
-                .iov_base = view_as<const data_t>(bytes.data()),
-                .iov_len  = bytes.size()
-            };
+            std::vector<iovec> locals(
+              std::min(addresses.size(), MAX_IOVECS));
+            std::vector<iovec> remotes(locals.size());
+
+            std::size_t index = 0;
+
+            while (index < addresses.size())
+            {
+                const auto count = std::min(addresses.size() - index,
+                                            MAX_IOVECS);
+
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    locals[i]  = { .iov_base = &result[(index + i) * size],
+                                   .iov_len  = size };
+                    remotes[i] = { .iov_base = view_as<ptr_t>(
+                                     addresses[index + i]),
+                                   .iov_len = size };
+                }
+
+                const auto ret = process_vm_readv(pid,
+                                                  locals.data(),
+                                                  count,
+                                                  remotes.data(),
+                                                  count,
+                                                  0);
+
+                /**
+                 * The kernel stops at the first element it can't read,
+                 * so everything before it is valid and we resume right
+                 * after the faulty one.
+                 */
+                const auto completed = ret < 0 ?
+                                         0 :
+                                         view_as<std::size_t>(ret) / size;
+
+                for (std::size_t i = 0; i < completed; i++)
+                {
+                    valids[index + i] = true;
+                }
+
+                index += completed;
+
+                if (completed < count)
+                {
+                    std::fill_n(result.begin() + index * size, size, 0);
+                    index++;
+                }
+            }
+#else
+            for (std::size_t i = 0; i < addresses.size(); i++)
+            {
+                valids[i] = Toolhelp32ReadProcessMemory(
+                  view_as<DWORD>(pid),
+                  view_as<ptr_t>(addresses[i]),
+                  &result[i * size],
+                  size,
+                  nullptr);
+            }
+#endif
+
+            return { result, valids };
+        }
+
+        static auto TryWriteProcessMemoryArea(const process_id_t pid,
+                                              const auto address,
+                                              const void* const buffer,
+                                              const std::size_t size)
+          -> Expected<void>
+        {
+            if (const auto backend = MemoryBackend::Find(pid))
+            {
+                return backend->tryWrite(view_as<std::uintptr_t>(address),
+                                         buffer,
+                                         size);
+            }
+
+#ifndef WINDOWS
+            const iovec local  = { .iov_base = const_cast<ptr_t>(buffer),
+                                   .iov_len  = size };
             const iovec remote = { .iov_base = view_as<ptr_t>(address),
-                                   .iov_len  = bytes.size() };
+                                   .iov_len  = size };
 
             const auto ret = process_vm_writev(pid,
                                                &local,
@@ -308,17 +561,15 @@ namespace Asura
                                                1,
                                                0);
 
-            if (ret != view_as<decltype(ret)>(bytes.size()))
+            if (ret < 0)
             {
-                std::stringstream ss;
-                ss << std::hex << address;
-
-                ASURA_EXCEPTION("process_vm_writev failed with: address: "
-                                + ss.str() + ", size: "
-                                + std::to_string(bytes.size())
-                                + ", ret: " + std::to_string(ret));
+                return Unexpected(LastErrorCode());
             }
 
+            if (view_as<std::size_t>(ret) != size)
+            {
+                return Unexpected(ErrorCode::PARTIAL_TRANSFER);
+            }
 #else
             const auto process_handle = GetCurrentProcessId() == pid ?
                                           GetCurrentProcess() :
@@ -330,33 +581,208 @@ namespace Asura
 
             if (process_handle == nullptr)
             {
-                ASURA_EXCEPTION("Couldn't open process");
+                return Unexpected(LastErrorCode());
             }
 
             const auto ret = WriteProcessMemory(process_handle,
                                                 view_as<ptr_t>(address),
-                                                bytes.data(),
-                                                bytes.size(),
+                                                buffer,
+                                                size,
                                                 nullptr);
 
+            const auto error_code = LastErrorCode();
+
+            CloseHandle(process_handle);
+
             if (not ret)
+            {
+                return Unexpected(error_code);
+            }
+#endif
+
+            return {};
+        }
+
+        template <typename T = std::uintptr_t>
+        static auto WriteProcessMemoryArea(const process_id_t pid,
+                                           const bytes_t& bytes,
+                                           const T address) -> void
+        {
+            const auto written = TryWriteProcessMemoryArea(pid,
+                                                           address,
+                                                           bytes.data(),
+                                                           bytes.size());
+
+            if (not written)
             {
                 std::stringstream ss;
                 ss << std::hex << address;
 
                 ASURA_EXCEPTION(
-                  "WriteProcessMemory failed with: address: " + ss.str()
-                  + ", size: " + std::to_string(bytes.size())
-                  + ", ret: " + std::to_string(ret));
+                  "Writing process memory failed with: address: "
+                  + ss.str() + ", size: " + std::to_string(bytes.size())
+                  + ", error: " + ErrorCodeStr(written.error()));
             }
+        }
 
-            CloseHandle(process_handle);
+        /**
+         * One entry per page of the range, false when the page has never
+         * been touched (or has been dropped), reading it would only give
+         * zeros and make the kernel fault it in.
+         * Swapped out pages still hold data so they count as resident,
+         * and so does everything when the information isn't available.
+         * Only meaningful for anonymous memory, a file-backed page that
+         * isn't present is still backed by the file.
+         */
+        static auto ResidentPages(const process_id_t pid,
+                                  const auto address,
+                                  const std::size_t size)
+          -> std::vector<bool>
+        {
+            if (const auto backend = MemoryBackend::Find(pid))
+            {
+                return backend->residentPages(
+                  view_as<std::uintptr_t>(address),
+                  size);
+            }
+
+            const auto page_size  = GetPageSize();
+            const auto page_count = AlignToPageSize(
+                                      view_as<std::uintptr_t>(address)
+                                        % page_size
+                                        + size,
+                                      page_size)
+                                    / page_size;
+
+            std::vector<bool> resident(page_count, true);
+
+#ifndef WINDOWS
+            const auto entries = ReadPagemap(pid, address, size);
+
+            if (not entries)
+            {
+                return resident;
+            }
+
+            for (std::size_t i = 0; i < page_count; i++)
+            {
+                resident[i] = (*entries)[i]
+                              & (PAGEMAP_PRESENT | PAGEMAP_SWAPPED);
+            }
+#endif
+
+            return resident;
+        }
+
+        /**
+         * True when a page of a file mapping isn't the page cache
+         * anymore, it was copied on write (relocations, hooks...) so it
+         * can differ between processes mapping the same file.
+         * Also true when the information isn't available.
+         */
+        static auto HasPrivatePages(const process_id_t pid,
+                                    const auto address,
+                                    const std::size_t size) -> bool
+        {
+#ifdef WINDOWS
+            return true;
+#else
+            if (MemoryBackend::Find(pid))
+            {
+                return true;
+            }
+
+            const auto entries = ReadPagemap(pid, address, size);
+
+            if (not entries)
+            {
+                return true;
+            }
+
+            /* Page cache pages are never swapped, only anonymous ones */
+            return std::any_of(entries->begin(),
+                               entries->end(),
+                               [](const std::uint64_t entry)
+                               {
+                                   return (entry & PAGEMAP_SWAPPED)
+                                          or ((entry & PAGEMAP_PRESENT)
+                                              and not (entry
+                                                       & PAGEMAP_FILE_PAGE));
+                               });
 #endif
         }
 
         static auto GetPageSize() -> std::size_t;
 
       private:
+#ifndef WINDOWS
+        /* One /proc/pid/pagemap entry per page, none when it can't */
+        static auto ReadPagemap(const process_id_t pid,
+                                const auto address,
+                                const std::size_t size)
+          -> std::optional<std::vector<std::uint64_t>>
+        {
+            const auto page_size  = GetPageSize();
+            const auto first_page = view_as<std::uintptr_t>(address)
+                                    / page_size;
+            const auto page_count = AlignToPageSize(
+                                      view_as<std::uintptr_t>(address)
+                                        % page_size
+                                        + size,
+                                      page_size)
+                                    / page_size;
+
+            const auto fd = open(
+              ("/proc/" + std::to_string(pid) + "/pagemap").c_str(),
+              O_RDONLY);
+
+            if (fd < 0)
+            {
+                return std::nullopt;
+            }
+
+            std::vector<std::uint64_t> entries(page_count);
+
+            const auto ret = pread(fd,
+                                   entries.data(),
+                                   entries.size() * sizeof(std::uint64_t),
+                                   view_as<off_t>(first_page
+                                                  * sizeof(std::uint64_t)));
+
+            close(fd);
+
+            if (ret != view_as<decltype(ret)>(entries.size()
+                                              * sizeof(std::uint64_t)))
+            {
+                return std::nullopt;
+            }
+
+            return entries;
+        }
+#endif
+
+        template <typename C>
+        static auto ReadProcessMemoryAreaInto(const process_id_t pid,
+                                              const auto address,
+                                              C result) -> C
+        {
+            ReadProcessMemoryAreaInto(pid,
+                                      address,
+                                      view_as<data_t>(result.data()),
+                                      result.size());
+
+            return result;
+        }
+
+      public:
+        /* UIO_MAXIOV, how many iovecs the kernel accepts per call */
+        static constexpr std::size_t MAX_IOVECS = 1024;
+        /* Bits of a /proc/pid/pagemap entry */
+        static constexpr std::uint64_t PAGEMAP_PRESENT   = 1ull << 63;
+        static constexpr std::uint64_t PAGEMAP_SWAPPED   = 1ull << 62;
+        static constexpr std::uint64_t PAGEMAP_FILE_PAGE = 1ull << 61;
+
+      private:
         static std::size_t _page_size;
         static std::once_flag _get_page_size_once_flag;
     };
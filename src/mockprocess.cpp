@@ -0,0 +1,707 @@
+#include "pch.h"
+
+#include "memoryutils.h"
+#include "mockprocess.h"
+#include "processmemorymap.h"
+
+using namespace Asura;
+
+/* Where areas without a usable address hint are placed */
+static constexpr std::uintptr_t FIRST_ALLOC_ADDRESS = 0x10000;
+
+/* Same outcomes as process_vm_readv/writev */
+static auto TransferResult(const std::size_t transferred,
+                           const std::size_t size) -> Expected<void>
+{
+    if (transferred == size)
+    {
+        return {};
+    }
+
+    if (transferred == 0)
+    {
+        return Unexpected(ErrorCode::BAD_ADDRESS);
+    }
+
+    return Unexpected(ErrorCode::PARTIAL_TRANSFER);
+}
+
+MockProcess::MockProcess(const std::string& name)
+ : _name(name),
+   _pid(Attach(this)),
+   _page_size(MemoryUtils::GetPageSize())
+{
+}
+
+MockProcess::~MockProcess()
+{
+    Detach(_pid);
+}
+
+auto MockProcess::id() const -> process_id_t
+{
+    return _pid;
+}
+
+auto MockProcess::process() const -> Process
+{
+    return Process(_pid);
+}
+
+auto MockProcess::callsCount() const -> std::size_t
+{
+    return _calls_count.load(std::memory_order_relaxed);
+}
+
+auto MockProcess::latency() const -> std::chrono::nanoseconds
+{
+    return _latency;
+}
+
+auto MockProcess::addArea(const AreaDescription& description,
+                          const bytes_t& bytes) -> void
+{
+    const std::lock_guard lock(_mutex);
+
+    if (description.size == 0)
+    {
+        ASURA_EXCEPTION("Area can't be empty");
+    }
+
+    if (bytes.size() > description.size)
+    {
+        ASURA_EXCEPTION("Area bytes don't fit inside the area");
+    }
+
+    if (not isFree(description.begin, description.size))
+    {
+        std::stringstream ss;
+        ss << std::hex << description.begin;
+
+        ASURA_EXCEPTION("Area at " + ss.str()
+                        + " overlaps an existing one");
+    }
+
+    _areas.emplace(description.begin, description);
+    storePages(description.begin, bytes.data(), bytes.size());
+}
+
+auto MockProcess::addArea(const std::uintptr_t begin,
+                          const std::size_t size,
+                          const mapf_t flags,
+                          const std::string& name,
+                          const bytes_t& bytes) -> void
+{
+    /**
+     * Paths are treated as file mappings, the inode only has to be the
+     * same for every area of the file so they're grouped as a module.
+     */
+    const std::uint64_t inode = name.starts_with('/') ?
+                                  std::hash<std::string> {}(name) | 1 :
+                                  0;
+
+    addArea({ begin, size, flags, 0, 0, inode, name }, bytes);
+}
+
+auto MockProcess::loadDescription(std::istream& stream) -> void
+{
+    std::string line;
+
+    while (std::getline(stream, line))
+    {
+        if (line.empty() or line.starts_with('#'))
+        {
+            continue;
+        }
+
+        addArea(ProcessMemoryMap::ParseMapsLine(line));
+    }
+}
+
+auto MockProcess::loadDescription(const std::string& path) -> void
+{
+    std::ifstream file(path);
+
+    if (not file.is_open())
+    {
+        ASURA_EXCEPTION("Couldn't open " + path);
+    }
+
+    loadDescription(file);
+}
+
+auto MockProcess::loadDump(const std::string& folder) -> void
+{
+    /**
+     * File names lost the slashes of the paths and the mappings, the
+     * copy of /proc/pid/maps dump_game leaves next to them still has
+     * them.
+     */
+    std::map<std::uintptr_t, AreaDescription> maps_areas;
+    std::ifstream maps_file(std::filesystem::path(folder) / DUMP_MAPS_NAME);
+    std::string line;
+
+    while (std::getline(maps_file, line))
+    {
+        auto description = ProcessMemoryMap::ParseMapsLine(line);
+        maps_areas[description.begin] = std::move(description);
+    }
+
+    for (const auto& entry : std::filesystem::directory_iterator(folder))
+    {
+        if (not entry.is_regular_file()
+            or entry.path().filename() == DUMP_MAPS_NAME)
+        {
+            continue;
+        }
+
+        /* The name can contain underscores, parse from the end */
+        const auto file_name = entry.path().filename().string();
+        const std::string_view fields(file_name);
+
+        const auto flags_start = fields.rfind('_');
+        const auto end_start   = flags_start == std::string_view::npos
+                                       or flags_start == 0 ?
+                                   std::string_view::npos :
+                                   fields.rfind('_', flags_start - 1);
+        const auto begin_start = end_start == std::string_view::npos
+                                       or end_start == 0 ?
+                                   std::string_view::npos :
+                                   fields.rfind('_', end_start - 1);
+
+        std::uintptr_t begin {}, end {};
+        mapf_t flags {};
+
+        const auto parse_number =
+          [&](auto& value, const std::size_t start, const std::size_t stop)
+        {
+            const auto [ptr, ec] = std::from_chars(
+              fields.data() + start + 1,
+              fields.data() + stop,
+              value,
+              std::is_same_v<decltype(value), mapf_t&> ? 10 : 16);
+
+            return ec == std::errc() and ptr == fields.data() + stop;
+        };
+
+        if (begin_start == std::string_view::npos
+            or not parse_number(begin, begin_start, end_start)
+            or not parse_number(end, end_start, flags_start)
+            or not parse_number(flags, flags_start, fields.size())
+            or end <= begin)
+        {
+            ASURA_EXCEPTION("Unexpected dump file name: " + file_name);
+        }
+
+        std::ifstream file(entry.path(), std::ios::binary);
+
+        if (not file.is_open())
+        {
+            ASURA_EXCEPTION("Couldn't open " + entry.path().string());
+        }
+
+        bytes_t bytes((std::istreambuf_iterator<char>(file)),
+                      std::istreambuf_iterator<char>());
+
+        bytes.resize(std::min(bytes.size(), end - begin));
+
+        const auto maps_area = maps_areas.find(begin);
+
+        if (maps_area != maps_areas.end())
+        {
+            auto description  = maps_area->second;
+            description.size  = end - begin;
+            description.flags = flags;
+            addArea(description, bytes);
+            continue;
+        }
+
+        /**
+         * Older dumps, paths are guessed back from the names, which is
+         * wrong for paths that had underscores.
+         */
+        auto name = std::string(fields.substr(0, begin_start));
+
+        if (name.starts_with('_'))
+        {
+            std::replace(name.begin(), name.end(), '_', '/');
+        }
+
+        addArea(begin, end - begin, flags, name, bytes);
+    }
+}
+
+auto MockProcess::setLatency(const std::chrono::nanoseconds latency)
+  -> void
+{
+    _latency = latency;
+}
+
+auto MockProcess::resetCallsCount() -> void
+{
+    _calls_count.store(0, std::memory_order_relaxed);
+}
+
+auto MockProcess::setAreas(const std::vector<AreaDescription>& areas)
+  -> void
+{
+    const std::lock_guard lock(_mutex);
+
+    _areas.clear();
+
+    for (const auto& area : areas)
+    {
+        _areas.emplace(area.begin, area);
+    }
+
+    std::erase_if(_pages,
+                  [&](const auto& page)
+                  {
+                      return findArea(page.first * _page_size)
+                             == _areas.end();
+                  });
+}
+
+auto MockProcess::forceRead(const std::uintptr_t address,
+                            const ptr_t buffer,
+                            const std::size_t size) const -> void
+{
+    const std::lock_guard lock(_mutex);
+
+    const auto bytes = view_as<data_t>(buffer);
+
+    for (std::size_t offset = 0; offset < size;)
+    {
+        const auto page_offset = (address + offset) % _page_size;
+        const auto piece       = std::min(_page_size - page_offset,
+                                    size - offset);
+        const auto it          = _pages.find((address + offset)
+                                    / _page_size);
+
+        if (it == _pages.end())
+        {
+            std::memset(&bytes[offset], 0, piece);
+        }
+        else
+        {
+            std::memcpy(&bytes[offset], &it->second[page_offset], piece);
+        }
+
+        offset += piece;
+    }
+}
+
+auto MockProcess::forceWrite(const std::uintptr_t address,
+                             const void* const buffer,
+                             const std::size_t size) -> void
+{
+    const std::lock_guard lock(_mutex);
+
+    storePages(address, buffer, size);
+}
+
+auto MockProcess::name() const -> std::string
+{
+    return _name;
+}
+
+auto MockProcess::areas() const -> std::vector<AreaDescription>
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    std::vector<AreaDescription> result;
+    result.reserve(_areas.size());
+
+    for (const auto& [begin, area] : _areas)
+    {
+        result.push_back(area);
+    }
+
+    return result;
+}
+
+auto MockProcess::residentPages(const std::uintptr_t address,
+                                const std::size_t size) const
+  -> std::vector<bool>
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    const auto first_page = address / _page_size;
+    const auto page_count = MemoryUtils::AlignToPageSize(
+                              address % _page_size + size,
+                              _page_size)
+                            / _page_size;
+
+    std::vector<bool> resident(page_count);
+
+    for (std::size_t i = 0; i < page_count; i++)
+    {
+        resident[i] = _pages.contains(first_page + i);
+    }
+
+    return resident;
+}
+
+auto MockProcess::tryRead(const std::uintptr_t address,
+                          const ptr_t buffer,
+                          const std::size_t size) const -> Expected<void>
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    const auto bytes = view_as<data_t>(buffer);
+    const auto read  = walk(address,
+                           size,
+                           MemoryArea::ProtectionFlags::READ,
+                           [&](const std::uintptr_t page,
+                               const std::size_t pageOffset,
+                               const std::size_t offset,
+                               const std::size_t piece)
+                           {
+                               const auto it = _pages.find(page);
+
+                               if (it == _pages.end())
+                               {
+                                   std::memset(&bytes[offset], 0, piece);
+                                   return;
+                               }
+
+                               std::memcpy(&bytes[offset],
+                                           &it->second[pageOffset],
+                                           piece);
+                           });
+
+    return TransferResult(read, size);
+}
+
+auto MockProcess::tryReadBatch(const std::vector<std::uintptr_t>& addresses,
+                               const std::size_t size,
+                               const data_t buffer,
+                               std::vector<bool>& valids) const -> void
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    for (std::size_t i = 0; i < addresses.size(); i++)
+    {
+        const auto bytes = &buffer[i * size];
+        const auto read  = walk(addresses[i],
+                               size,
+                               MemoryArea::ProtectionFlags::READ,
+                               [&](const std::uintptr_t page,
+                                   const std::size_t pageOffset,
+                                   const std::size_t offset,
+                                   const std::size_t piece)
+                               {
+                                   const auto it = _pages.find(page);
+
+                                   if (it == _pages.end())
+                                   {
+                                       std::memset(&bytes[offset],
+                                                   0,
+                                                   piece);
+                                       return;
+                                   }
+
+                                   std::memcpy(&bytes[offset],
+                                               &it->second[pageOffset],
+                                               piece);
+                               });
+
+        valids[i] = read == size;
+
+        if (not valids[i])
+        {
+            std::memset(bytes, 0, size);
+        }
+    }
+}
+
+auto MockProcess::tryWrite(const std::uintptr_t address,
+                           const void* const buffer,
+                           const std::size_t size) -> Expected<void>
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    const auto bytes   = view_as<const byte_t*>(buffer);
+    const auto written = walk(address,
+                              size,
+                              MemoryArea::ProtectionFlags::WRITE,
+                              [&](const std::uintptr_t page,
+                                  const std::size_t pageOffset,
+                                  const std::size_t offset,
+                                  const std::size_t piece)
+                              {
+                                  auto& data = _pages[page];
+
+                                  if (data.empty())
+                                  {
+                                      data.resize(_page_size);
+                                  }
+
+                                  std::memcpy(&data[pageOffset],
+                                              &bytes[offset],
+                                              piece);
+                              });
+
+    return TransferResult(written, size);
+}
+
+auto MockProcess::tryProtect(const std::uintptr_t address,
+                             const std::size_t size,
+                             const mapf_t flags) -> Expected<void>
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    /* Like mprotect, the whole range has to be mapped */
+    const auto mapped = walk(address,
+                             size,
+                             MemoryArea::ProtectionFlags::NONE,
+                             [](const auto...)
+                             {
+                             });
+
+    if (mapped != size)
+    {
+        return Unexpected(ErrorCode::BAD_ADDRESS);
+    }
+
+    splitAt(address);
+    splitAt(address + size);
+
+    for (auto it = _areas.find(address);
+         it != _areas.end() and it->first < address + size;
+         it++)
+    {
+        it->second.flags = flags;
+    }
+
+    return {};
+}
+
+auto MockProcess::tryAlloc(const std::uintptr_t address,
+                           const std::size_t size,
+                           const mapf_t flags) -> Expected<ptr_t>
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    if (size == 0)
+    {
+        return Unexpected(ErrorCode::INVALID_ARGUMENT);
+    }
+
+    const auto aligned_size = MemoryUtils::AlignToPageSize(size,
+                                                           _page_size);
+    auto begin              = MemoryUtils::Align(address, _page_size);
+
+    /* Like mmap, the address is only a hint, take the first hole */
+    if (begin == 0 or not isFree(begin, aligned_size))
+    {
+        begin = FIRST_ALLOC_ADDRESS;
+
+        for (const auto& [area_begin, area] : _areas)
+        {
+            if (begin + aligned_size <= area_begin)
+            {
+                break;
+            }
+
+            begin = std::max(begin,
+                             MemoryUtils::AlignToPageSize(area_begin
+                                                            + area.size,
+                                                          _page_size));
+        }
+    }
+
+    _areas.emplace(begin,
+                   AreaDescription { begin, aligned_size, flags, 0, 0, 0, "" });
+
+    return view_as<ptr_t>(begin);
+}
+
+auto MockProcess::tryFree(const std::uintptr_t address,
+                          const std::size_t size) -> Expected<void>
+{
+    simulateCall();
+
+    const std::lock_guard lock(_mutex);
+
+    if (size == 0)
+    {
+        return Unexpected(ErrorCode::INVALID_ARGUMENT);
+    }
+
+    /* Like munmap, holes in the range aren't an error */
+    splitAt(address);
+    splitAt(address + size);
+
+    _areas.erase(_areas.lower_bound(address),
+                 _areas.lower_bound(address + size));
+
+    const auto first_page = address / _page_size;
+    const auto last_page  = (address + size - 1) / _page_size;
+
+    std::erase_if(_pages,
+                  [&](const auto& page)
+                  {
+                      return page.first >= first_page
+                             and page.first <= last_page;
+                  });
+
+    return {};
+}
+
+auto MockProcess::simulateCall() const -> void
+{
+    _calls_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (_latency == std::chrono::nanoseconds::zero())
+    {
+        return;
+    }
+
+    const auto until = std::chrono::steady_clock::now() + _latency;
+
+    while (std::chrono::steady_clock::now() < until)
+    {
+    }
+}
+
+auto MockProcess::findArea(const std::uintptr_t address) const
+  -> std::map<std::uintptr_t, AreaDescription>::const_iterator
+{
+    auto it = _areas.upper_bound(address);
+
+    if (it == _areas.begin())
+    {
+        return _areas.end();
+    }
+
+    it--;
+
+    if (address >= it->first + it->second.size)
+    {
+        return _areas.end();
+    }
+
+    return it;
+}
+
+auto MockProcess::isFree(const std::uintptr_t begin,
+                         const std::size_t size) const -> bool
+{
+    auto it = _areas.lower_bound(begin);
+
+    if (it != _areas.end() and it->first < begin + size)
+    {
+        return false;
+    }
+
+    if (it != _areas.begin())
+    {
+        it--;
+
+        if (it->first + it->second.size > begin)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto MockProcess::splitAt(const std::uintptr_t address) -> void
+{
+    const auto it = findArea(address);
+
+    if (it == _areas.end() or it->first == address)
+    {
+        return;
+    }
+
+    auto& first       = _areas.at(it->first);
+    auto second       = first;
+    const auto offset = address - first.begin;
+
+    first.size = offset;
+    second.begin += offset;
+    second.size -= offset;
+
+    if (second.inode != 0)
+    {
+        second.offset += offset;
+    }
+
+    _areas.emplace(address, std::move(second));
+}
+
+auto MockProcess::walk(const std::uintptr_t address,
+                       const std::size_t size,
+                       const mapf_t requiredFlag,
+                       const auto& access) const -> std::size_t
+{
+    std::size_t walked = 0;
+
+    while (walked < size)
+    {
+        const auto area = findArea(address + walked);
+
+        if (area == _areas.end()
+            or (area->second.flags & requiredFlag) != requiredFlag)
+        {
+            break;
+        }
+
+        const auto area_end = area->first + area->second.size;
+
+        while (walked < size and address + walked < area_end)
+        {
+            const auto current     = address + walked;
+            const auto page_offset = current % _page_size;
+            const auto piece       = std::min({ _page_size - page_offset,
+                                          size - walked,
+                                          area_end - current });
+
+            access(current / _page_size, page_offset, walked, piece);
+            walked += piece;
+        }
+    }
+
+    return walked;
+}
+
+auto MockProcess::storePages(const std::uintptr_t address,
+                             const void* const buffer,
+                             const std::size_t size) -> void
+{
+    const auto bytes = view_as<const byte_t*>(buffer);
+
+    for (std::size_t offset = 0; offset < size;)
+    {
+        const auto page_offset = (address + offset) % _page_size;
+        const auto piece       = std::min(_page_size - page_offset,
+                                    size - offset);
+
+        auto& page = _pages[(address + offset) / _page_size];
+
+        if (page.empty())
+        {
+            page.resize(_page_size);
+        }
+
+        std::memcpy(&page[page_offset], &bytes[offset], piece);
+        offset += piece;
+    }
+}
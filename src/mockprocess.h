@@ -0,0 +1,145 @@
+#ifndef ASURA_MOCKPROCESS_H
+#define ASURA_MOCKPROCESS_H
+
+#include "memorybackend.h"
+#include "process.h"
+
+namespace Asura
+{
+    /**
+     * A process that only exists in memory, for testing and benchmarking
+     * the scanners and friends without a real target:
+     *
+     * MockProcess mock("game");
+     * mock.addArea(0x400000, 0x1000, R | X, "/usr/bin/game", code);
+     * mock.loadDescription("maps.txt");
+     * mock.setLatency(std::chrono::microseconds(2));
+     *
+     * const auto process = mock.process();
+     *
+     * Areas can be described like /proc/pid/maps lines or loaded from a
+     * folder written by the dump_game example.
+     * Pages are only allocated when written, the others read as zeros
+     * and are reported as not resident, like untouched anonymous memory.
+     * Every call to the backend counts as one system call and can be
+     * given a latency, so batching can be measured.
+     */
+    class MockProcess : public MemoryBackend
+    {
+      public:
+        /* Copy of /proc/pid/maps in a dump folder */
+        static constexpr auto DUMP_MAPS_NAME = "maps";
+
+      public:
+        explicit MockProcess(const std::string& name = "mock");
+        ~MockProcess() override;
+
+        MockProcess(const MockProcess&)                    = delete;
+        auto operator=(const MockProcess&) -> MockProcess& = delete;
+
+      public:
+        auto id() const -> process_id_t;
+        auto process() const -> Process;
+        auto callsCount() const -> std::size_t;
+        auto latency() const -> std::chrono::nanoseconds;
+
+      public:
+        auto addArea(const AreaDescription& description,
+                     const bytes_t& bytes = {}) -> void;
+        auto addArea(const std::uintptr_t begin,
+                     const std::size_t size,
+                     const mapf_t flags,
+                     const std::string& name = "",
+                     const bytes_t& bytes    = {}) -> void;
+        /* One /proc/pid/maps line per area, # starts a comment */
+        auto loadDescription(std::istream& stream) -> void;
+        auto loadDescription(const std::string& path) -> void;
+        /**
+         * Files named <name>_<begin>_<end>_<flags>, as in dump_game, the
+         * areas take their names and mappings from the maps file of the
+         * folder when there's one.
+         */
+        auto loadDump(const std::string& folder) -> void;
+        /* Busy waits, sleeping is too coarse for microseconds */
+        auto setLatency(const std::chrono::nanoseconds latency) -> void;
+        auto resetCallsCount() -> void;
+        /* Replaces the areas, pages that aren't mapped anymore are lost */
+        auto setAreas(const std::vector<AreaDescription>& areas) -> void;
+        /**
+         * Ignore the areas and their protection, for setting up or
+         * inspecting the memory. Don't count as calls.
+         */
+        auto forceRead(const std::uintptr_t address,
+                       const ptr_t buffer,
+                       const std::size_t size) const -> void;
+        auto forceWrite(const std::uintptr_t address,
+                        const void* const buffer,
+                        const std::size_t size) -> void;
+
+      public:
+        auto name() const -> std::string override;
+        auto areas() const -> std::vector<AreaDescription> override;
+        auto residentPages(const std::uintptr_t address,
+                           const std::size_t size) const
+          -> std::vector<bool> override;
+        auto tryRead(const std::uintptr_t address,
+                     const ptr_t buffer,
+                     const std::size_t size) const
+          -> Expected<void> override;
+        auto tryReadBatch(const std::vector<std::uintptr_t>& addresses,
+                          const std::size_t size,
+                          const data_t buffer,
+                          std::vector<bool>& valids) const
+          -> void override;
+
+      public:
+        auto tryWrite(const std::uintptr_t address,
+                      const void* const buffer,
+                      const std::size_t size) -> Expected<void> override;
+        auto tryProtect(const std::uintptr_t address,
+                        const std::size_t size,
+                        const mapf_t flags) -> Expected<void> override;
+        auto tryAlloc(const std::uintptr_t address,
+                      const std::size_t size,
+                      const mapf_t flags) -> Expected<ptr_t> override;
+        auto tryFree(const std::uintptr_t address, const std::size_t size)
+          -> Expected<void> override;
+
+      private:
+        auto simulateCall() const -> void;
+        /* Area containing address, or end */
+        auto findArea(const std::uintptr_t address) const
+          -> std::map<std::uintptr_t, AreaDescription>::const_iterator;
+        auto isFree(const std::uintptr_t begin,
+                    const std::size_t size) const -> bool;
+        /* Allocates the pages when needed, ignores the areas */
+        auto storePages(const std::uintptr_t address,
+                        const void* const buffer,
+                        const std::size_t size) -> void;
+        /* Makes address the beginning of an area when it's inside one */
+        auto splitAt(const std::uintptr_t address) -> void;
+        /**
+         * Calls access(page index, offset in page, offset in range,
+         * size) for each page piece of the range, stops at the first
+         * byte that isn't mapped or lacks the flag.
+         * Returns the bytes walked.
+         */
+        auto walk(const std::uintptr_t address,
+                  const std::size_t size,
+                  const mapf_t requiredFlag,
+                  const auto& access) const -> std::size_t;
+
+      private:
+        std::string _name;
+        process_id_t _pid;
+        std::size_t _page_size;
+        std::chrono::nanoseconds _latency {};
+        mutable std::atomic<std::size_t> _calls_count {};
+        mutable std::mutex _mutex;
+        std::map<std::uintptr_t, AreaDescription> _areas;
+        /* Page index -> page, only the ones that were written */
+        std::unordered_map<std::uintptr_t, bytes_t> _pages;
+    };
+}
+
+#endif
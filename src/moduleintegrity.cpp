@@ -0,0 +1,711 @@
+#include "pch.h"
+
+#include "elfview.h"
+#include "exception.h"
+#include "mappedfile.h"
+#include "memoryutils.h"
+#include "moduleintegrity.h"
+#include "simd.h"
+
+using namespace Asura;
+
+#ifndef WINDOWS
+/* What a module should look like in memory, without its load bias */
+struct Image
+{
+    /**
+     * RELRO also holds data the loader writes before protecting it, so
+     * only its relocations are compared.
+     */
+    struct Segment
+    {
+        std::uintptr_t address;
+        std::size_t file_offset;
+        std::size_t size;
+        bool relocations_only;
+    };
+
+    /**
+     * The value is the load bias plus the addend, known is false for
+     * relocations against symbols.
+     */
+    struct Relocation
+    {
+        std::uintptr_t address;
+        std::uint64_t addend;
+        bool known;
+    };
+
+    std::uintptr_t first_address {};
+    std::size_t word_size {};
+    std::vector<Segment> segments;
+    /* Sorted by address */
+    std::vector<Relocation> relocations;
+};
+
+template <ELF::IntType T>
+static auto ParseImage(const MappedFile& file) -> Image
+{
+    const ELFView view(file);
+
+    const auto header          = view.at<ELF::Elf_Ehdr<T>>(0);
+    const auto program_headers = view.at<ELF::Elf_Phdr<T>>(header->e_phoff,
+                                                           header->e_phnum);
+
+    const auto relative_type = [&]() -> std::uint32_t
+    {
+        switch (header->e_machine)
+        {
+            case ELF::EM_386:
+            case ELF::EM_X86_64:
+                return ELF::R_X86_RELATIVE;
+            case ELF::EM_AARCH64:
+                return ELF::R_AARCH64_RELATIVE;
+            /* Every relocation is left out */
+            default:
+                return std::numeric_limits<std::uint32_t>::max();
+        }
+    }();
+
+    Image image;
+    image.word_size     = sizeof(T);
+    image.first_address = view.firstLoadAddress<T>().value_or(0);
+
+    const ELF::Elf_Phdr<T>* dynamic = nullptr;
+    std::vector<const ELF::Elf_Phdr<T>*> loads;
+
+    for (std::uint16_t i = 0; i < header->e_phnum; i++)
+    {
+        const auto program_header = &program_headers[i];
+
+        switch (program_header->p_type)
+        {
+            case ELF::PT_LOAD:
+            {
+                loads.push_back(program_header);
+
+                if (not (program_header->p_flags & ELF::PF_W))
+                {
+                    image.segments.push_back(
+                      { program_header->p_vaddr,
+                        program_header->p_offset,
+                        program_header->p_filesz,
+                        false });
+                }
+
+                break;
+            }
+
+            case ELF::PT_DYNAMIC:
+            {
+                dynamic = program_header;
+                break;
+            }
+        }
+    }
+
+    const auto file_offset = [&](const std::uintptr_t address)
+      -> std::size_t
+    {
+        for (const auto load : loads)
+        {
+            if (address >= load->p_vaddr
+                and address - load->p_vaddr < load->p_filesz)
+            {
+                return load->p_offset + (address - load->p_vaddr);
+            }
+        }
+
+        return std::numeric_limits<std::size_t>::max();
+    };
+
+    /* As much of RELRO as comes from the file */
+    for (std::uint16_t i = 0; i < header->e_phnum; i++)
+    {
+        const auto relro = &program_headers[i];
+
+        if (relro->p_type != ELF::PT_GNU_RELRO)
+        {
+            continue;
+        }
+
+        for (const auto load : loads)
+        {
+            if (not (load->p_flags & ELF::PF_W))
+            {
+                continue;
+            }
+
+            const auto begin = std::max<std::uintptr_t>(relro->p_vaddr,
+                                                        load->p_vaddr);
+            const auto end   = std::min<std::uintptr_t>(
+              relro->p_vaddr + relro->p_memsz,
+              load->p_vaddr + load->p_filesz);
+
+            if (begin < end)
+            {
+                image.segments.push_back(
+                  { begin,
+                    load->p_offset + (begin - load->p_vaddr),
+                    end - begin,
+                    true });
+            }
+        }
+    }
+
+    for (const auto& segment : image.segments)
+    {
+        view.at<byte_t>(segment.file_offset, segment.size);
+    }
+
+    if (not dynamic)
+    {
+        return image;
+    }
+
+    const auto dynamic_entries = view.at<ELF::Elf_Dyn<T>>(
+      dynamic->p_offset,
+      dynamic->p_filesz / sizeof(ELF::Elf_Dyn<T>));
+
+    /* Address and size of each table */
+    std::uintptr_t rela {}, rel {}, relr {}, jmprel {};
+    std::size_t rela_size {}, rel_size {}, relr_size {}, jmprel_size {};
+    bool jmprel_is_rela {};
+
+    for (std::size_t i = 0; i < dynamic->p_filesz / sizeof(ELF::Elf_Dyn<T>)
+                            and dynamic_entries[i].d_tag != ELF::DT_NULL;
+         i++)
+    {
+        const auto value = dynamic_entries[i].d_un.d_val;
+
+        switch (dynamic_entries[i].d_tag)
+        {
+            case ELF::DT_RELA:
+                rela = value;
+                break;
+            case ELF::DT_RELASZ:
+                rela_size = value;
+                break;
+            case ELF::DT_REL:
+                rel = value;
+                break;
+            case ELF::DT_RELSZ:
+                rel_size = value;
+                break;
+            case ELF::DT_RELR:
+                relr = value;
+                break;
+            case ELF::DT_RELRSZ:
+                relr_size = value;
+                break;
+            case ELF::DT_JMPREL:
+                jmprel = value;
+                break;
+            case ELF::DT_PLTRELSZ:
+                jmprel_size = value;
+                break;
+            case ELF::DT_PLTREL:
+                jmprel_is_rela = value == ELF::DT_RELA;
+                break;
+        }
+    }
+
+    const auto relocation_type = [](const T info) -> std::uint32_t
+    {
+        if constexpr (sizeof(T) == sizeof(std::uint64_t))
+        {
+            return view_as<std::uint32_t>(info);
+        }
+        else
+        {
+            return info & 0xFF;
+        }
+    };
+
+    /* Implicit addends are the words in the file */
+    const auto file_word = [&](const std::uintptr_t address)
+    {
+        const auto offset = file_offset(address);
+
+        if (offset == std::numeric_limits<std::size_t>::max())
+        {
+            return std::optional<T>();
+        }
+
+        T word;
+        std::memcpy(&word, view.at<T>(offset), sizeof(T));
+
+        return std::optional<T>(word);
+    };
+
+    const auto add_table = [&]<typename R>(const std::uintptr_t address,
+                                           const std::size_t tableSize)
+    {
+        if (address == 0 or tableSize == 0)
+        {
+            return;
+        }
+
+        const auto count   = tableSize / sizeof(R);
+        const auto entries = view.at<R>(file_offset(address), count);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const auto& entry = entries[i];
+            const auto known  = relocation_type(entry.r_info)
+                               == relative_type;
+
+            if constexpr (std::is_same_v<R, ELF::Elf_Rela<T>>)
+            {
+                image.relocations.push_back(
+                  { entry.r_offset,
+                    view_as<std::uint64_t>(entry.r_addend),
+                    known });
+            }
+            else
+            {
+                const auto word = known ? file_word(entry.r_offset) :
+                                          std::optional<T>();
+
+                image.relocations.push_back(
+                  { entry.r_offset, word.value_or(0), word.has_value() });
+            }
+        }
+    };
+
+    add_table.template operator()<ELF::Elf_Rela<T>>(rela, rela_size);
+    add_table.template operator()<ELF::Elf_Rel<T>>(rel, rel_size);
+
+    if (jmprel_is_rela)
+    {
+        add_table.template operator()<ELF::Elf_Rela<T>>(jmprel,
+                                                         jmprel_size);
+    }
+    else
+    {
+        add_table.template operator()<ELF::Elf_Rel<T>>(jmprel, jmprel_size);
+    }
+
+    /**
+     * Packed relative relocations: an even entry is an address, an odd
+     * one is a bitmap of the words following the last address.
+     */
+    if (relr and relr_size)
+    {
+        const auto count   = relr_size / sizeof(T);
+        const auto entries = view.at<T>(file_offset(relr), count);
+
+        const auto add_relative = [&](const std::uintptr_t address)
+        {
+            const auto word = file_word(address);
+
+            image.relocations.push_back(
+              { address, word.value_or(0), word.has_value() });
+        };
+
+        std::uintptr_t address = 0;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto entry = entries[i];
+
+            if ((entry & 1) == 0)
+            {
+                add_relative(entry);
+                address = entry + sizeof(T);
+                continue;
+            }
+
+            for (std::size_t bit = 0; (entry >>= 1) != 0; bit++)
+            {
+                if (entry & 1)
+                {
+                    add_relative(address + bit * sizeof(T));
+                }
+            }
+
+            address += (sizeof(T) * CHAR_BIT - 1) * sizeof(T);
+        }
+    }
+
+    std::sort(image.relocations.begin(),
+              image.relocations.end(),
+              [](const Image::Relocation& left,
+                 const Image::Relocation& right)
+              {
+                  return left.address < right.address;
+              });
+
+    return image;
+}
+
+static auto ParseImage(const MappedFile& file) -> Image
+{
+    if (file.size() < sizeof(ELF::Elf_Parent_Ehdr))
+    {
+        ASURA_EXCEPTION("Not an ELF file");
+    }
+
+    const auto header = view_as<const ELF::Elf_Parent_Ehdr*>(file.data());
+
+    std::uint32_t magic;
+    std::memcpy(&magic, header->e_ident, sizeof(magic));
+
+    if (magic != ELF::MAGIC_NUMBER)
+    {
+        ASURA_EXCEPTION("Not an ELF file");
+    }
+
+    switch (header->e_ident[ELF::EI_CLASS])
+    {
+        case ELF::ELFCLASS32:
+            return ParseImage<std::uint32_t>(file);
+        case ELF::ELFCLASS64:
+            return ParseImage<std::uint64_t>(file);
+        default:
+            ASURA_EXCEPTION("Unknown ELF class");
+    }
+}
+
+/**
+ * Calls back with the ranges where both differ, relative to the start.
+ * Equal SIMD values are skipped at once, bytes are only looked at one by
+ * one inside the ones that differ.
+ */
+static auto CompareBytes(const byte_t* const left,
+                         const byte_t* const right,
+                         const std::size_t size,
+                         const auto& callback) -> void
+{
+    constexpr auto simd_size = sizeof(SIMD::value_t);
+    constexpr auto no_diff   = std::numeric_limits<std::size_t>::max();
+
+    auto diff_begin = no_diff;
+
+    const auto compare_byte = [&](const std::size_t i)
+    {
+        if (left[i] != right[i])
+        {
+            if (diff_begin == no_diff)
+            {
+                diff_begin = i;
+            }
+        }
+        else if (diff_begin != no_diff)
+        {
+            callback(diff_begin, i - diff_begin);
+            diff_begin = no_diff;
+        }
+    };
+
+    std::size_t i = 0;
+
+    for (; i + simd_size <= size; i += simd_size)
+    {
+        const auto equal = SIMD::CMPMask8bits(
+                             SIMD::LoadUnaligned(
+                               view_as<const SIMD::value_t*>(left + i)),
+                             SIMD::LoadUnaligned(
+                               view_as<const SIMD::value_t*>(right + i)))
+                           == SIMD::cmp_all;
+
+        if (equal and diff_begin == no_diff)
+        {
+            continue;
+        }
+
+        for (std::size_t j = i; j < i + simd_size; j++)
+        {
+            compare_byte(j);
+        }
+    }
+
+    for (; i < size; i++)
+    {
+        compare_byte(i);
+    }
+
+    if (diff_begin != no_diff)
+    {
+        callback(diff_begin, size - diff_begin);
+    }
+}
+#endif
+
+auto ModuleIntegrity::Check(const Process& process,
+                            const Process::Module& module,
+                            const std::size_t threadsCount) -> Report
+{
+    return CheckModules(process, { module }, threadsCount, false).front();
+}
+
+auto ModuleIntegrity::CheckAll(const Process& process,
+                               const std::size_t threadsCount)
+  -> std::vector<Report>
+{
+    const auto& modules = process.modules();
+
+    return CheckModules(process,
+                        { modules.begin(), modules.end() },
+                        threadsCount,
+                        true);
+}
+
+auto ModuleIntegrity::CheckModules(
+  const Process& process,
+  const std::vector<Process::Module>& modules,
+  const std::size_t threadsCount,
+  const bool skipInvalid) -> std::vector<Report>
+{
+#ifdef WINDOWS
+    (void)process;
+    (void)modules;
+    (void)threadsCount;
+    (void)skipInvalid;
+
+    ASURA_EXCEPTION("Module integrity checks aren't supported on Windows "
+                    "yet");
+#else
+    struct Module
+    {
+        std::unique_ptr<MappedFile> file;
+        Image image;
+        std::uintptr_t load_bias;
+        std::size_t report_index;
+    };
+
+    /* One chunk of one segment */
+    struct Job
+    {
+        const Module* module;
+        const Image::Segment* segment;
+        std::size_t offset;
+        std::size_t size;
+        std::size_t checked_size {};
+        std::size_t ignored_size {};
+        std::vector<Range> diffs {};
+    };
+
+    const auto& mmap = process.mmap();
+
+    std::vector<Report> reports;
+    std::list<Module> checked_modules;
+
+    for (const auto& module : modules)
+    {
+        const auto module_areas = std::find_if(
+          mmap.moduleAreas().begin(),
+          mmap.moduleAreas().end(),
+          [&](const ProcessMemoryMap::ModuleAreas& moduleAreas)
+          {
+              return moduleAreas.path == module.path();
+          });
+
+        try
+        {
+            if (module_areas == mmap.moduleAreas().end())
+            {
+                ASURA_EXCEPTION("Couldn't find the areas of "
+                                + module.path());
+            }
+
+            auto file = std::make_unique<MappedFile>(module_areas->path,
+                                                     module_areas->device,
+                                                     module_areas->inode);
+            auto image = ParseImage(*file);
+
+            const auto load_bias = ELFView::LoadBias(
+              view_as<std::uintptr_t>(module.baseAddress()),
+              image.first_address);
+
+            checked_modules.push_back(
+              { std::move(file), std::move(image), load_bias, reports.size() });
+            reports.push_back({ module, 0, 0, {} });
+        }
+        catch (Exception&)
+        {
+            if (not skipInvalid)
+            {
+                throw;
+            }
+        }
+    }
+
+    std::vector<Job> jobs;
+
+    for (const auto& module : checked_modules)
+    {
+        for (const auto& segment : module.image.segments)
+        {
+            for (std::size_t offset = 0; offset < segment.size;
+                 offset += CHUNK_SIZE)
+            {
+                jobs.push_back(
+                  { &module,
+                    &segment,
+                    offset,
+                    std::min(CHUNK_SIZE, segment.size - offset) });
+            }
+        }
+    }
+
+    const auto run_job = [&](Job& job, bytes_t& memory, bytes_t& expected)
+    {
+        const auto& module   = *job.module;
+        const auto& image    = module.image;
+        const auto& segment  = *job.segment;
+        const auto address   = segment.address + job.offset;
+        const auto end       = address + job.size;
+        const auto bias      = module.load_bias;
+        const auto word_size = image.word_size;
+
+        /* Unreadable memory counts as modified */
+        if (not MemoryUtils::TryReadProcessMemoryArea(process.id(),
+                                                      bias + address,
+                                                      memory.data(),
+                                                      job.size))
+        {
+            job.checked_size = job.size;
+            job.diffs.push_back({ bias + address, job.size });
+            return;
+        }
+
+        if (segment.relocations_only)
+        {
+            std::copy_n(memory.begin(), job.size, expected.begin());
+        }
+        else
+        {
+            job.checked_size = job.size;
+            std::copy_n(module.file->data() + segment.file_offset
+                          + job.offset,
+                        job.size,
+                        expected.begin());
+        }
+
+        /* Relocations can start a bit before the chunk */
+        auto relocation = std::lower_bound(
+          image.relocations.begin(),
+          image.relocations.end(),
+          address - std::min(address, word_size - 1),
+          [](const Image::Relocation& relocation,
+             const std::uintptr_t value)
+          {
+              return relocation.address < value;
+          });
+
+        for (; relocation != image.relocations.end()
+               and relocation->address < end;
+             relocation++)
+        {
+            const auto begin    = std::max(relocation->address, address);
+            const auto last     = std::min(relocation->address + word_size,
+                                           end);
+            const auto value    = bias + relocation->addend;
+            const auto value_at = begin - relocation->address;
+
+            if (not relocation->known)
+            {
+                std::copy(&memory[begin - address],
+                          &memory[last - address],
+                          &expected[begin - address]);
+                job.ignored_size += last - begin;
+                continue;
+            }
+
+            if (segment.relocations_only)
+            {
+                job.checked_size += last - begin;
+            }
+
+            std::memcpy(&expected[begin - address],
+                        view_as<const byte_t*>(&value) + value_at,
+                        last - begin);
+        }
+
+        CompareBytes(memory.data(),
+                     expected.data(),
+                     job.size,
+                     [&](const std::size_t offset, const std::size_t size)
+                     {
+                         job.diffs.push_back(
+                           { bias + address + offset, size });
+                     });
+    };
+
+    const auto threads_count = std::max<std::size_t>(
+      1,
+      std::min<std::size_t>(threadsCount ?
+                              threadsCount :
+                              std::thread::hardware_concurrency(),
+                            jobs.size()));
+
+    std::atomic<std::size_t> next_job = 0;
+    std::vector<std::future<void>> workers;
+
+    for (std::size_t i = 0; i < threads_count; i++)
+    {
+        workers.push_back(std::async(
+          std::launch::async,
+          [&]()
+          {
+              bytes_t memory(CHUNK_SIZE), expected(CHUNK_SIZE);
+
+              for (auto index = next_job++; index < jobs.size();
+                   index      = next_job++)
+              {
+                  run_job(jobs[index], memory, expected);
+              }
+          }));
+    }
+
+    for (auto&& worker : workers)
+    {
+        worker.get();
+    }
+
+    for (const auto& job : jobs)
+    {
+        auto&& report = reports[job.module->report_index];
+
+        report.checked_size += job.checked_size;
+        report.ignored_size += job.ignored_size;
+        report.diffs.insert(report.diffs.end(),
+                            job.diffs.begin(),
+                            job.diffs.end());
+    }
+
+    for (auto&& report : reports)
+    {
+        auto&& diffs = report.diffs;
+
+        std::sort(diffs.begin(),
+                  diffs.end(),
+                  [](const Range& left, const Range& right)
+                  {
+                      return left.address < right.address;
+                  });
+
+        std::vector<Range> merged;
+
+        for (const auto& diff : diffs)
+        {
+            if (not merged.empty()
+                and merged.back().address + merged.back().size
+                      >= diff.address)
+            {
+                merged.back().size = std::max(
+                  merged.back().size,
+                  diff.address + diff.size - merged.back().address);
+                continue;
+            }
+
+            merged.push_back(diff);
+        }
+
+        diffs = std::move(merged);
+    }
+
+    return reports;
+#endif
+}
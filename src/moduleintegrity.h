@@ -0,0 +1,65 @@
+#ifndef ASURA_MODULEINTEGRITY_H
+#define ASURA_MODULEINTEGRITY_H
+
+#include "process.h"
+
+namespace Asura
+{
+    /**
+     * Compares the code and read only data of modules with their file,
+     * to find out what has been patched or hooked:
+     *
+     * for (const auto& report : ModuleIntegrity::CheckAll(process))
+     *     for (const auto& diff : report.diffs)
+     *         ...
+     *
+     * The file is mapped and the read only segments are compared with
+     * the memory of the process, chunk by chunk on every core.
+     * Relative relocations are applied to the file bytes first, the
+     * ones against symbols can't be resolved so the bytes they touch
+     * are left out. RELRO holds data the loader writes too, only its
+     * relocations (vtables, function pointers...) are checked.
+     * ELF only for now.
+     */
+    class ModuleIntegrity
+    {
+      public:
+        static constexpr std::size_t CHUNK_SIZE = 0x40000;
+
+        struct Range
+        {
+            std::uintptr_t address;
+            std::size_t size;
+        };
+
+        struct Report
+        {
+            Process::Module module;
+            std::size_t checked_size {};
+            /* Relocations against symbols */
+            std::size_t ignored_size {};
+            /* Merged when they touch, unreadable memory counts too */
+            std::vector<Range> diffs;
+        };
+
+      public:
+        /* threadsCount at 0 uses every core */
+        static auto Check(const Process& process,
+                          const Process::Module& module,
+                          const std::size_t threadsCount = 0) -> Report;
+
+        /* Modules that aren't ELF files are skipped */
+        static auto CheckAll(const Process& process,
+                             const std::size_t threadsCount = 0)
+          -> std::vector<Report>;
+
+      private:
+        static auto CheckModules(
+          const Process& process,
+          const std::vector<Process::Module>& modules,
+          const std::size_t threadsCount,
+          const bool skipInvalid) -> std::vector<Report>;
+    };
+}
+
+#endif
@@ -24,3 +24,8 @@ void Asura::NetworkWriteBuffer::pos(std::size_t toBit)
 {
     _written_bits = toBit;
 }
+
+std::size_t Asura::NetworkWriteBuffer::writtenBits() const
+{
+    return _written_bits;
+}
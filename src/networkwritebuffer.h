@@ -14,6 +14,7 @@ namespace Asura
 
         void writeBit(bool value);
         void pos(std::size_t toBit = 0);
+        std::size_t writtenBits() const;
 
         template <TypeSize T = type_array>
         auto writeVar(g_v_t<T> var)
@@ -0,0 +1,175 @@
+#ifndef ASURA_OBFUSCATEDSTRING_H
+#define ASURA_OBFUSCATEDSTRING_H
+
+#include "simd.h"
+#include "types.h"
+
+/**
+ * Encrypts a string literal at compile time, with a key unique to the
+ * place where it's written:
+ *
+ * const auto name = ASURA_OBFUSCATED_STRING("libc.so.6").decrypt();
+ * FindModule(name.c_str());
+ *
+ * or, for strings used all the time:
+ *
+ * const std::string& name = ASURA_OBFUSCATED_STRING("libc.so.6").cached();
+ */
+#define ASURA_OBFUSCATED_STRING(string)                                  \
+    ([]() -> const auto&                                                 \
+     {                                                                   \
+         static constexpr Asura::ObfuscatedString<                       \
+           sizeof(string),                                               \
+           Asura::ObfuscationSeed(__FILE__, __LINE__, __COUNTER__)>      \
+           obfuscated(string);                                           \
+         return obfuscated;                                              \
+     }())
+
+namespace Asura
+{
+    consteval auto ObfuscationSeed(const char* file,
+                                   const std::size_t line,
+                                   const std::size_t counter)
+      -> std::uint64_t
+    {
+        /* FNV-1a */
+        std::uint64_t seed = 0xCBF29CE484222325;
+
+        for (; *file != '\0'; file++)
+        {
+            seed = (seed ^ view_as<byte_t>(*file)) * 0x100000001B3;
+        }
+
+        return seed ^ (line << 32) ^ counter;
+    }
+
+    /**
+     * The plain string never reaches the binary, the key schedule is
+     * generated from Seed at compile time and both the key and the
+     * encrypted bytes are padded to whole SIMD values, so decrypting a
+     * short string is two loads and a XOR.
+     * Every string must have its own seed: cached() keeps one copy per
+     * instantiation. Use ASURA_OBFUSCATED_STRING instead of writing the
+     * type.
+     */
+    template <std::size_t N, std::uint64_t Seed>
+    class ObfuscatedString
+    {
+      public:
+        static constexpr std::size_t SIZE = (N + sizeof(SIMD::value_t) - 1)
+                                            / sizeof(SIMD::value_t)
+                                            * sizeof(SIMD::value_t);
+
+        /* Decrypted on the stack, null terminated */
+        class Decrypted
+        {
+            friend class ObfuscatedString;
+
+          public:
+            auto c_str() const -> const char*
+            {
+                return _data.data();
+            }
+
+            auto view() const -> std::string_view
+            {
+                return { _data.data(), N - 1 };
+            }
+
+            auto str() const -> std::string
+            {
+                return std::string(view());
+            }
+
+            operator std::string_view() const
+            {
+                return view();
+            }
+
+          private:
+            alignas(SIMD::value_t) std::array<char, SIZE> _data;
+        };
+
+      public:
+        consteval ObfuscatedString(const char (&string)[N])
+        {
+            for (std::size_t i = 0; i < SIZE; i++)
+            {
+                _encrypted[i] = KEY[i]
+                                ^ (i < N ? view_as<byte_t>(string[i]) : 0);
+            }
+        }
+
+      public:
+        auto decrypt() const -> Decrypted;
+        /* Decrypted once, thread safe */
+        auto cached() const -> const std::string&;
+
+      private:
+        static consteval auto KeySchedule() -> std::array<byte_t, SIZE>
+        {
+            std::array<byte_t, SIZE> key {};
+            std::uint64_t state = Seed;
+
+            for (std::size_t i = 0; i < SIZE; i += sizeof(std::uint64_t))
+            {
+                /* splitmix64 */
+                state += 0x9E3779B97F4A7C15;
+
+                auto random = state;
+                random      = (random ^ (random >> 30)) * 0xBF58476D1CE4E5B9;
+                random      = (random ^ (random >> 27)) * 0x94D049BB133111EB;
+                random      = random ^ (random >> 31);
+
+                for (std::size_t j = 0;
+                     j < sizeof(std::uint64_t) and i + j < SIZE;
+                     j++)
+                {
+                    key[i + j] = view_as<byte_t>(random >> (j * CHAR_BIT));
+                }
+            }
+
+            return key;
+        }
+
+      private:
+        alignas(SIMD::value_t) static constexpr std::array<byte_t, SIZE> KEY
+          = KeySchedule();
+
+        alignas(SIMD::value_t) std::array<byte_t, SIZE> _encrypted {};
+    };
+
+    template <std::size_t N, std::uint64_t Seed>
+    auto ObfuscatedString<N, Seed>::decrypt() const -> Decrypted
+    {
+        Decrypted decrypted;
+
+        auto encrypted = _encrypted.data();
+
+        /**
+         * Hide where the bytes come from, otherwise the compiler sees a
+         * constant XOR a constant and puts the plain string in the
+         * binary.
+         */
+        asm("" : "+r"(encrypted));
+
+        for (std::size_t i = 0; i < SIZE; i += sizeof(SIMD::value_t))
+        {
+            SIMD::StoreUnaligned(
+              view_as<SIMD::value_t*>(&decrypted._data[i]),
+              SIMD::Xor(SIMD::Load(view_as<SIMD::value_t*>(&encrypted[i])),
+                        SIMD::Load(view_as<SIMD::value_t*>(&KEY[i]))));
+        }
+
+        return decrypted;
+    }
+
+    template <std::size_t N, std::uint64_t Seed>
+    auto ObfuscatedString<N, Seed>::cached() const -> const std::string&
+    {
+        static const std::string string = decrypt().str();
+        return string;
+    }
+}
+
+#endif
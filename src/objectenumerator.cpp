@@ -0,0 +1,252 @@
+#include "pch.h"
+
+#include "builtins.h"
+#include "objectenumerator.h"
+#include "simd.h"
+
+using namespace Asura;
+
+/**
+ * One bit per byte of a bucket in, one bit per key out: bit
+ * i * sizeof(std::uintptr_t) is set when all the bytes of the key i are.
+ */
+static auto FullKeys(std::uint64_t bytes) -> std::uint64_t
+{
+    constexpr auto first_bytes = std::numeric_limits<std::uint64_t>::max()
+                                 / ((std::uint64_t { 1 }
+                                     << sizeof(std::uintptr_t))
+                                    - 1);
+
+    for (std::size_t shift = 1; shift < sizeof(std::uintptr_t); shift *= 2)
+    {
+        bytes &= bytes >> shift;
+    }
+
+    return bytes & first_bytes;
+}
+
+ObjectEnumerator::ObjectEnumerator(
+  const std::vector<std::uintptr_t>& vtables)
+ : _vtables(vtables),
+   _next_duplicates(vtables.size(), NOT_FOUND)
+{
+    /* Keep the table at most half full so probing stays short */
+    const auto bucket_count = std::max<std::size_t>(
+      std::bit_ceil((vtables.size() * 2) / BUCKET_SIZE + 1),
+      2);
+
+    _buckets.resize(bucket_count);
+    _hash_shift = (sizeof(std::uint64_t) * CHAR_BIT)
+                  - view_as<std::size_t>(std::countr_zero(bucket_count));
+
+    _lowest_vtable  = std::numeric_limits<std::uintptr_t>::max();
+    _highest_vtable = 0;
+
+    for (std::size_t index = 0; index < _vtables.size(); index++)
+    {
+        const auto vtable = _vtables[index];
+
+        /* null is used for empty slots */
+        if (vtable == 0)
+        {
+            continue;
+        }
+
+        if (auto duplicate = find(vtable); duplicate != NOT_FOUND)
+        {
+            while (_next_duplicates[duplicate] != NOT_FOUND)
+            {
+                duplicate = _next_duplicates[duplicate];
+            }
+
+            _next_duplicates[duplicate] = view_as<std::uint32_t>(index);
+            continue;
+        }
+
+        auto bucket_index = bucketIndex(vtable);
+
+        for (;;)
+        {
+            auto& bucket    = _buckets[bucket_index];
+            const auto slot = std::find(bucket.keys.begin(),
+                                        bucket.keys.end(),
+                                        0);
+
+            if (slot != bucket.keys.end())
+            {
+                *slot = vtable;
+                bucket.indices[std::distance(bucket.keys.begin(), slot)]
+                  = view_as<std::uint32_t>(index);
+                break;
+            }
+
+            bucket_index = (bucket_index + 1) & (_buckets.size() - 1);
+        }
+
+        _lowest_vtable  = std::min(_lowest_vtable, vtable);
+        _highest_vtable = std::max(_highest_vtable, vtable);
+    }
+}
+
+auto ObjectEnumerator::vtables() const
+  -> const std::vector<std::uintptr_t>&
+{
+    return _vtables;
+}
+
+auto ObjectEnumerator::bucketIndex(const std::uintptr_t value) const
+  -> std::size_t
+{
+    /* Fibonacci hashing, vtables are aligned so drop the low bits */
+    return view_as<std::size_t>(
+      ((view_as<std::uint64_t>(value) >> 3) * 0x9E3779B97F4A7C15ull)
+      >> _hash_shift);
+}
+
+auto ObjectEnumerator::find(const std::uintptr_t value) const
+  -> std::uint32_t
+{
+    if (value < _lowest_vtable or value > _highest_vtable)
+    {
+        return NOT_FOUND;
+    }
+
+    SIMD::value_t values;
+    const SIMD::value_t zeros {};
+
+    for (std::size_t i = 0; i < sizeof(values); i += sizeof(value))
+    {
+        std::memcpy(view_as<byte_t*>(&values) + i, &value, sizeof(value));
+    }
+
+    auto bucket_index = bucketIndex(value);
+
+    for (;;)
+    {
+        const auto& bucket = _buckets[bucket_index];
+        const auto keys    = view_as<const byte_t*>(bucket.keys.data());
+
+        /* One bit per byte of the keys */
+        std::uint64_t equal_bytes = 0, empty_bytes = 0;
+
+        for (std::size_t offset = 0; offset < sizeof(bucket.keys);
+             offset += sizeof(SIMD::value_t))
+        {
+            const auto line_part = SIMD::Load(
+              view_as<const SIMD::value_t*>(keys + offset));
+
+            equal_bytes |= view_as<std::uint64_t>(
+                             SIMD::CMPMask8bits(line_part, values))
+                           << offset;
+            empty_bytes |= view_as<std::uint64_t>(
+                             SIMD::CMPMask8bits(line_part, zeros))
+                           << offset;
+        }
+
+        if (const auto found = FullKeys(equal_bytes); found != 0)
+        {
+            return bucket.indices[view_as<std::size_t>(
+                                    Builtins::CTZ(found))
+                                  / sizeof(std::uintptr_t)];
+        }
+
+        if (FullKeys(empty_bytes) != 0)
+        {
+            return NOT_FOUND;
+        }
+
+        bucket_index = (bucket_index + 1) & (_buckets.size() - 1);
+    }
+}
+
+auto ObjectEnumerator::scan(const data_t data,
+                            const std::size_t size,
+                            const ptr_t baseAddress,
+                            instances_t& instances) const -> void
+{
+    const auto count = size / sizeof(std::uintptr_t);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::uintptr_t value;
+        std::memcpy(&value, &data[i * sizeof(value)], sizeof(value));
+
+        if (value < _lowest_vtable or value > _highest_vtable)
+        {
+            continue;
+        }
+
+        for (auto index = find(value); index != NOT_FOUND;
+             index      = _next_duplicates[index])
+        {
+            instances[index].push_back(
+              view_as<ptr_t>(view_as<std::uintptr_t>(baseAddress)
+                             + i * sizeof(value)));
+        }
+    }
+}
+
+auto ObjectEnumerator::scan(const Process& process) const -> instances_t
+{
+    instances_t instances(_vtables.size());
+
+    const auto& mmap     = process.mmap();
+    const auto page_size = MemoryUtils::GetPageSize();
+
+    bytes_t buffer(SCAN_CHUNK_SIZE);
+
+    const auto try_scan = [&](const std::uintptr_t address,
+                              const std::size_t size)
+    {
+        if (not MemoryUtils::TryReadProcessMemoryArea(process.id(),
+                                                      address,
+                                                      buffer.data(),
+                                                      size))
+        {
+            return false;
+        }
+
+        scan(buffer.data(), size, view_as<ptr_t>(address), instances);
+        return true;
+    };
+
+    /* Objects live on the heap, skip modules and read-only areas */
+    for (const auto category : { ProcessMemoryArea::ANONYMOUS,
+                                 ProcessMemoryArea::HEAP,
+                                 ProcessMemoryArea::STACK })
+    {
+        for (const auto& area : mmap.areasByCategory(category))
+        {
+            if (not area->isReadable() or not area->isWritable())
+            {
+                continue;
+            }
+
+            for (std::size_t shift = 0; shift < area->size();
+                 shift += SCAN_CHUNK_SIZE)
+            {
+                const auto address    = area->begin() + shift;
+                const auto chunk_size = std::min(SCAN_CHUNK_SIZE,
+                                                 area->size() - shift);
+
+                if (try_scan(address, chunk_size))
+                {
+                    continue;
+                }
+
+                /**
+                 * Part of the area might have been unmapped since the
+                 * refresh, the other pages can still be read
+                 */
+                for (std::size_t offset = 0; offset < chunk_size;
+                     offset += page_size)
+                {
+                    try_scan(address + offset,
+                             std::min(page_size, chunk_size - offset));
+                }
+            }
+        }
+    }
+
+    return instances;
+}
@@ -0,0 +1,63 @@
+#ifndef ASURA_OBJECTENUMERATOR_H
+#define ASURA_OBJECTENUMERATOR_H
+
+#include "process.h"
+
+namespace Asura
+{
+    /**
+     * Finds every live instance of a set of classes by looking for their
+     * vtable addresses inside writable, anonymous memory.
+     * All classes are searched in the same pass: each aligned pointer
+     * is first range checked, then looked up inside an open addressing
+     * table made of cache line sized buckets, so one lookup compares a
+     * whole line with a few SIMD compares.
+     * The same vtable can be given more than once, every index using it
+     * gets the instances.
+     */
+    class ObjectEnumerator
+    {
+      public:
+        static constexpr std::size_t BUCKET_SIZE = 64
+                                                   / sizeof(std::uintptr_t);
+        static constexpr std::uint32_t NOT_FOUND = std::numeric_limits<
+          std::uint32_t>::max();
+        static constexpr std::size_t SCAN_CHUNK_SIZE = 0x100000;
+
+        struct alignas(64) Bucket
+        {
+            std::array<std::uintptr_t, BUCKET_SIZE> keys {};
+            std::array<std::uint32_t, BUCKET_SIZE> indices {};
+        };
+
+        /* instances[i] are the objects using vtables()[i] */
+        using instances_t = std::vector<std::vector<ptr_t>>;
+
+      public:
+        explicit ObjectEnumerator(
+          const std::vector<std::uintptr_t>& vtables);
+
+      public:
+        auto vtables() const -> const std::vector<std::uintptr_t>&;
+        auto find(const std::uintptr_t value) const -> std::uint32_t;
+        auto scan(const Process& process) const -> instances_t;
+        auto scan(const data_t data,
+                  const std::size_t size,
+                  const ptr_t baseAddress,
+                  instances_t& instances) const -> void;
+
+      private:
+        auto bucketIndex(const std::uintptr_t value) const -> std::size_t;
+
+      private:
+        std::vector<std::uintptr_t> _vtables;
+        std::vector<Bucket> _buckets;
+        /* Next index with the same vtable, or NOT_FOUND */
+        std::vector<std::uint32_t> _next_duplicates;
+        std::uintptr_t _lowest_vtable {};
+        std::uintptr_t _highest_vtable {};
+        std::size_t _hash_shift {};
+    };
+}
+
+#endif
@@ -0,0 +1,324 @@
+#include "pch.h"
+
+#include "packetauthenticator.h"
+
+using namespace Asura;
+
+static auto Load64(const byte_t* data) -> std::uint64_t
+{
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+
+    if constexpr (std::endian::native == std::endian::big)
+    {
+        value = __builtin_bswap64(value);
+    }
+
+    return value;
+}
+
+static auto Store64(byte_t* data, std::uint64_t value) -> void
+{
+    if constexpr (std::endian::native == std::endian::big)
+    {
+        value = __builtin_bswap64(value);
+    }
+
+    std::memcpy(data, &value, sizeof(value));
+}
+
+static inline auto SipRound(std::uint64_t& v0,
+                            std::uint64_t& v1,
+                            std::uint64_t& v2,
+                            std::uint64_t& v3) -> void
+{
+    v0 += v1;
+    v1  = std::rotl(v1, 13);
+    v1 ^= v0;
+    v0  = std::rotl(v0, 32);
+    v2 += v3;
+    v3  = std::rotl(v3, 16);
+    v3 ^= v2;
+    v0 += v3;
+    v3  = std::rotl(v3, 21);
+    v3 ^= v0;
+    v2 += v1;
+    v1  = std::rotl(v1, 17);
+    v1 ^= v2;
+    v2  = std::rotl(v2, 32);
+}
+
+/* Unrolled over the lanes, so their states stay in registers */
+template <std::size_t L>
+static inline auto Compress(std::array<std::uint64_t, L>& v0,
+                            std::array<std::uint64_t, L>& v1,
+                            std::array<std::uint64_t, L>& v2,
+                            std::array<std::uint64_t, L>& v3,
+                            const std::array<std::uint64_t, L>& messages)
+  -> void
+{
+    [&]<std::size_t... lanes>(std::index_sequence<lanes...>)
+    {
+        ((v3[lanes] ^= messages[lanes]), ...);
+        (SipRound(v0[lanes], v1[lanes], v2[lanes], v3[lanes]), ...);
+        (SipRound(v0[lanes], v1[lanes], v2[lanes], v3[lanes]), ...);
+        ((v0[lanes] ^= messages[lanes]), ...);
+    }(std::make_index_sequence<L>());
+}
+
+/**
+ * SipHash-2-4 of L messages at once, in lock step for the blocks they
+ * all have. One SipHash is a long chain of dependent instructions, the
+ * CPU runs the independent lanes side by side while each one waits.
+ */
+template <std::size_t L>
+static auto SipHashLanes(const std::array<std::uint64_t, 2>& key,
+                         const std::array<const byte_t*, L>& datas,
+                         const std::array<std::size_t, L>& sizes)
+  -> std::array<std::uint64_t, L>
+{
+    constexpr auto block_size = sizeof(std::uint64_t);
+
+    std::array<std::uint64_t, L> v0, v1, v2, v3, messages, result;
+
+    for (std::size_t lane = 0; lane < L; lane++)
+    {
+        v0[lane] = key[0] ^ 0x736F6D6570736575;
+        v1[lane] = key[1] ^ 0x646F72616E646F6D;
+        v2[lane] = key[0] ^ 0x6C7967656E657261;
+        v3[lane] = key[1] ^ 0x7465646279746573;
+    }
+
+    const auto common_blocks = *std::min_element(sizes.begin(),
+                                                 sizes.end())
+                               / block_size;
+
+    for (std::size_t block = 0; block < common_blocks; block++)
+    {
+        for (std::size_t lane = 0; lane < L; lane++)
+        {
+            messages[lane] = Load64(&datas[lane][block * block_size]);
+        }
+
+        Compress(v0, v1, v2, v3, messages);
+    }
+
+    /* What's left is different for each lane */
+    for (std::size_t lane = 0; lane < L; lane++)
+    {
+        std::array<std::uint64_t, 1> s0 { v0[lane] }, s1 { v1[lane] },
+          s2 { v2[lane] }, s3 { v3[lane] };
+
+        const auto blocks = sizes[lane] / block_size;
+
+        for (std::size_t block = common_blocks; block < blocks; block++)
+        {
+            Compress(s0,
+                     s1,
+                     s2,
+                     s3,
+                     { Load64(&datas[lane][block * block_size]) });
+        }
+
+        /* Last bytes and the size */
+        auto last = view_as<std::uint64_t>(sizes[lane]) << 56;
+
+        for (std::size_t i = 0; i < sizes[lane] % block_size; i++)
+        {
+            last |= view_as<std::uint64_t>(
+                      datas[lane][blocks * block_size + i])
+                    << (i * CHAR_BIT);
+        }
+
+        Compress(s0, s1, s2, s3, { last });
+
+        s2[0] ^= 0xFF;
+
+        for (int i = 0; i < 4; i++)
+        {
+            SipRound(s0[0], s1[0], s2[0], s3[0]);
+        }
+
+        result[lane] = s0[0] ^ s1[0] ^ s2[0] ^ s3[0];
+    }
+
+    return result;
+}
+
+PacketAuthenticator::PacketAuthenticator(const key_t& key)
+ : _key { Load64(&key[0]), Load64(&key[sizeof(std::uint64_t)]) }
+{
+}
+
+auto PacketAuthenticator::SipHash(const key_t& key,
+                                  const byte_t* data,
+                                  const std::size_t size) -> std::uint64_t
+{
+    return SipHashLanes<1>({ Load64(&key[0]),
+                             Load64(&key[sizeof(std::uint64_t)]) },
+                           { data },
+                           { size })[0];
+}
+
+auto PacketAuthenticator::sign(NetworkWriteBuffer& buffer) -> void
+{
+    const auto size = (buffer.writtenBits() + CHAR_BIT - 1) / CHAR_BIT;
+
+    if (size + OVERHEAD > buffer.maxSize())
+    {
+        ASURA_EXCEPTION("No room left for the tag");
+    }
+
+    Store64(&buffer.data()[size], ++_send_sequence);
+    Store64(&buffer.data()[size + SEQUENCE_SIZE],
+            SipHashLanes<1>(_key,
+                            { buffer.data() },
+                            { size + SEQUENCE_SIZE })[0]);
+
+    buffer.pos((size + OVERHEAD) * CHAR_BIT);
+}
+
+auto PacketAuthenticator::verify(NetworkReadBuffer& buffer) -> Status
+{
+    if (buffer.maxSize() < OVERHEAD)
+    {
+        return Status::too_short;
+    }
+
+    return finish(buffer,
+                  SipHashLanes<1>(_key,
+                                  { buffer.data() },
+                                  { buffer.maxSize() - TAG_SIZE })[0]);
+}
+
+#ifndef WINDOWS
+auto PacketAuthenticator::verify(std::span<UDPTransport::Packet> packets,
+                                 std::span<Status> statuses)
+  -> std::size_t
+{
+    if (statuses.size() < packets.size())
+    {
+        ASURA_EXCEPTION("Not enough statuses for the packets");
+    }
+
+    std::array<std::size_t, LANES> lanes;
+    std::size_t lanes_count = 0;
+    std::size_t valid_count = 0;
+
+    const auto finish_packet = [&](const std::size_t index,
+                                   const std::uint64_t tag)
+    {
+        auto&& packet     = packets[index];
+        statuses[index]   = finish(packet.buffer, tag);
+        packet.size       = packet.buffer.maxSize();
+        valid_count      += statuses[index] == Status::valid;
+    };
+
+    const auto hash_lanes = [&]()
+    {
+        if (lanes_count == LANES)
+        {
+            std::array<const byte_t*, LANES> datas;
+            std::array<std::size_t, LANES> sizes;
+
+            for (std::size_t i = 0; i < LANES; i++)
+            {
+                datas[i] = packets[lanes[i]].buffer.data();
+                sizes[i] = packets[lanes[i]].buffer.maxSize() - TAG_SIZE;
+            }
+
+            const auto tags = SipHashLanes<LANES>(_key, datas, sizes);
+
+            for (std::size_t i = 0; i < LANES; i++)
+            {
+                finish_packet(lanes[i], tags[i]);
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < lanes_count; i++)
+            {
+                const auto& buffer = packets[lanes[i]].buffer;
+
+                finish_packet(lanes[i],
+                              SipHashLanes<1>(_key,
+                                              { buffer.data() },
+                                              { buffer.maxSize()
+                                                - TAG_SIZE })[0]);
+            }
+        }
+
+        lanes_count = 0;
+    };
+
+    for (std::size_t i = 0; i < packets.size(); i++)
+    {
+        if (packets[i].buffer.maxSize() < OVERHEAD)
+        {
+            statuses[i] = Status::too_short;
+            continue;
+        }
+
+        lanes[lanes_count++] = i;
+
+        if (lanes_count == LANES)
+        {
+            hash_lanes();
+        }
+    }
+
+    hash_lanes();
+
+    return valid_count;
+}
+#endif
+
+auto PacketAuthenticator::finish(NetworkReadBuffer& buffer,
+                                 const std::uint64_t tag) -> Status
+{
+    const auto size = buffer.maxSize() - OVERHEAD;
+
+    if (Load64(&buffer.data()[size + SEQUENCE_SIZE]) != tag)
+    {
+        return Status::bad_tag;
+    }
+
+    if (not accept(Load64(&buffer.data()[size])))
+    {
+        return Status::replayed;
+    }
+
+    buffer = NetworkReadBuffer(buffer.data(), size);
+
+    return Status::valid;
+}
+
+auto PacketAuthenticator::accept(const std::uint64_t sequence) -> bool
+{
+    /* Never sent, the first sequence is 1 */
+    if (sequence == 0)
+    {
+        return false;
+    }
+
+    if (sequence > _highest_sequence)
+    {
+        const auto shift  = sequence - _highest_sequence;
+        _window           = shift >= WINDOW_SIZE ? 0 : _window << shift;
+        _window          |= 1;
+        _highest_sequence = sequence;
+
+        return true;
+    }
+
+    const auto age = _highest_sequence - sequence;
+
+    if (age >= WINDOW_SIZE or (_window & (1ull << age)))
+    {
+        return false;
+    }
+
+    _window |= 1ull << age;
+
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef ASURA_PACKETAUTHENTICATOR_H
+#define ASURA_PACKETAUTHENTICATOR_H
+
+#include "networkreadbuffer.h"
+#include "networkwritebuffer.h"
+#include "udptransport.h"
+
+namespace Asura
+{
+    /**
+     * Authenticates packets with a SipHash-2-4 tag, written in place
+     * after the payload:
+     *
+     * [payload][sequence, 8 bytes][tag, 8 bytes]
+     *
+     * The tag covers the payload and the sequence, the sequence is
+     * checked against a sliding window of the last WINDOW_SIZE packets
+     * so a packet can't be replayed, even when packets arrive out of
+     * order.
+     * One authenticator per peer and per direction, with a key for each
+     * direction, otherwise our own packets could be sent back to us.
+     */
+    class PacketAuthenticator
+    {
+      public:
+        static constexpr std::size_t KEY_SIZE      = 16;
+        static constexpr std::size_t SEQUENCE_SIZE = sizeof(std::uint64_t);
+        static constexpr std::size_t TAG_SIZE      = sizeof(std::uint64_t);
+        static constexpr std::size_t OVERHEAD = SEQUENCE_SIZE + TAG_SIZE;
+        static constexpr std::size_t WINDOW_SIZE = 64;
+        /**
+         * Packets hashed together when verifying a batch, more don't
+         * fit in the registers.
+         */
+        static constexpr std::size_t LANES = 2;
+
+        using key_t = std::array<byte_t, KEY_SIZE>;
+
+        enum class Status
+        {
+            valid,
+            too_short,
+            bad_tag,
+            replayed
+        };
+
+      public:
+        explicit PacketAuthenticator(const key_t& key);
+
+      public:
+        static auto SipHash(const key_t& key,
+                            const byte_t* data,
+                            const std::size_t size) -> std::uint64_t;
+
+      public:
+        /**
+         * Appends the sequence and the tag after the written bits,
+         * rounded up to a byte, and moves the position after them.
+         */
+        auto sign(NetworkWriteBuffer& buffer) -> void;
+        /* When valid, buffer is shrunk to the payload */
+        auto verify(NetworkReadBuffer& buffer) -> Status;
+#ifndef WINDOWS
+        /**
+         * Same for a batch from UDPTransport::receive, returns the count
+         * of valid packets. statuses must be as big as packets.
+         */
+        auto verify(std::span<UDPTransport::Packet> packets,
+                    std::span<Status> statuses) -> std::size_t;
+#endif
+
+      private:
+        /* Compares with the computed tag, then checks the window */
+        auto finish(NetworkReadBuffer& buffer, const std::uint64_t tag)
+          -> Status;
+        auto accept(const std::uint64_t sequence) -> bool;
+
+      private:
+        std::array<std::uint64_t, 2> _key;
+        std::uint64_t _send_sequence {};
+        std::uint64_t _highest_sequence {};
+        /* Bit n set when _highest_sequence - n was received */
+        std::uint64_t _window {};
+    };
+}
+
+#endif
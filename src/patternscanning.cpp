@@ -2,17 +2,138 @@
 
 #include "builtins.h"
 #include "exception.h"
+#include "memoryresource.h"
 #include "memoryutils.h"
 #include "patternbyte.h"
 #include "patternscanning.h"
+#include "peimage.h"
 #include "simd.h"
 
+/**
+ * When every byte of the pattern can be a zero, a match can sit entirely
+ * inside empty pages, so they can't be skipped.
+ */
+static auto CanOnlyMatchZeros(const Asura::PatternByte& pattern) -> bool
+{
+    return std::all_of(pattern.bytes().begin(),
+                       pattern.bytes().end(),
+                       [](const Asura::PatternByte::Value& value)
+                       {
+                           return value.value
+                                    == Asura::PatternByte::Value::UNKNOWN
+                                  or value.value == 0;
+                       });
+}
+
+/* Kept simple so it gets vectorized */
+static auto IsZeroPage(const Asura::byte_t* const page,
+                       const std::size_t size) -> bool
+{
+    std::uint64_t accumulator = 0;
+
+    for (std::size_t i = 0; i < size; i += sizeof(accumulator))
+    {
+        std::uint64_t value;
+        std::memcpy(&value, &page[i], sizeof(value));
+        accumulator |= value;
+    }
+
+    return accumulator == 0;
+}
+
+template <typename F>
+static auto ForEachAreaWithName(const Asura::ProcessMemoryMap& mmap,
+                                const std::string& areaName,
+                                F&& callback) -> void
+{
+    /* Names are compared once per module, not once per area */
+    for (const auto& module_areas : mmap.moduleAreas())
+    {
+        if (module_areas.path.find(areaName) != std::string::npos)
+        {
+            for (const auto& area : module_areas.areas)
+            {
+                callback(*area);
+            }
+        }
+    }
+
+    /* [heap], [stack], [anon:name]... */
+    for (const auto category : { Asura::ProcessMemoryArea::ANONYMOUS,
+                                 Asura::ProcessMemoryArea::HEAP,
+                                 Asura::ProcessMemoryArea::STACK,
+                                 Asura::ProcessMemoryArea::SPECIAL })
+    {
+        for (const auto& area : mmap.areasByCategory(category))
+        {
+            if (area->inode() == 0
+                and area->name().find(areaName) != std::string::npos)
+            {
+                callback(*area);
+            }
+        }
+    }
+}
+
+/**
+ * Reads what a file-backed area maps from the file, as long as the file
+ * at its path is still the one that got mapped. Past the end of the
+ * file it's zeros, like in memory.
+ */
+static auto ReadMappedFile(const Asura::ProcessMemoryArea& area,
+                           const Asura::data_t buffer) -> bool
+{
+#ifdef WINDOWS
+    return false;
+#else
+    const auto fd = open(area.name().c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) < 0 or file_stat.st_dev != area.device()
+        or file_stat.st_ino != area.inode())
+    {
+        close(fd);
+        return false;
+    }
+
+    std::size_t done = 0;
+
+    while (done < area.size())
+    {
+        const auto ret = pread(fd,
+                               buffer + done,
+                               area.size() - done,
+                               Asura::view_as<off_t>(area.offset() + done));
+
+        if (ret <= 0)
+        {
+            break;
+        }
+
+        done += Asura::view_as<std::size_t>(ret);
+    }
+
+    close(fd);
+
+    std::fill(buffer + done, buffer + area.size(), 0);
+
+    return true;
+#endif
+}
+
 auto Asura::PatternScanning::searchInProcess(
   PatternByte& pattern,
   const Process& process,
   const std::function<
     auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
-      ->bool>& searchMethod) -> void
+      ->bool>& searchMethod,
+  const bool skipEmptyPages) -> void
 {
     const auto& mmap      = process.mmap();
     const auto& area_name = pattern.areaName();
@@ -21,21 +142,16 @@ auto Asura::PatternScanning::searchInProcess(
     {
         for (const auto& area : mmap.areas())
         {
-            if (area->isReadable())
-            {
-                const auto area_read = area->readAligned<SIMD::value_t>();
-
-                searchMethod(pattern,
-                             view_as<data_t>(area_read.data()
-                                             + sizeof(SIMD::value_t)),
-                             area->size(),
-                             area->begin<ptr_t>());
-            }
+            searchInArea(pattern, *area, searchMethod, skipEmptyPages);
         }
     }
     else
     {
-        searchInProcessWithAreaName(pattern, process, area_name);
+        searchInProcessWithAreaName(pattern,
+                                    process,
+                                    area_name,
+                                    searchMethod,
+                                    skipEmptyPages);
     }
 }
 
@@ -45,25 +161,432 @@ auto Asura::PatternScanning::searchInProcessWithAreaName(
   const std::string& areaName,
   const std::function<
     auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
-      ->bool>& searchMethod) -> void
+      ->bool>& searchMethod,
+  const bool skipEmptyPages) -> void
+{
+    ForEachAreaWithName(process.mmap(),
+                        areaName,
+                        [&](const ProcessMemoryArea& area)
+                        {
+                            searchInArea(pattern,
+                                         area,
+                                         searchMethod,
+                                         skipEmptyPages);
+                        });
+}
+
+auto Asura::PatternScanning::searchInArea(
+  PatternByte& pattern,
+  const ProcessMemoryArea& area,
+  const std::function<
+    auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
+      ->bool>& searchMethod,
+  const bool skipEmptyPages) -> void
+{
+    constexpr auto simd_size = sizeof(SIMD::value_t);
+
+    if (not area.isReadable() or pattern.bytes().empty())
+    {
+        return;
+    }
+
+    const auto page_size    = MemoryUtils::GetPageSize();
+    const auto page_count   = area.size() / page_size;
+    const auto pattern_size = pattern.bytes().size();
+
+    /**
+     * A match can run over at most pad bytes of the empty pages around
+     * the data, they're zeros so they don't need to be read.
+     * Bigger patterns could reach the next non-empty page, so they go
+     * through the whole area.
+     */
+    const auto pad        = pattern_size - 1;
+    const auto skip_pages = skipEmptyPages and pad < page_size
+                            and not CanOnlyMatchZeros(pattern);
+
+    const auto resident = skip_pages and area.inode() == 0 ?
+                            MemoryUtils::ResidentPages(
+                              area.processBase().id(),
+                              area.begin(),
+                              area.size()) :
+                            std::vector<bool>(page_count, true);
+
+    auto&& matches                = pattern.matches();
+    std::ptrdiff_t reported_limit = 0;
+    pmr_bytes_t buffer(MemoryResource::current());
+
+    /**
+     * Runs of resident pages are read straight into the scan buffer,
+     * between lead and tail zeroed bytes that stand for the padding.
+     * The search methods never start a match inside the first SIMD
+     * value and can load a bit past the end, so there's one more
+     * zeroed SIMD value on each side.
+     */
+    const auto lead = simd_size
+                      + MemoryUtils::AlignToPageSize(pad, simd_size);
+    const auto tail = pad + simd_size * 2;
+
+    data_t run_data     = nullptr;
+    std::size_t run_pos = 0;
+
+    const auto search_segment = [&](const std::size_t begin,
+                                    const std::size_t end)
+    {
+        const auto ext_begin = begin - std::min(begin, pad);
+        const auto ext_end   = std::min(end + pad, area.size());
+
+        /**
+         * Outside of ext_begin and ext_end the window can hold other
+         * bytes of the run, the matches there are dropped below.
+         */
+        const auto window = (lead + ext_begin - run_pos) / simd_size
+                              * simd_size
+                            - simd_size;
+        const auto scan_data = run_data - lead + window;
+        const auto scan_size = MemoryUtils::AlignToPageSize(
+          lead + ext_end - run_pos - window,
+          simd_size);
+
+        const auto first_new_match = matches.size();
+
+        searchMethod(pattern,
+                     scan_data,
+                     scan_size,
+                     view_as<ptr_t>(area.begin() + run_pos + window
+                                    - lead));
+
+        /**
+         * Drop matches over the padding, and the ones the previous
+         * segment already reported when both are one empty page apart.
+         */
+        const auto lowest_offset = std::max(view_as<std::ptrdiff_t>(
+                                              ext_begin),
+                                            reported_limit);
+
+        matches.erase(
+          std::remove_if(
+            matches.begin() + first_new_match,
+            matches.end(),
+            [&](const ptr_t match)
+            {
+                const auto offset = view_as<std::ptrdiff_t>(
+                  view_as<std::uintptr_t>(match) - area.begin());
+
+                return offset < lowest_offset
+                       or offset + view_as<std::ptrdiff_t>(pattern_size)
+                            > view_as<std::ptrdiff_t>(ext_end);
+            }),
+          matches.end());
+
+        reported_limit = view_as<std::ptrdiff_t>(ext_end)
+                         - view_as<std::ptrdiff_t>(pad);
+    };
+
+    std::size_t page = 0;
+
+    while (page < page_count)
+    {
+        if (not resident[page])
+        {
+            page++;
+            continue;
+        }
+
+        /* Read every resident page in a row at once */
+        const auto run_begin = page;
+
+        while (page < page_count and resident[page])
+        {
+            page++;
+        }
+
+        const auto run_size = (page - run_begin) * page_size;
+
+        buffer.resize(
+          std::max(buffer.size(), simd_size + lead + run_size + tail));
+
+        run_pos  = run_begin * page_size;
+        run_data = view_as<data_t>(
+                     MemoryUtils::AlignToPageSize(view_as<std::uintptr_t>(
+                                                    buffer.data()),
+                                                  simd_size))
+                   + lead;
+
+        std::fill_n(run_data - lead, lead, 0);
+        std::fill_n(run_data + run_size, tail, 0);
+        area.readInto(run_data, run_size, run_pos);
+
+        if (not skip_pages)
+        {
+            search_segment(run_pos, run_pos + run_size);
+            continue;
+        }
+
+        std::size_t run_page = 0;
+        const auto run_pages = page - run_begin;
+
+        while (run_page < run_pages)
+        {
+            if (IsZeroPage(&run_data[run_page * page_size], page_size))
+            {
+                run_page++;
+                continue;
+            }
+
+            const auto segment_begin = run_page;
+
+            while (run_page < run_pages
+                   and not IsZeroPage(&run_data[run_page * page_size],
+                                      page_size))
+            {
+                run_page++;
+            }
+
+            search_segment(run_pos + segment_begin * page_size,
+                           run_pos + run_page * page_size);
+        }
+    }
+}
+
+auto Asura::PatternScanning::searchInProcesses(
+  PatternByte& pattern,
+  const std::vector<Process>& processes,
+  const std::function<
+    auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
+      ->bool>& searchMethod,
+  const bool readFromFiles,
+  const bool skipEmptyPages) -> std::vector<std::vector<ptr_t>>
 {
-    const auto& mmap = process.mmap();
+    constexpr auto simd_size = sizeof(SIMD::value_t);
+
+    struct SharedArea
+    {
+        /* The one that gets scanned */
+        const ProcessMemoryArea* area {};
+        /* Process index and address of every copy */
+        std::vector<std::tuple<std::size_t, std::uintptr_t>> copies;
+    };
+
+    /* (device, inode, offset, size, protection) */
+    std::map<std::tuple<std::uint64_t,
+                        std::uint64_t,
+                        std::uintptr_t,
+                        std::size_t,
+                        mapf_t>,
+             SharedArea>
+      shared_areas;
+
+    std::vector<std::vector<const ProcessMemoryArea*>> private_areas(
+      processes.size());
+
+    for (std::size_t i = 0; i < processes.size(); i++)
+    {
+        const auto add_area = [&](const ProcessMemoryArea& area)
+        {
+            if (not area.isReadable())
+            {
+                return;
+            }
+
+            if (area.category() != ProcessMemoryArea::FILE_BACKED
+                or area.isWritable()
+                or MemoryUtils::HasPrivatePages(processes[i].id(),
+                                                area.begin(),
+                                                area.size()))
+            {
+                private_areas[i].push_back(&area);
+                return;
+            }
+
+            auto&& shared_area = shared_areas[{
+              area.device(),
+              area.inode(),
+              area.offset(),
+              area.size(),
+              area.protectionFlags().cachedValue() }];
+
+            if (not shared_area.area)
+            {
+                shared_area.area = &area;
+            }
+
+            shared_area.copies.emplace_back(i, area.begin());
+        };
+
+        const auto& mmap = processes[i].mmap();
+
+        if (pattern.areaName().empty())
+        {
+            for (const auto& area : mmap.areas())
+            {
+                add_area(*area);
+            }
+        }
+        else
+        {
+            ForEachAreaWithName(mmap, pattern.areaName(), add_area);
+        }
+    }
+
+    std::vector<std::vector<ptr_t>> results(processes.size());
+
+    auto&& matches          = pattern.matches();
+    const auto old_matches  = std::exchange(matches, {});
+    const auto pattern_size = pattern.bytes().size();
 
-    for (const auto& area : mmap.areas())
+    /**
+     * Same layout as searchInArea, one zeroed SIMD value on each side
+     * of the data.
+     */
+    const auto search_in_file = [&](const ProcessMemoryArea& area)
     {
-        if (area->isReadable()
-            and (area->name().find(areaName) != std::string::npos))
+        const auto scan_size = MemoryUtils::AlignToPageSize(
+          simd_size + area.size(),
+          simd_size);
+
+        pmr_bytes_t buffer(scan_size + simd_size * 3,
+                           MemoryResource::current());
+
+        const auto scan_data = view_as<data_t>(
+          MemoryUtils::AlignToPageSize(view_as<std::uintptr_t>(
+                                         buffer.data()),
+                                       simd_size));
+
+        if (not ReadMappedFile(area, scan_data + simd_size))
         {
-            const auto area_read = area->readAligned<SIMD::value_t>();
+            return false;
+        }
 
-            searchMethod(pattern,
-                         view_as<data_t>(area_read.data()
-                                         + sizeof(SIMD::value_t)),
-                         area->size(),
-                         area->begin<ptr_t>());
+        searchMethod(pattern,
+                     scan_data,
+                     scan_size,
+                     view_as<ptr_t>(area.begin() - simd_size));
+
+        matches.erase(std::remove_if(matches.begin(),
+                                     matches.end(),
+                                     [&](const ptr_t match)
+                                     {
+                                         return view_as<std::uintptr_t>(
+                                                  match)
+                                                  + pattern_size
+                                                > area.end();
+                                     }),
+                      matches.end());
+
+        return true;
+    };
+
+    for (const auto& [key, shared_area] : shared_areas)
+    {
+        const auto& area = *shared_area.area;
+
+        if (not readFromFiles or not search_in_file(area))
+        {
+            searchInArea(pattern, area, searchMethod, skipEmptyPages);
         }
+
+        for (const auto& [index, begin] : shared_area.copies)
+        {
+            for (const auto match : matches)
+            {
+                results[index].push_back(view_as<ptr_t>(
+                  begin + (view_as<std::uintptr_t>(match) - area.begin())));
+            }
+        }
+
+        matches.clear();
+    }
+
+    for (std::size_t i = 0; i < processes.size(); i++)
+    {
+        for (const auto area : private_areas[i])
+        {
+            searchInArea(pattern, *area, searchMethod, skipEmptyPages);
+        }
+
+        results[i].insert(results[i].end(), matches.begin(), matches.end());
+        matches.clear();
     }
+
+    matches = old_matches;
+
+    for (auto&& process_matches : results)
+    {
+        std::sort(process_matches.begin(), process_matches.end());
+    }
+
+    return results;
+}
+
+#ifndef WINDOWS
+auto Asura::PatternScanning::searchInPEImage(
+  PatternByte& pattern,
+  const PEImage& image,
+  const std::function<
+    auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
+      ->bool>& searchMethod,
+  const std::string& sectionName) -> bool
+{
+    constexpr auto simd_size = sizeof(SIMD::value_t);
+
+    auto&& matches              = pattern.matches();
+    const auto old_matches_size = matches.size();
+    const auto pattern_size     = pattern.bytes().size();
+
+    if (pattern_size == 0)
+    {
+        return false;
+    }
+
+    for (const auto& section : image.sections())
+    {
+        if (section.size == 0
+            or (not sectionName.empty() and section.name != sectionName))
+        {
+            continue;
+        }
+
+        const auto begin = view_as<std::size_t>(section.rva);
+        const auto end   = begin + section.size;
+
+        /**
+         * Straight from the image, the search methods never start a
+         * match inside the first SIMD value and can load a bit past the
+         * end, the zeroed pages around the image cover both.
+         */
+        const auto scan_begin = begin - begin % simd_size;
+        const auto scan_size  = MemoryUtils::AlignToPageSize(
+          simd_size + end - scan_begin,
+          simd_size);
+
+        const auto first_new_match = matches.size();
+
+        searchMethod(pattern,
+                     view_as<data_t>(image.data() + scan_begin
+                                     - simd_size),
+                     scan_size,
+                     view_as<ptr_t>(image.imageBase() + scan_begin
+                                    - simd_size));
+
+        /* Drop matches outside of the section */
+        matches.erase(
+          std::remove_if(matches.begin() + first_new_match,
+                         matches.end(),
+                         [&](const ptr_t match)
+                         {
+                             const auto offset = view_as<std::uintptr_t>(
+                                                   match)
+                                                 - image.imageBase();
+
+                             return offset < begin
+                                    or offset + pattern_size > end;
+                         }),
+          matches.end());
+    }
+
+    return matches.size() != old_matches_size;
 }
+#endif
 
 auto Asura::PatternScanning::searchV1(PatternByte& pattern,
                                       const data_t data,
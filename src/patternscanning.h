@@ -1,22 +1,31 @@
 #ifndef ASURA_PATTERNSCANNING_H
 #define ASURA_PATTERNSCANNING_H
 
+#include "memoryresource.h"
 #include "process.h"
+#include "xkc.h"
 
 namespace Asura
 {
     class PatternByte;
+    class PEImage;
 
     class PatternScanning
     {
       public:
+        /**
+         * With skipEmptyPages, pages that were never touched and pages
+         * filled with zeros are not scanned, unless every byte of the
+         * pattern could match a zero.
+         */
         static auto searchInProcess(
           PatternByte& pattern,
           const Process& process,
           const std::function<
             auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
               ->bool>& searchMethod
-          = searchV4) -> void;
+          = searchV4,
+          const bool skipEmptyPages = true) -> void;
 
         static auto searchInProcessWithAreaName(
           PatternByte& pattern,
@@ -25,7 +34,56 @@ namespace Asura
           const std::function<
             auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
               ->bool>& searchMethod
-          = searchV4) -> void;
+          = searchV4,
+          const bool skipEmptyPages = true) -> void;
+
+        static auto searchInArea(
+          PatternByte& pattern,
+          const ProcessMemoryArea& area,
+          const std::function<
+            auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
+              ->bool>& searchMethod
+          = searchV4,
+          const bool skipEmptyPages = true) -> void;
+
+        /**
+         * Searches many processes running the same binaries, returns
+         * the matches of each process, in the same order.
+         * Read only areas mapping the same part of the same file with
+         * the same protection are scanned once, the matches are moved to
+         * where the area is in every other process. Anonymous and
+         * writable areas, and file-backed areas with pages copied on
+         * write, are still scanned in each process.
+         * With readFromFiles, the shared areas are read from their file
+         * instead of the memory of a process.
+         * pattern.matches() is left as it was.
+         */
+        static auto searchInProcesses(
+          PatternByte& pattern,
+          const std::vector<Process>& processes,
+          const std::function<
+            auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
+              ->bool>& searchMethod
+          = searchV4,
+          const bool readFromFiles  = false,
+          const bool skipEmptyPages = true)
+          -> std::vector<std::vector<ptr_t>>;
+
+#ifndef WINDOWS
+        /**
+         * Searches the sections of a PE image, or only the one named
+         * sectionName, in place without copying them. Matches are
+         * addresses in the image based at its preferred ImageBase.
+         */
+        static auto searchInPEImage(
+          PatternByte& pattern,
+          const PEImage& image,
+          const std::function<
+            auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
+              ->bool>& searchMethod
+          = searchV4,
+          const std::string& sectionName = "") -> bool;
+#endif
 
         /**
          * This works by making the preprocessed pattern into simd
@@ -106,6 +164,162 @@ namespace Asura
                                     const data_t alignedData,
                                     const std::size_t size,
                                     const ptr_t baseAddress) -> bool;
+
+      public:
+        static constexpr std::size_t XKC_WINDOW_SIZE = 0x100000;
+
+        /**
+         * Searches inside a XKC encoded stream without decoding it
+         * entirely. The stream is decoded window by window, each
+         * window starting with the end of the previous one so patterns
+         * crossing a boundary are still found, and the next window is
+         * decoded while the current one is being scanned.
+         * Matches are relative to baseAddress, like the other search
+         * methods.
+         */
+        template <XKCAlphabetType T = byte_t>
+        static auto searchInXKC(
+          PatternByte& pattern,
+          const data_t data,
+          const std::size_t size,
+          const ptr_t baseAddress = nullptr,
+          const std::function<
+            auto(PatternByte&, const data_t, const std::size_t, const ptr_t)
+              ->bool>& searchMethod = searchV4,
+          const std::size_t windowSize = XKC_WINDOW_SIZE) -> bool
+        {
+            constexpr auto simd_size = sizeof(SIMD::value_t);
+
+            auto&& matches              = pattern.matches();
+            const auto old_matches_size = matches.size();
+            const auto pattern_size     = view_as<std::ptrdiff_t>(
+              pattern.bytes().size());
+
+            /**
+             * The search methods never start a match inside the first
+             * SIMD value of the data, so the overlap covers it too.
+             */
+            const auto overlap = MemoryUtils::AlignToPageSize(
+              view_as<std::size_t>(pattern_size) - 1 + simd_size,
+              simd_size);
+
+            const auto window_size = std::max(
+              MemoryUtils::AlignToPageSize(windowSize, simd_size),
+              overlap * 2);
+
+            /**
+             * At least one more SIMD value on each side, the search
+             * methods can load a bit outside of the data.
+             */
+            std::array<pmr_bytes_t, 2> buffers {
+                pmr_bytes_t(window_size + simd_size * 3,
+                            MemoryResource::current()),
+                pmr_bytes_t(window_size + simd_size * 3,
+                            MemoryResource::current())
+            };
+
+            const auto window_start = [](pmr_bytes_t& buffer)
+            {
+                return view_as<data_t>(MemoryUtils::AlignToPageSize(
+                  view_as<std::uintptr_t>(buffer.data()) + simd_size,
+                  simd_size));
+            };
+
+            auto current_window = window_start(buffers[0]);
+            auto next_window    = window_start(buffers[1]);
+
+            typename XKC<T>::Decoder decoder(data, size);
+
+            /* The first window starts with a zeroed overlap */
+            auto window_offset = -view_as<std::ptrdiff_t>(overlap);
+            std::ptrdiff_t reported_limit = 0;
+            auto current_size             = overlap
+                                + decoder.decode(current_window + overlap,
+                                                 window_size - overlap);
+
+            for (;;)
+            {
+                const auto finished = decoder.finished();
+                std::future<std::size_t> next_decoded;
+
+                if (not finished)
+                {
+                    std::copy(current_window + current_size - overlap,
+                              current_window + current_size,
+                              next_window);
+
+                    next_decoded = std::async(
+                      std::launch::async,
+                      [&decoder, &next_window, &overlap, &window_size]()
+                      {
+                          return decoder.decode(next_window + overlap,
+                                                window_size - overlap);
+                      });
+                }
+
+                const auto scan_size = std::max(
+                  MemoryUtils::AlignToPageSize(current_size, simd_size),
+                  simd_size);
+
+                std::fill(current_window + current_size,
+                          current_window + scan_size,
+                          0);
+
+                const auto first_new_match = matches.size();
+
+                searchMethod(pattern,
+                             current_window,
+                             scan_size,
+                             view_as<ptr_t>(
+                               view_as<std::intptr_t>(baseAddress)
+                               + window_offset));
+
+                const auto window_end = window_offset
+                                        + view_as<std::ptrdiff_t>(
+                                          current_size);
+
+                /**
+                 * Drop matches already reported by the previous window
+                 * and the ones running over the decoded bytes, the next
+                 * window will report them.
+                 */
+                matches.erase(
+                  std::remove_if(
+                    matches.begin() + first_new_match,
+                    matches.end(),
+                    [&](const ptr_t match)
+                    {
+                        const auto offset = view_as<std::intptr_t>(match)
+                                            - view_as<std::intptr_t>(
+                                              baseAddress);
+
+                        return offset < reported_limit
+                               or offset + pattern_size > window_end;
+                    }),
+                  matches.end());
+
+                reported_limit = window_end - (pattern_size - 1);
+
+                if (finished)
+                {
+                    break;
+                }
+
+                const auto decoded = next_decoded.get();
+
+                if (decoded == 0)
+                {
+                    break;
+                }
+
+                window_offset = window_end
+                                - view_as<std::ptrdiff_t>(overlap);
+                current_size  = overlap + decoded;
+                std::swap(current_window, next_window);
+            }
+
+            return matches.size() != old_matches_size;
+        }
     };
 }
 
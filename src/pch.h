@@ -4,14 +4,17 @@
 /* std */
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <bit>
 #include <bitset>
 #include <cassert>
 #include <cerrno>
+#include <charconv>
 #include <chrono>
 #include <climits>
 #include <cmath>
 #include <concepts>
+#include <condition_variable>
 #include <csignal>
 #include <cstddef>
 #include <cstdlib>
@@ -21,18 +24,26 @@
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <list>
+#include <map>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
 #include <random>
 #include <regex>
+#include <span>
 #include <sstream>
+#include <string_view>
 #include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 
 /* ELFIO, must be included early */
@@ -58,16 +69,27 @@
 #ifndef WINDOWS
     #include <dlfcn.h>
     #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
 
     #include <sys/file.h>
     #include <sys/ioctl.h>
     #include <sys/mman.h>
+    #include <sys/ptrace.h>
+    #include <sys/socket.h>
     #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <sys/sysmacros.h>
     #include <sys/types.h>
     #include <sys/uio.h>
+    #include <sys/user.h>
     #include <sys/wait.h>
 
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+
     #include <linux/limits.h>
+    #include <linux/perf_event.h>
 #else
     #include <windows.h>
 
@@ -18,6 +18,10 @@ namespace Asura
             constexpr inline auto FILE_MACHINE_I386          = 0x14c;
             constexpr inline auto FILE_MACHINE_IA64          = 0x200;
             constexpr inline auto FILE_MACHINE_AMD64         = 0x8664;
+            constexpr inline auto NT_SIGNATURE               = 0x4550;
+            constexpr inline auto NT_OPTIONAL_HDR32_MAGIC    = 0x10B;
+            constexpr inline auto NT_OPTIONAL_HDR64_MAGIC    = 0x20B;
+            constexpr inline auto SCN_MEM_EXECUTE            = 0x20000000;
 
             /* For 32 bits programs, PE 32 bit only supported */
             template <typename T>
@@ -136,6 +140,43 @@ namespace Asura
                 DataDirectory[NUMBEROF_DIRECTORY_ENTRIES];
             };
 
+            /* PE32+ has no BaseOfData, ImageBase takes its place */
+            template <>
+            struct OPTIONAL_HEADER<std::uint64_t>
+            {
+                std::uint16_t Magic;
+                std::uint8_t MajorLinkerVersion;
+                std::uint8_t MinorLinkerVersion;
+                std::uint32_t SizeOfCode;
+                std::uint32_t SizeOfInitializedData;
+                std::uint32_t SizeOfUninitializedData;
+                std::uint32_t AddressOfEntryPoint;
+                std::uint32_t BaseOfCode;
+                std::uint64_t ImageBase;
+                std::uint32_t SectionAlignment;
+                std::uint32_t FileAlignment;
+                std::uint16_t MajorOperatingSystemVersion;
+                std::uint16_t MinorOperatingSystemVersion;
+                std::uint16_t MajorImageVersion;
+                std::uint16_t MinorImageVersion;
+                std::uint16_t MajorSubsystemVersion;
+                std::uint16_t MinorSubsystemVersion;
+                std::uint32_t Win32VersionValue;
+                std::uint32_t SizeOfImage;
+                std::uint32_t SizeOfHeaders;
+                std::uint32_t CheckSum;
+                std::uint16_t Subsystem;
+                std::uint16_t DllCharacteristics;
+                std::uint64_t SizeOfStackReserve;
+                std::uint64_t SizeOfStackCommit;
+                std::uint64_t SizeOfHeapReserve;
+                std::uint64_t SizeOfHeapCommit;
+                std::uint32_t LoaderFlags;
+                std::uint32_t NumberOfrvaAndSizes;
+                DATA_DIRECTORY
+                DataDirectory[NUMBEROF_DIRECTORY_ENTRIES];
+            };
+
             struct PARENT_NT_HEADERS
             {
                 std::uint32_t Signature;
@@ -276,22 +317,24 @@ namespace Asura
                         }
                     };
 
-                    const auto export_directory = view_as<
-                      const IMAGE::EXPORT_DIRECTORY* const>(
-                      get_va(entry_rva));
-
-                    if (not export_directory)
+                    /* get_va never gives null, check the entry instead */
+                    if (entry_rva == 0 or entry_size == 0)
                     {
                         return { 0, 0 };
                     }
 
-                    const auto funcs = view_as<T*>(
+                    const auto export_directory = view_as<
+                      const IMAGE::EXPORT_DIRECTORY* const>(
+                      get_va(entry_rva));
+
+                    /* RVAs are 32 bits on PE32+ too */
+                    const auto funcs = view_as<const std::uint32_t*>(
                       get_va(export_directory->AddressOfFunctions));
 
-                    const auto names = view_as<T*>(
+                    const auto names = view_as<const std::uint32_t*>(
                       get_va(export_directory->AddressOfNames));
 
-                    const auto ordinals = view_as<T*>(
+                    const auto ordinals = view_as<const std::uint16_t*>(
                       get_va(export_directory->AddressOfNameOrdinals));
 
                     /* dll.function */
@@ -368,15 +411,14 @@ namespace Asura
                     }
                     else
                     {
-                        for (std::uint16_t i = 0;
+                        for (std::uint32_t i = 0;
                              i < export_directory->NumberOfNames;
                              i++)
                         {
                             const std::string func_name = view_as<
                               const char* const>(get_va(names[i]));
 
-                            if (func_name.find(funcName)
-                                != std::string::npos)
+                            if (func_name != funcName)
                             {
                                 continue;
                             }
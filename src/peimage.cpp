@@ -0,0 +1,465 @@
+#include "pch.h"
+
+#include "exception.h"
+#include "memoryutils.h"
+#include "peimage.h"
+
+using namespace Asura;
+
+#ifndef WINDOWS
+/* Calls visit with the right NT headers for the optional header magic */
+static auto VisitNTHeaders(const byte_t* data, const auto& visit)
+{
+    const auto dos_header = view_as<const PE::IMAGE::DOS_HEADER*>(data);
+    const auto nt_headers = data + dos_header->e_lfanew;
+    const auto magic      = *view_as<const std::uint16_t*>(
+      nt_headers + sizeof(PE::IMAGE::PARENT_NT_HEADERS));
+
+    switch (magic)
+    {
+        case PE::IMAGE::NT_OPTIONAL_HDR32_MAGIC:
+        {
+            return visit(view_as<
+                         const PE::IMAGE::NT_HEADERS<std::uint32_t>*>(
+              nt_headers));
+        }
+
+        case PE::IMAGE::NT_OPTIONAL_HDR64_MAGIC:
+        {
+            return visit(view_as<
+                         const PE::IMAGE::NT_HEADERS<std::uint64_t>*>(
+              nt_headers));
+        }
+
+        default:
+        {
+            ASURA_EXCEPTION("Unknown optional header magic: "
+                            + std::to_string(magic));
+        }
+    }
+}
+
+PEImage::PEImage(const std::string& path)
+ : _path(path)
+{
+    const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        ASURA_EXCEPTION("Couldn't open " + path);
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) < 0)
+    {
+        close(fd);
+        ASURA_EXCEPTION("Couldn't stat " + path);
+    }
+
+    const auto file_size = view_as<std::size_t>(file_stat.st_size);
+
+    if (file_size < sizeof(PE::IMAGE::DOS_HEADER))
+    {
+        close(fd);
+        ASURA_EXCEPTION(path + " is too small to be a PE file");
+    }
+
+    const auto file = mmap(nullptr,
+                           file_size,
+                           PROT_READ,
+                           MAP_PRIVATE,
+                           fd,
+                           0);
+
+    if (file == MAP_FAILED)
+    {
+        close(fd);
+        ASURA_EXCEPTION("Couldn't map " + path);
+    }
+
+    const auto file_data = view_as<const byte_t*>(file);
+
+    try
+    {
+        const auto dos_header = view_as<const PE::IMAGE::DOS_HEADER*>(
+          file_data);
+
+        if (dos_header->e_magic != PE::MAGIC_NUMBER)
+        {
+            ASURA_EXCEPTION(path + " isn't a PE file");
+        }
+
+        /* The signature, the file header and the magic */
+        if (view_as<std::size_t>(dos_header->e_lfanew)
+              + sizeof(PE::IMAGE::PARENT_NT_HEADERS) + sizeof(std::uint16_t)
+            > file_size)
+        {
+            ASURA_EXCEPTION(path + " has truncated NT headers");
+        }
+
+        const auto nt_parent_headers = view_as<
+          const PE::IMAGE::PARENT_NT_HEADERS*>(file_data
+                                               + dos_header->e_lfanew);
+
+        if (nt_parent_headers->Signature != PE::IMAGE::NT_SIGNATURE)
+        {
+            ASURA_EXCEPTION(path + " has no PE signature");
+        }
+
+        VisitNTHeaders(file_data,
+                       [&](const auto nt_headers)
+                       {
+                           load(fd, file_data, file_size, nt_headers);
+                       });
+    }
+    catch (...)
+    {
+        if (_reserved)
+        {
+            munmap(_reserved, _reserved_size);
+        }
+
+        munmap(file, file_size);
+        close(fd);
+        throw;
+    }
+
+    /* The pages mapped from the file keep their own reference to it */
+    munmap(file, file_size);
+    close(fd);
+}
+
+PEImage::~PEImage()
+{
+    munmap(_reserved, _reserved_size);
+}
+
+template <PE::IMAGE::IntType T>
+auto PEImage::load(const int fd,
+                   const byte_t* file,
+                   const std::size_t fileSize,
+                   const PE::IMAGE::NT_HEADERS<T>* ntHeaders) -> void
+{
+    const auto nt_offset = view_as<std::size_t>(
+      view_as<const byte_t*>(ntHeaders) - file);
+
+    if (nt_offset + sizeof(PE::IMAGE::PARENT_NT_HEADERS)
+          + sizeof(PE::IMAGE::OPTIONAL_HEADER<T>)
+        > fileSize)
+    {
+        ASURA_EXCEPTION(_path + " has a truncated optional header");
+    }
+
+    const auto& file_header     = ntHeaders->FileHeader;
+    const auto& optional_header = ntHeaders->OptionalHeader;
+    const auto first_section    = ntHeaders->first_section();
+
+    if (view_as<std::size_t>(view_as<const byte_t*>(first_section) - file)
+          + file_header.NumberOfSections
+              * sizeof(PE::IMAGE::SECTION_HEADER)
+        > fileSize)
+    {
+        ASURA_EXCEPTION(_path + " has a truncated section table");
+    }
+
+    if (optional_header.SizeOfImage == 0)
+    {
+        ASURA_EXCEPTION(_path + " has an empty image");
+    }
+
+    _is_64_bits = std::is_same<std::uint64_t, T>::value;
+    _machine    = file_header.Machine;
+    _image_base = view_as<std::uintptr_t>(optional_header.ImageBase);
+
+    const auto page_size = MemoryUtils::GetPageSize();
+
+    _image_size    = MemoryUtils::AlignToPageSize(
+      view_as<std::size_t>(optional_header.SizeOfImage),
+      page_size);
+    _reserved_size = _image_size + page_size * 2;
+
+    const auto reserved = mmap(nullptr,
+                               _reserved_size,
+                               PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS,
+                               -1,
+                               0);
+
+    if (reserved == MAP_FAILED)
+    {
+        ASURA_EXCEPTION("Couldn't reserve the image of " + _path);
+    }
+
+    _reserved = view_as<byte_t*>(reserved);
+    _image    = _reserved + page_size;
+
+    std::copy_n(file,
+                std::min({ view_as<std::size_t>(
+                             optional_header.SizeOfHeaders),
+                           fileSize,
+                           _image_size }),
+                _image);
+
+    for (std::uint16_t i = 0; i < file_header.NumberOfSections; i++)
+    {
+        const auto& section_header = first_section[i];
+
+        Section section {
+            std::string(view_as<const char*>(section_header.Name),
+                        strnlen(view_as<const char*>(section_header.Name),
+                                PE::IMAGE::SIZEOF_SHORT_NAME)),
+            section_header.VirtualAddress,
+            section_header.SizeOfRawData,
+            section_header.Characteristics,
+            false
+        };
+
+        if (section.rva >= _image_size)
+        {
+            ASURA_EXCEPTION(_path + ": " + section.name
+                            + " is outside of the image");
+        }
+
+        const auto raw = view_as<std::size_t>(
+          section_header.PointerToRawData);
+
+        /* What the loader maps, the raw size is rounded up in the file */
+        if (section_header.Misc.VirtualSize != 0)
+        {
+            section.size = std::min(section.size,
+                                    view_as<std::size_t>(
+                                      section_header.Misc.VirtualSize));
+        }
+
+        section.size = std::min({ section.size,
+                                  raw < fileSize ? fileSize - raw : 0,
+                                  _image_size - section.rva });
+
+        if (raw == 0)
+        {
+            section.size = 0;
+        }
+
+        const auto mapped_size = section.rva % page_size == 0
+                                     and raw % page_size == 0 ?
+                                   section.size - section.size % page_size :
+                                   0;
+
+        if (mapped_size > 0)
+        {
+            if (mmap(_image + section.rva,
+                     mapped_size,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_FIXED,
+                     fd,
+                     view_as<off_t>(raw))
+                == MAP_FAILED)
+            {
+                ASURA_EXCEPTION("Couldn't map " + section.name + " of "
+                                + _path);
+            }
+
+            section.zero_copy  = true;
+            _zero_copy_size   += mapped_size;
+        }
+
+        std::copy_n(file + raw + mapped_size,
+                    section.size - mapped_size,
+                    _image + section.rva + mapped_size);
+
+        _sections.push_back(std::move(section));
+    }
+
+    /* Guard pages included, they're zeros */
+    if (mprotect(_reserved, _reserved_size, PROT_READ) < 0)
+    {
+        ASURA_EXCEPTION("Couldn't protect the image of " + _path);
+    }
+}
+
+auto PEImage::path() const -> const std::string&
+{
+    return _path;
+}
+
+auto PEImage::is64Bits() const -> bool
+{
+    return _is_64_bits;
+}
+
+auto PEImage::machine() const -> std::uint16_t
+{
+    return _machine;
+}
+
+auto PEImage::imageBase() const -> std::uintptr_t
+{
+    return _image_base;
+}
+
+auto PEImage::imageSize() const -> std::size_t
+{
+    return _image_size;
+}
+
+auto PEImage::data() const -> const byte_t*
+{
+    return _image;
+}
+
+auto PEImage::sections() const -> const std::vector<Section>&
+{
+    return _sections;
+}
+
+auto PEImage::findSection(const std::string& name) const -> const Section*
+{
+    const auto it = std::find_if(_sections.begin(),
+                                 _sections.end(),
+                                 [&](const Section& section)
+                                 {
+                                     return section.name == name;
+                                 });
+
+    return it == _sections.end() ? nullptr : &*it;
+}
+
+auto PEImage::zeroCopySize() const -> std::size_t
+{
+    return _zero_copy_size;
+}
+
+auto PEImage::exports() const -> std::vector<Export>
+{
+    std::vector<Export> result;
+
+    VisitNTHeaders(
+      _image,
+      [&](const auto nt_headers)
+      {
+          const auto& optional_header = nt_headers->OptionalHeader;
+
+          if (optional_header.NumberOfrvaAndSizes
+              <= PE::IMAGE::DIRECTORY_ENTRY_EXPORT)
+          {
+              return;
+          }
+
+          const auto& entry = optional_header.DataDirectory
+                                [PE::IMAGE::DIRECTORY_ENTRY_EXPORT];
+
+          if (entry.VirtualAddress == 0 or entry.Size == 0)
+          {
+              return;
+          }
+
+          const auto at = [&]<typename S>(const std::size_t rva,
+                                          const std::size_t count = 1)
+          {
+              if (rva > _image_size
+                  or count > (_image_size - rva) / sizeof(S))
+              {
+                  ASURA_EXCEPTION(_path + " has its exports outside of "
+                                          "the image");
+              }
+
+              return view_as<const S*>(_image + rva);
+          };
+
+          const auto directory = at.template
+                                 operator()<PE::IMAGE::EXPORT_DIRECTORY>(
+                                   entry.VirtualAddress);
+
+          const auto funcs = at.template operator()<std::uint32_t>(
+            directory->AddressOfFunctions,
+            directory->NumberOfFunctions);
+          const auto names = at.template operator()<std::uint32_t>(
+            directory->AddressOfNames,
+            directory->NumberOfNames);
+          const auto ordinals = at.template operator()<std::uint16_t>(
+            directory->AddressOfNameOrdinals,
+            directory->NumberOfNames);
+
+          std::vector<std::string> func_names(directory->NumberOfFunctions);
+
+          for (std::uint32_t i = 0; i < directory->NumberOfNames; i++)
+          {
+              if (ordinals[i] >= func_names.size() or names[i] >= _image_size)
+              {
+                  continue;
+              }
+
+              /* The image ends with a zeroed page, it's terminated */
+              func_names[ordinals[i]] = view_as<const char*>(_image
+                                                             + names[i]);
+          }
+
+          for (std::uint32_t i = 0; i < directory->NumberOfFunctions; i++)
+          {
+              const auto rva = funcs[i];
+
+              /* Unused slot, or forwarded */
+              if (rva == 0
+                  or (rva >= entry.VirtualAddress
+                      and rva - entry.VirtualAddress < entry.Size))
+              {
+                  continue;
+              }
+
+              result.push_back({ std::move(func_names[i]),
+                                 directory->Base + i,
+                                 rva });
+          }
+      });
+
+    std::sort(result.begin(),
+              result.end(),
+              [](const Export& left, const Export& right)
+              {
+                  return left.rva < right.rva;
+              });
+
+    return result;
+}
+
+auto PEImage::findExport(const std::string& funcName) const
+  -> std::uintptr_t
+{
+    return VisitNTHeaders(
+      _image,
+      [&](const auto nt_headers) -> std::uintptr_t
+      {
+          const auto& optional_header = nt_headers->OptionalHeader;
+
+          if (optional_header.NumberOfrvaAndSizes
+              <= PE::IMAGE::DIRECTORY_ENTRY_EXPORT)
+          {
+              return 0;
+          }
+
+          const auto& entry = optional_header.DataDirectory
+                                [PE::IMAGE::DIRECTORY_ENTRY_EXPORT];
+
+          if (view_as<std::size_t>(entry.VirtualAddress) + entry.Size
+              > _image_size)
+          {
+              ASURA_EXCEPTION(_path
+                              + " has its exports outside of the image");
+          }
+
+          return std::get<1>(nt_headers->template find_exported_function<
+                             true>(
+            view_as<const PE::IMAGE::DOS_HEADER*>(_image),
+            funcName,
+            _image_base,
+            [](const std::string& moduleName,
+               const std::string& forwardedName) -> module_sym_t
+            {
+                /* moduleName keeps its dot */
+                ASURA_EXCEPTION("Forwarded to " + moduleName
+                                + forwardedName);
+            }));
+      });
+}
+#endif
@@ -0,0 +1,108 @@
+#ifndef ASURA_PEIMAGE_H
+#define ASURA_PEIMAGE_H
+
+#include "pe.h"
+
+#ifndef WINDOWS
+namespace Asura
+{
+    /**
+     * A PE file laid out like the Windows loader would, without running
+     * anything, to scan it and resolve its exports offline:
+     *
+     * PEImage image("game.exe");
+     * PatternScanning::searchInPEImage(pattern, image, searchV4, ".text");
+     * image.findExport("CreateInterface");
+     *
+     * The headers and the sections are placed at their relative virtual
+     * address inside a zeroed reservation of SizeOfImage, addresses are
+     * reported as if the image was loaded at its preferred ImageBase.
+     * When a section starts on a page both in the file and in the image,
+     * its pages are mapped straight from the file instead of copied,
+     * only its partial last page is copied. The image is read only and
+     * there's a zeroed page on each side of it, so the SIMD search
+     * methods can load a bit outside of it.
+     * Relocations and imports aren't applied, the image is what it
+     * would be before the loader patches it.
+     */
+    class PEImage
+    {
+      public:
+        struct Section
+        {
+            std::string name;
+            std::uint32_t rva;
+            /**
+             * Bytes coming from the file, the rest up to the next
+             * section is zeros.
+             */
+            std::size_t size;
+            std::uint32_t characteristics;
+            bool zero_copy;
+        };
+
+        struct Export
+        {
+            /* Empty when only exported by ordinal */
+            std::string name;
+            std::uint32_t ordinal;
+            std::uint32_t rva;
+        };
+
+      public:
+        explicit PEImage(const std::string& path);
+        ~PEImage();
+
+        PEImage(const PEImage&)                    = delete;
+        auto operator=(const PEImage&) -> PEImage& = delete;
+
+      public:
+        auto path() const -> const std::string&;
+        auto is64Bits() const -> bool;
+        auto machine() const -> std::uint16_t;
+        auto imageBase() const -> std::uintptr_t;
+        auto imageSize() const -> std::size_t;
+        /* Where the relative virtual address 0 is */
+        auto data() const -> const byte_t*;
+        auto sections() const -> const std::vector<Section>&;
+        auto findSection(const std::string& name) const -> const Section*;
+        /* Bytes mapped from the file instead of copied */
+        auto zeroCopySize() const -> std::size_t;
+
+      public:
+        /**
+         * By name or by ordinal, as an address in the image based at
+         * imageBase(), 0 when not exported. Throws for forwarded
+         * exports, they live in another module.
+         */
+        auto findExport(const std::string& funcName) const
+          -> std::uintptr_t;
+        /* Sorted by rva, forwarded exports are left out */
+        auto exports() const -> std::vector<Export>;
+
+      private:
+        template <PE::IMAGE::IntType T>
+        auto load(const int fd,
+                  const byte_t* file,
+                  const std::size_t fileSize,
+                  const PE::IMAGE::NT_HEADERS<T>* ntHeaders) -> void;
+
+      private:
+        std::string _path;
+        bool _is_64_bits {};
+        std::uint16_t _machine {};
+        std::uintptr_t _image_base {};
+        std::size_t _image_size {};
+
+        /* The reservation, with its guard pages */
+        byte_t* _reserved {};
+        std::size_t _reserved_size {};
+        byte_t* _image {};
+
+        std::vector<Section> _sections;
+        std::size_t _zero_copy_size {};
+    };
+}
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+#include "pch.h"
+
+#include "memoryutils.h"
+#include "pointerchainresolver.h"
+
+using namespace Asura;
+
+PointerChainResolver::PointerChainResolver(const ProcessBase& processBase)
+ : _process_base(processBase.id())
+{
+}
+
+auto PointerChainResolver::nodes() const -> const std::vector<Node>&
+{
+    return _nodes;
+}
+
+auto PointerChainResolver::chainsCount() const -> std::size_t
+{
+    return _chains.size();
+}
+
+auto PointerChainResolver::address(const std::size_t chain) const
+  -> Expected<std::uintptr_t>
+{
+    if (chain >= _chains.size())
+    {
+        return Unexpected(ErrorCode::INVALID_ARGUMENT);
+    }
+
+    const auto& node = _nodes[_chains[chain]];
+
+    if (not node.valid)
+    {
+        return Unexpected(ErrorCode::BAD_ADDRESS);
+    }
+
+    return node.address;
+}
+
+auto PointerChainResolver::findOrAddNode(const std::size_t parent,
+                                         const std::ptrdiff_t offset,
+                                         const std::size_t depth)
+  -> std::size_t
+{
+    const auto [it, inserted] = _node_indices.try_emplace(
+      { parent, offset },
+      _nodes.size());
+
+    if (not inserted)
+    {
+        return it->second;
+    }
+
+    _nodes.push_back({ parent, offset, 0, 0, false, false, false });
+
+    if (_levels.size() <= depth)
+    {
+        _levels.resize(depth + 1);
+    }
+
+    _levels[depth].push_back(it->second);
+
+    return it->second;
+}
+
+auto PointerChainResolver::add(const std::uintptr_t base,
+                               const std::vector<std::ptrdiff_t>& offsets)
+  -> std::size_t
+{
+    auto node = findOrAddNode(NO_PARENT, view_as<std::ptrdiff_t>(base), 0);
+
+    for (std::size_t i = 0; i < offsets.size(); i++)
+    {
+        /* Going further means the current node must be dereferenced */
+        if (i > 0)
+        {
+            _nodes[node].dereferenced = true;
+        }
+
+        node = findOrAddNode(node, offsets[i], i + 1);
+    }
+
+    _chains.push_back(node);
+
+    return _chains.size() - 1;
+}
+
+auto PointerChainResolver::resolve() -> void
+{
+    std::vector<std::uintptr_t> addresses;
+    std::vector<std::size_t> pending;
+
+    for (const auto& level : _levels)
+    {
+        addresses.clear();
+        pending.clear();
+
+        for (const auto index : level)
+        {
+            auto& node = _nodes[index];
+
+            if (node.parent == NO_PARENT)
+            {
+                node.address = view_as<std::uintptr_t>(node.offset);
+                node.valid   = true;
+            }
+            else
+            {
+                const auto& parent = _nodes[node.parent];
+
+                node.address = parent.value + node.offset;
+                node.valid   = parent.value_valid;
+            }
+
+            /* The base itself is never dereferenced, only base + off0 */
+            node.value       = node.address;
+            node.value_valid = node.valid and not node.dereferenced;
+
+            if (node.valid and node.dereferenced)
+            {
+                addresses.push_back(node.address);
+                pending.push_back(index);
+            }
+        }
+
+        if (addresses.empty())
+        {
+            continue;
+        }
+
+        const auto [values, valids] = MemoryUtils::ReadProcessMemoryAreas(
+          _process_base.id(),
+          addresses,
+          sizeof(std::uintptr_t));
+
+        for (std::size_t i = 0; i < pending.size(); i++)
+        {
+            auto& node = _nodes[pending[i]];
+
+            node.value_valid = valids[i];
+            std::memcpy(&node.value,
+                        &values[i * sizeof(std::uintptr_t)],
+                        sizeof(node.value));
+        }
+    }
+}
+
+auto PointerChainResolver::clear() -> void
+{
+    _nodes.clear();
+    _node_indices.clear();
+    _levels.clear();
+    _chains.clear();
+}
@@ -0,0 +1,74 @@
+#ifndef ASURA_POINTERCHAINRESOLVER_H
+#define ASURA_POINTERCHAINRESOLVER_H
+
+#include "expected.h"
+#include "processbase.h"
+
+namespace Asura
+{
+    /**
+     * Resolves many pointer chains at once:
+     * base + offsets[0] -> + offsets[1] -> ... + offsets[n - 1]
+     * Every offset but the last one is followed by a dereference, the
+     * result is the address of the value.
+     *
+     * Chains are stored as a tree, chains sharing a prefix share its
+     * nodes, so a common prefix is only resolved once. Resolving goes
+     * level by level, all the pointers of a level are read with one
+     * vectored read, so it costs about one system call per level
+     * whatever the number of chains.
+     */
+    class PointerChainResolver
+    {
+      public:
+        static constexpr std::size_t NO_PARENT = std::numeric_limits<
+          std::size_t>::max();
+
+        struct Node
+        {
+            std::size_t parent;
+            std::ptrdiff_t offset;
+            /* parent value + offset, or the base for the roots */
+            std::uintptr_t address;
+            /* pointer read at address, when some chain goes further */
+            std::uintptr_t value;
+            bool dereferenced;
+            bool valid;
+            bool value_valid;
+        };
+
+      public:
+        explicit PointerChainResolver(const ProcessBase& processBase);
+
+      public:
+        auto nodes() const -> const std::vector<Node>&;
+        auto chainsCount() const -> std::size_t;
+        /* Address of the value pointed by the chain at last resolve() */
+        auto address(const std::size_t chain) const
+          -> Expected<std::uintptr_t>;
+
+      public:
+        /* Returns the chain index */
+        auto add(const std::uintptr_t base,
+                 const std::vector<std::ptrdiff_t>& offsets) -> std::size_t;
+        auto resolve() -> void;
+        auto clear() -> void;
+
+      private:
+        auto findOrAddNode(const std::size_t parent,
+                           const std::ptrdiff_t offset,
+                           const std::size_t depth) -> std::size_t;
+
+      private:
+        ProcessBase _process_base;
+        std::vector<Node> _nodes;
+        /* (parent, offset) -> node, roots use NO_PARENT and the base */
+        std::map<std::tuple<std::size_t, std::ptrdiff_t>, std::size_t>
+          _node_indices;
+        /* Nodes by depth, parents are always resolved first */
+        std::vector<std::vector<std::size_t>> _levels;
+        std::vector<std::size_t> _chains;
+    };
+}
+
+#endif
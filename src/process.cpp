@@ -1,5 +1,6 @@
 #include "pch.h"
 
+#include "memorybackend.h"
 #include "patternscanning.h"
 #include "process.h"
 #include "processmemoryarea.h"
@@ -7,6 +8,30 @@
 
 using namespace Asura;
 
+/**
+ * Shared memory, memfd, devices and deleted files are mapped with a path
+ * and an inode too, but there's no file to load symbols from.
+ * Backends can name files that aren't on this system, only their names
+ * are looked at.
+ */
+static auto IsModulePath(const std::string& path, const bool onSystem)
+  -> bool
+{
+    if (path.ends_with(" (deleted)") or path.starts_with("/memfd:")
+        or path.starts_with("/SYSV") or path.starts_with("/dev/"))
+    {
+        return false;
+    }
+
+    if (not onSystem)
+    {
+        return true;
+    }
+
+    std::error_code error_code;
+    return std::filesystem::is_regular_file(path, error_code);
+}
+
 Process::Module::Module(ptr_t baseAddress,
                         const std::string& name,
                         const std::string& path)
@@ -85,14 +110,17 @@ auto Asura::Process::find(const std::string& name) -> Asura::Process
     {
         if (entry.is_directory())
         {
+            const auto file_name = entry.path().filename().string();
             process_id_t pid;
 
-            try
-            {
-                pid = std::stoi(entry.path().filename());
-            }
+            const auto [ptr, ec] = std::from_chars(file_name.data(),
+                                                   file_name.data()
+                                                     + file_name.size(),
+                                                   pid);
+
             /* could be fs or any folder that is not a number */
-            catch (std::invalid_argument&)
+            if (ec != std::errc()
+                or ptr != file_name.data() + file_name.size())
             {
                 continue;
             }
@@ -130,6 +158,11 @@ auto Asura::Process::name(const process_id_t pid)
     std::string result;
     bool found;
 
+    if (const auto backend = MemoryBackend::Find(pid))
+    {
+        return { backend->name(), true };
+    }
+
 #ifndef WINDOWS
     result.resize(PATH_MAX);
 
@@ -248,36 +281,32 @@ auto Process::refreshModules() -> void
 {
     _modules.clear();
 
-    const auto& mmap  = this->mmap();
-    const auto& areas = mmap.areas();
-
-    std::for_each(areas.begin(),
-                  areas.end(),
-                  [&](const std::shared_ptr<ProcessMemoryArea>& area)
-                  {
-                      if (area->isDeniedByOS() or not area->isReadable())
-                      {
-                          return;
-                      }
-
-                      const auto area_name = area->name();
-
-                      const auto path = std::filesystem::path(
-                        area->name());
-
-                      if (std::filesystem::exists(path))
-                      {
-                          const auto base_name = path.filename();
-
-                          _modules.push_back({ area->begin<ptr_t>(),
-                                               base_name.string(),
-                                               area->name() });
-                      }
-                  });
-
-    _modules.unique(
-      [](const Module& moduleA, const Module& moduleB)
-      {
-          return (moduleA.name() == moduleB.name());
-      });
+    const auto on_system = MemoryBackend::Find(id()) == nullptr;
+
+    /* Areas are already grouped by inode, one module per file */
+    for (const auto& module_areas : _mmap.moduleAreas())
+    {
+        if (not IsModulePath(module_areas.path, on_system))
+        {
+            continue;
+        }
+
+        const auto first_readable = std::find_if(
+          module_areas.areas.begin(),
+          module_areas.areas.end(),
+          [](const std::shared_ptr<ProcessMemoryArea>& area)
+          {
+              return area->isReadable();
+          });
+
+        if (first_readable == module_areas.areas.end())
+        {
+            continue;
+        }
+
+        _modules.push_back(
+          { (*first_readable)->begin<ptr_t>(),
+            std::filesystem::path(module_areas.path).filename().string(),
+            module_areas.path });
+    }
 }
@@ -2,6 +2,7 @@
 #define ASURA_PROCESS_H
 
 #include "exception.h"
+#include "expected.h"
 #include "memoryarea.h"
 #include "memorymap.h"
 #include "memoryutils.h"
@@ -78,6 +79,14 @@ namespace Asura
             return _mmap.read(address, size);
         }
 
+        auto read(const auto address,
+                  const std::size_t size,
+                  std::pmr::memory_resource* const resource) const
+          -> pmr_bytes_t
+        {
+            return _mmap.read(address, size, resource);
+        }
+
         auto write(const auto address, const bytes_t& bytes) const -> void
         {
             _mmap.write(address, bytes);
@@ -90,6 +99,32 @@ namespace Asura
             _mmap.write(address, ptr, size);
         }
 
+        auto tryRead(const auto address,
+                     const ptr_t buffer,
+                     const std::size_t size) const -> Expected<void>
+        {
+            return _mmap.tryRead(address, buffer, size);
+        }
+
+        template <typename T>
+        auto tryRead(const auto address) const -> Expected<T>
+        {
+            return _mmap.tryRead<T>(address);
+        }
+
+        auto tryWrite(const auto address, const bytes_t& bytes) const
+          -> Expected<void>
+        {
+            return _mmap.tryWrite(address, bytes);
+        }
+
+        auto tryWrite(const auto address,
+                      const auto ptr,
+                      const std::size_t size) const -> Expected<void>
+        {
+            return _mmap.tryWrite(address, ptr, size);
+        }
+
       public:
         auto allocArea(const auto address,
                        const std::size_t size,
@@ -112,6 +147,13 @@ namespace Asura
             _mmap.protectMemoryArea(address, size, flags);
         }
 
+        auto tryProtect(const auto address,
+                        const std::size_t size,
+                        const mapf_t flags) -> Expected<void>
+        {
+            return _mmap.tryProtect(address, size, flags);
+        }
+
         auto forceWrite(const auto address, const bytes_t& bytes) -> void
         {
             _mmap.forceWrite(address, bytes);
@@ -83,6 +83,41 @@ auto ProcessMemoryArea::read(std::size_t size, std::size_t shift) const
                                               size);
 }
 
+auto ProcessMemoryArea::read(std::size_t size,
+                             std::size_t shift,
+                             std::pmr::memory_resource* const resource) const
+  -> pmr_bytes_t
+{
+    if (ProcessBase::self().id() == _process_base.id())
+    {
+        return pmr_bytes_t(&begin<data_t>()[shift],
+                           &begin<data_t>()[shift + size],
+                           resource);
+    }
+
+    return MemoryUtils::ReadProcessMemoryArea(_process_base.id(),
+                                              begin<std::size_t>()
+                                                + shift,
+                                              size,
+                                              resource);
+}
+
+auto ProcessMemoryArea::readInto(const data_t buffer,
+                                 std::size_t size,
+                                 std::size_t shift) const -> void
+{
+    if (ProcessBase::self().id() == _process_base.id())
+    {
+        std::copy_n(&begin<data_t>()[shift], size, buffer);
+        return;
+    }
+
+    MemoryUtils::ReadProcessMemoryAreaInto(_process_base.id(),
+                                           begin<std::size_t>() + shift,
+                                           buffer,
+                                           size);
+}
+
 auto ProcessMemoryArea::write(const bytes_t& bytes,
                               std::size_t shift) const -> void
 {
@@ -99,11 +134,7 @@ auto ProcessMemoryArea::write(const bytes_t& bytes,
 
 auto Asura::ProcessMemoryArea::isDeniedByOS() const -> bool
 {
-#ifndef WIN32
-    return name() == "[vvar]";
-#else
-    return false;
-#endif
+    return _denied_by_os;
 }
 
 auto Asura::ProcessMemoryArea::isReadable() const -> bool
@@ -118,6 +149,45 @@ auto Asura::ProcessMemoryArea::isWritable() const -> bool
            and not isDeniedByOS();
 }
 
+auto ProcessMemoryArea::isFileBacked() const -> bool
+{
+    return _category == FILE_BACKED;
+}
+
+auto ProcessMemoryArea::offset() const -> std::uintptr_t
+{
+    return _offset;
+}
+
+auto ProcessMemoryArea::device() const -> std::uint64_t
+{
+    return _device;
+}
+
+auto ProcessMemoryArea::inode() const -> std::uint64_t
+{
+    return _inode;
+}
+
+auto ProcessMemoryArea::category() const -> Category
+{
+    return _category;
+}
+
+auto ProcessMemoryArea::CategoryStr(const Category category) -> std::string
+{
+    static const std::string strings[] = { "file-backed", "anonymous",
+                                           "heap",        "stack",
+                                           "guard",       "special" };
+
+    if (category >= MAX_CATEGORIES)
+    {
+        return "unknown";
+    }
+
+    return strings[category];
+}
+
 auto ProcessMemoryArea::protectionFlags() -> ModifiableProtectionFlags&
 {
     return _protection_flags;
@@ -127,3 +197,46 @@ auto ProcessMemoryArea::initProtectionFlags(mapf_t flags) -> void
 {
     _protection_flags.cachedValue() = flags;
 }
+
+auto ProcessMemoryArea::initMapping(const std::uintptr_t offset,
+                                    const std::uint64_t device,
+                                    const std::uint64_t inode) -> void
+{
+    _offset = offset;
+    _device = device;
+    _inode  = inode;
+
+    const auto& area_name = name();
+
+#ifndef WINDOWS
+    /* [vvar] and [vvar_vclock] can't be read even with ptrace */
+    _denied_by_os = area_name.starts_with("[vvar");
+#endif
+
+    if (_protection_flags.cachedValue() == ProtectionFlags::NONE)
+    {
+        _category = GUARD;
+    }
+    else if (_inode != 0)
+    {
+        _category = FILE_BACKED;
+    }
+    else if (area_name == "[heap]")
+    {
+        _category = HEAP;
+    }
+    else if (area_name.starts_with("[stack"))
+    {
+        _category = STACK;
+    }
+    /* Named anonymous mappings are [anon:name] or [anon_shmem:name] */
+    else if (area_name.starts_with('[')
+             and not area_name.starts_with("[anon"))
+    {
+        _category = SPECIAL;
+    }
+    else
+    {
+        _category = ANONYMOUS;
+    }
+}
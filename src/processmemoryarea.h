@@ -9,6 +9,26 @@ namespace Asura
 {
     class ProcessMemoryArea : public MemoryArea
     {
+      public:
+        /**
+         * Computed once per refresh of the memory map, so consumers
+         * filter areas with an integer comparison instead of looking at
+         * their names.
+         * Areas without any protection are guards, even file-backed ones
+         * (gaps between the segments of a library).
+         */
+        enum Category : byte_t
+        {
+            FILE_BACKED,
+            ANONYMOUS,
+            HEAP,
+            STACK,
+            GUARD,
+            /* [vvar], [vdso], [vsyscall]... */
+            SPECIAL,
+            MAX_CATEGORIES
+        };
+
       private:
         class ModifiableProtectionFlags : private ProtectionFlags
         {
@@ -39,15 +59,37 @@ namespace Asura
         auto processBase() const -> const ProcessBase&;
         auto read(const std::size_t size,
                   const std::size_t shift = 0) const -> bytes_t;
+        auto read(const std::size_t size,
+                  const std::size_t shift,
+                  std::pmr::memory_resource* const resource) const
+          -> pmr_bytes_t;
+        auto readInto(const data_t buffer,
+                      const std::size_t size,
+                      const std::size_t shift = 0) const -> void;
         auto write(const bytes_t& bytes,
                    const std::size_t shift = 0) const -> void;
         auto isDeniedByOS() const -> bool;
         auto isReadable() const -> bool;
         auto isWritable() const -> bool;
+        auto isFileBacked() const -> bool;
+        auto offset() const -> std::uintptr_t;
+        auto device() const -> std::uint64_t;
+        auto inode() const -> std::uint64_t;
+        auto category() const -> Category;
+
+      public:
+        static auto CategoryStr(const Category category) -> std::string;
 
       public:
         auto protectionFlags() -> ModifiableProtectionFlags&;
         auto initProtectionFlags(const mapf_t flags) -> void;
+        /**
+         * Must be called once the name and protection flags are set,
+         * it classifies the area.
+         */
+        auto initMapping(const std::uintptr_t offset,
+                         const std::uint64_t device,
+                         const std::uint64_t inode) -> void;
 
       public:
         template <typename T = byte_t>
@@ -77,6 +119,11 @@ namespace Asura
       private:
         ModifiableProtectionFlags _protection_flags;
         ProcessBase _process_base;
+        std::uintptr_t _offset {};
+        std::uint64_t _device {};
+        std::uint64_t _inode {};
+        Category _category { ANONYMOUS };
+        bool _denied_by_os {};
     };
 };
 
@@ -17,6 +17,111 @@ ProcessMemoryMap::ProcessMemoryMap(ProcessBase process)
     refresh();
 }
 
+auto ProcessMemoryMap::ParseMapsLine(const std::string_view line)
+  -> MemoryBackend::AreaDescription
+{
+    /* 7ff1b37fb000-7ff1b3da9000 r--p 00000000 fe:00 1841992 [ ]+
+     * /usr/lib/locale/locale-archive */
+    std::size_t cursor = 0;
+
+    /**
+     * The fields are read in place, matching each of them with
+     * regexes was most of the time spent in refresh.
+     */
+    const auto parse_number = [&](auto& value,
+                                  const int base,
+                                  const char separator)
+    {
+        const auto [ptr, ec] = std::from_chars(line.data() + cursor,
+                                               line.data() + line.size(),
+                                               value,
+                                               base);
+
+        if (ec != std::errc())
+        {
+            return false;
+        }
+
+        cursor = view_as<std::size_t>(ptr - line.data());
+
+        /* Lines without a name can end right after the inode */
+        if (cursor == line.size())
+        {
+            return separator == ' ';
+        }
+
+        if (line[cursor] != separator)
+        {
+            return false;
+        }
+
+        cursor++;
+        return true;
+    };
+
+    std::uintptr_t start {}, end {}, offset {};
+    unsigned int dev_major {}, dev_minor {};
+    std::uint64_t inode {};
+    std::string name = "unknown";
+
+    if (not parse_number(start, 16, '-'))
+    {
+        ASURA_EXCEPTION("Could not find start address");
+    }
+
+    if (not parse_number(end, 16, ' '))
+    {
+        ASURA_EXCEPTION("Could not find end address");
+    }
+
+    if (cursor + 4 >= line.size() or line[cursor + 4] != ' ')
+    {
+        ASURA_EXCEPTION("Memory protection should have matched 4 "
+                        "characters");
+    }
+
+    const auto prot = line.substr(cursor, 4);
+    cursor += 5;
+
+    if (not parse_number(offset, 16, ' ')
+        or not parse_number(dev_major, 16, ':')
+        or not parse_number(dev_minor, 16, ' ')
+        or not parse_number(inode, 10, ' '))
+    {
+        ASURA_EXCEPTION("Could not parse offset, device or inode");
+    }
+
+    /* Sometimes there's no name */
+    const auto name_start = line.find_first_not_of(' ', cursor);
+
+    if (name_start != std::string_view::npos)
+    {
+        name = line.substr(name_start);
+    }
+
+    const auto is_on = [](char prot)
+    {
+        if (prot == '-')
+        {
+            return false;
+        }
+
+        return true;
+    };
+
+    return { start,
+             end - start,
+             view_as<mapf_t>(
+               (is_on(prot[0]) ? MemoryArea::ProtectionFlags::READ : 0)
+               | (is_on(prot[1]) ? MemoryArea::ProtectionFlags::WRITE : 0)
+               | (is_on(prot[2]) ? MemoryArea::ProtectionFlags::EXECUTE :
+                                   0)),
+             offset,
+             makedev(dev_major, dev_minor),
+             inode,
+             std::move(name) };
+}
+
 auto ProcessMemoryMap::refresh() -> void
 {
     if (_process_base.id() == Process::INVALID_PID)
@@ -26,6 +131,33 @@ auto ProcessMemoryMap::refresh() -> void
 
     _areas.clear();
 
+    const auto add_area =
+      [&](const MemoryBackend::AreaDescription& description)
+    {
+        const auto area = std::make_shared<ProcessMemoryArea>(
+          _process_base);
+        area->initProtectionFlags(description.flags);
+        area->setAddress(view_as<ptr_t>(description.begin));
+        area->setSize(description.size);
+        area->setName(description.name);
+        area->initMapping(description.offset,
+                          description.device,
+                          description.inode);
+
+        _areas.push_back(std::move(area));
+    };
+
+    if (const auto backend = MemoryBackend::Find(_process_base.id()))
+    {
+        for (const auto& description : backend->areas())
+        {
+            add_area(description);
+        }
+
+        buildIndex();
+        return;
+    }
+
 #ifndef WINDOWS
     std::ifstream file_memory_map("/proc/"
                                   + std::to_string(_process_base.id())
@@ -40,108 +172,7 @@ auto ProcessMemoryMap::refresh() -> void
 
     while (std::getline(file_memory_map, line))
     {
-        std::uintptr_t start {}, end {};
-        std::string prot = "????";
-        std::string name = "unknown";
-
-        /* abcd-1000abcd rwxp %x %i:%i %i %s */
-        /* 7ff1b37fb000-7ff1b3da9000 r--p 00000000 fe:00 1841992 [ ]+
-         * /usr/lib/locale/locale-archive */
-
-        /**
-         * This is maybe faster, so I'm just commenting it out, though it
-         * assumes that /proc/pid/maps is always correct.. Indeed it
-         * should be. I don't know why it shouldn't!
-         * Better to be safe than sorry.
-         */
-
-        //        std::sscanf(line.c_str(),
-        //                    "%p-%p %c%c%c",
-        //                    view_as<ptr_t*>(&start),
-        //                    view_as<ptr_t*>(&end),
-        //                    &prot[0],
-        //                    &prot[1],
-        //                    &prot[2]);
-
-        constexpr auto REGEX_HEX_NUMBER = "[0-9a-f]+";
-        constexpr auto REGEX_PROT       = "[r-][w-][x-][ps]";
-        constexpr auto REGEX_NAME       = "[0-9a-f]+-[0-9a-f]+ "
-                                          "[r-][w-][x-][ps] "
-                                          "[0-9a-f]+ "
-                                          "[0-9a-f][0-9a-f]:[0-9a-f][0-9a-f] "
-                                          "[0-9]+[ ]+";
-
-        std::smatch match;
-        const std::regex regex_hex_number(REGEX_HEX_NUMBER);
-
-        if (std::regex_search(line, match, regex_hex_number))
-        {
-            std::stringstream(match[0].str()) >> std::hex >> start;
-
-            auto suffix = match.suffix().str();
-
-            if (std::regex_search(suffix, match, regex_hex_number))
-            {
-                std::stringstream(match[0].str()) >> std::hex >> end;
-
-                suffix = match.suffix().str();
-
-                const std::regex regex_prot(REGEX_PROT);
-
-                if (std::regex_search(suffix, match, regex_prot))
-                {
-                    prot = match[0].str();
-                }
-                else
-                {
-                    ASURA_EXCEPTION("Could not find memory protections");
-                }
-            }
-            else
-            {
-                ASURA_EXCEPTION("Could not find end address");
-            }
-        }
-        else
-        {
-            ASURA_EXCEPTION("Could not find start address");
-        }
-
-        if (prot.size() != 4)
-        {
-            ASURA_EXCEPTION("Memory protection should have matched 4 "
-                            "characters");
-        }
-
-        const std::regex regex_name(REGEX_NAME);
-
-        /* Sometimes there's no name */
-        if (std::regex_search(line, match, regex_name))
-        {
-            name = line.substr(match[0].str().size(), line.size());
-        }
-
-        const auto is_on = [](char prot)
-        {
-            if (prot == '-')
-            {
-                return false;
-            }
-
-            return true;
-        };
-
-        const auto area = std::make_shared<ProcessMemoryArea>(
-          _process_base);
-        area->initProtectionFlags(
-          (is_on(prot[0]) ? MemoryArea::ProtectionFlags::READ : 0)
-          | (is_on(prot[1]) ? MemoryArea::ProtectionFlags::WRITE : 0)
-          | (is_on(prot[2]) ? MemoryArea::ProtectionFlags::EXECUTE : 0));
-        area->setAddress(view_as<ptr_t>(start));
-        area->setSize(end - start);
-        area->setName(name);
-
-        _areas.push_back(std::move(area));
+        add_area(ParseMapsLine(line));
     }
 
     file_memory_map.close();
@@ -182,9 +213,101 @@ auto ProcessMemoryMap::refresh() -> void
                                       module_path.end()));
         }
 
+        const auto is_file_backed = info.Type == MEM_IMAGE
+                                    or info.Type == MEM_MAPPED;
+
+        area->initMapping(0,
+                          0,
+                          is_file_backed ?
+                            view_as<std::uint64_t>(info.AllocationBase) :
+                            0);
+
         _areas.push_back(std::move(area));
     }
 
     CloseHandle(process_handle);
 #endif
+
+    buildIndex();
+}
+
+auto ProcessMemoryMap::areasByCategory(
+  const ProcessMemoryArea::Category category) const -> const areas_t&
+{
+    return _areas_by_category[category];
+}
+
+auto ProcessMemoryMap::moduleAreas() const
+  -> const std::vector<ModuleAreas>&
+{
+    return _module_areas;
+}
+
+auto ProcessMemoryMap::findArea(const std::uintptr_t address) const
+  -> areas_t::const_iterator
+{
+    const auto it = std::upper_bound(
+      _areas.begin(),
+      _areas.end(),
+      address,
+      [](const std::uintptr_t value,
+         const std::shared_ptr<ProcessMemoryArea>& area)
+      {
+          return value < area->begin();
+      });
+
+    if (it == _areas.begin() or address >= (*std::prev(it))->end())
+    {
+        return _areas.end();
+    }
+
+    return std::prev(it);
+}
+
+auto ProcessMemoryMap::buildIndex() -> void
+{
+    /* The OS gives them in order, backends might not */
+    const auto by_address = [](const std::shared_ptr<ProcessMemoryArea>& a,
+                               const std::shared_ptr<ProcessMemoryArea>& b)
+    {
+        return a->begin() < b->begin();
+    };
+
+    if (not std::is_sorted(_areas.begin(), _areas.end(), by_address))
+    {
+        std::sort(_areas.begin(), _areas.end(), by_address);
+    }
+
+    for (auto&& areas : _areas_by_category)
+    {
+        areas.clear();
+    }
+
+    _module_areas.clear();
+
+    /* (device, inode) -> index inside _module_areas */
+    std::map<std::tuple<std::uint64_t, std::uint64_t>, std::size_t>
+      module_indices;
+
+    for (const auto& area : _areas)
+    {
+        _areas_by_category[area->category()].push_back(area);
+
+        if (area->inode() == 0)
+        {
+            continue;
+        }
+
+        const auto [it, inserted] = module_indices.try_emplace(
+          { area->device(), area->inode() },
+          _module_areas.size());
+
+        if (inserted)
+        {
+            _module_areas.push_back(
+              { area->device(), area->inode(), area->name(), {} });
+        }
+
+        _module_areas[it->second].areas.push_back(area);
+    }
 }
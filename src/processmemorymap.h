@@ -12,12 +12,38 @@ namespace Asura
 
     class ProcessMemoryMap : public MemoryMap<ProcessMemoryArea>
     {
+      public:
+        using areas_t = std::vector<std::shared_ptr<ProcessMemoryArea>>;
+
+        /**
+         * Every area mapping the same file, grouped by device and
+         * inode, in address order.
+         * On Windows there's no inode, the allocation base of the image
+         * is used instead.
+         */
+        struct ModuleAreas
+        {
+            std::uint64_t device;
+            std::uint64_t inode;
+            std::string path;
+            areas_t areas;
+        };
+
       public:
         ProcessMemoryMap();
         explicit ProcessMemoryMap(ProcessBase process);
 
+      public:
+        /* Parses a line of /proc/pid/maps, throws when it's malformed */
+        static auto ParseMapsLine(const std::string_view line)
+          -> MemoryBackend::AreaDescription;
+
       public:
         auto refresh() -> void;
+        auto areasByCategory(
+          const ProcessMemoryArea::Category category) const
+          -> const areas_t&;
+        auto moduleAreas() const -> const std::vector<ModuleAreas>&;
 
       public:
         auto read(const auto address, const std::size_t size) const
@@ -28,6 +54,17 @@ namespace Asura
                                                       size);
         }
 
+        auto read(const auto address,
+                  const std::size_t size,
+                  std::pmr::memory_resource* const resource) const
+          -> pmr_bytes_t
+        {
+            return MemoryUtils::ReadProcessMemoryArea(_process_base.id(),
+                                                      address,
+                                                      size,
+                                                      resource);
+        }
+
         auto write(const auto address, const bytes_t& bytes) const -> void
         {
             MemoryUtils::WriteProcessMemoryArea(_process_base.id(),
@@ -45,6 +82,48 @@ namespace Asura
             write<decltype(address)>(address, data);
         }
 
+        /**
+         * Non throwing versions, failing costs about as much as the
+         * system call itself.
+         */
+        auto tryRead(const auto address,
+                     const ptr_t buffer,
+                     const std::size_t size) const -> Expected<void>
+        {
+            return MemoryUtils::TryReadProcessMemoryArea(_process_base.id(),
+                                                         address,
+                                                         buffer,
+                                                         size);
+        }
+
+        template <typename T>
+        auto tryRead(const auto address) const -> Expected<T>
+        {
+            return MemoryUtils::TryReadProcessMemory<T>(_process_base.id(),
+                                                        address);
+        }
+
+        auto tryWrite(const auto address, const bytes_t& bytes) const
+          -> Expected<void>
+        {
+            return MemoryUtils::TryWriteProcessMemoryArea(
+              _process_base.id(),
+              address,
+              bytes.data(),
+              bytes.size());
+        }
+
+        auto tryWrite(const auto address,
+                      const auto ptr,
+                      const std::size_t size) const -> Expected<void>
+        {
+            return MemoryUtils::TryWriteProcessMemoryArea(
+              _process_base.id(),
+              address,
+              view_as<const void*>(ptr),
+              size);
+        }
+
         auto searchNearestEmptyArea(const auto address) const
         {
             if (_areas.size() == 0)
@@ -145,19 +224,27 @@ namespace Asura
         auto search(const auto address) const
           -> std::shared_ptr<ProcessMemoryArea>
         {
-            for (const auto& area : _areas)
+            const auto it = findArea(view_as<std::uintptr_t>(address));
+
+            if (it == _areas.end())
             {
-                const auto start_ptr = area->begin();
-                const auto end_ptr   = area->end();
+                return nullptr;
+            }
 
-                if (view_as<std::uintptr_t>(address) >= start_ptr
-                    and view_as<std::uintptr_t>(address) < end_ptr)
-                {
-                    return area;
-                }
+            return *it;
+        }
+
+        /* Same without copying the shared pointer, for hot loops */
+        auto find(const auto address) const -> const ProcessMemoryArea*
+        {
+            const auto it = findArea(view_as<std::uintptr_t>(address));
+
+            if (it == _areas.end())
+            {
+                return nullptr;
             }
 
-            return nullptr;
+            return it->get();
         }
 
       public:
@@ -194,6 +281,25 @@ namespace Asura
             refresh();
         }
 
+        /* Only refreshes when it succeeded */
+        auto tryProtect(const auto address,
+                        const std::size_t size,
+                        const mapf_t flags) -> Expected<void>
+        {
+            const auto result = MemoryUtils::TryProtectMemoryArea(
+              _process_base.id(),
+              address,
+              size,
+              flags);
+
+            if (result)
+            {
+                refresh();
+            }
+
+            return result;
+        }
+
         auto forceWrite(const auto address, const bytes_t& bytes) -> void
         {
             refresh();
@@ -225,8 +331,17 @@ namespace Asura
             forceWrite(address, data);
         }
 
+      private:
+        auto buildIndex() -> void;
+        /* Binary search, the areas are kept in address order */
+        auto findArea(const std::uintptr_t address) const
+          -> areas_t::const_iterator;
+
       private:
         ProcessBase _process_base;
+        std::array<areas_t, ProcessMemoryArea::MAX_CATEGORIES>
+          _areas_by_category;
+        std::vector<ModuleAreas> _module_areas;
     };
 }
 
@@ -0,0 +1,363 @@
+#include "pch.h"
+
+#include "memorybackend.h"
+#include "memoryutils.h"
+#include "processsnapshot.h"
+#include "runnabletask.h"
+
+using namespace Asura;
+
+#if not defined(WINDOWS) and defined(__x86_64__)
+/* mov eax, __NR_pause; syscall; jmp back to the mov */
+static const bytes_t PAUSE_LOOP_CODE = {
+    0xB8, __NR_pause, 0x00, 0x00, 0x00, 0x0F, 0x05, 0xEB, 0xF7
+};
+
+static constexpr std::uint16_t SYSCALL_INSTRUCTION = 0x050F;
+
+/* Stops that aren't the one we're waiting for carry a signal to pass */
+static auto WaitForStop(const process_id_t pid, const int expectedStatus)
+  -> bool
+{
+    while (true)
+    {
+        int status;
+
+        if (waitpid(pid, &status, __WALL) < 0 or not WIFSTOPPED(status))
+        {
+            return false;
+        }
+
+        if ((status >> 8) == expectedStatus)
+        {
+            return true;
+        }
+
+        const auto signal = WSTOPSIG(status);
+
+        ptrace(PTRACE_CONT,
+               pid,
+               nullptr,
+               signal == SIGTRAP or signal == SIGSTOP ? 0 : signal);
+    }
+}
+
+/**
+ * The main thread of a target stopped with a syscall instruction at its
+ * instruction pointer, until Resume() puts everything back.
+ */
+struct Injection
+{
+    process_id_t pid;
+    user_regs_struct saved_regs;
+    ptr_t address;
+    long text;
+};
+
+static auto StopForInjection(const process_id_t pid, const long options)
+  -> Injection
+{
+    if (ptrace(PTRACE_SEIZE, pid, nullptr, options) < 0)
+    {
+        ASURA_EXCEPTION("Couldn't attach to " + std::to_string(pid) + ": "
+                        + std::strerror(errno));
+    }
+
+    ptrace(PTRACE_INTERRUPT, pid, nullptr, nullptr);
+
+    if (not WaitForStop(pid, SIGTRAP | (PTRACE_EVENT_STOP << 8)))
+    {
+        ptrace(PTRACE_DETACH, pid, nullptr, nullptr);
+        ASURA_EXCEPTION("Couldn't stop " + std::to_string(pid));
+    }
+
+    Injection injection {};
+    injection.pid = pid;
+    ptrace(PTRACE_GETREGS, pid, nullptr, &injection.saved_regs);
+
+    errno             = 0;
+    injection.address = view_as<ptr_t>(injection.saved_regs.rip);
+    injection.text    = ptrace(PTRACE_PEEKTEXT,
+                            pid,
+                            injection.address,
+                            nullptr);
+
+    if (errno != 0)
+    {
+        ptrace(PTRACE_DETACH, pid, nullptr, nullptr);
+        ASURA_EXCEPTION("Couldn't read the instruction pointer");
+    }
+
+    ptrace(PTRACE_POKETEXT,
+           pid,
+           injection.address,
+           (injection.text & ~view_as<long>(0xFFFF)) | SYSCALL_INSTRUCTION);
+
+    return injection;
+}
+
+/**
+ * Registers for a system call at the instruction pointer, orig_rax at -1
+ * so a syscall that was interrupted doesn't get restarted over ours.
+ */
+static auto SyscallRegs(const Injection& injection,
+                        const long number,
+                        const std::uint64_t arg0 = 0,
+                        const std::uint64_t arg1 = 0,
+                        const std::uint64_t arg2 = 0,
+                        const std::uint64_t arg3 = 0) -> user_regs_struct
+{
+    auto regs     = injection.saved_regs;
+    regs.rax      = view_as<decltype(regs.rax)>(number);
+    regs.orig_rax = view_as<decltype(regs.orig_rax)>(-1);
+    regs.rdi      = arg0;
+    regs.rsi      = arg1;
+    regs.rdx      = arg2;
+    regs.r10      = arg3;
+
+    return regs;
+}
+
+static auto Resume(const Injection& injection) -> void
+{
+    ptrace(PTRACE_POKETEXT,
+           injection.pid,
+           injection.address,
+           injection.text);
+    ptrace(PTRACE_SETREGS, injection.pid, nullptr, &injection.saved_regs);
+    ptrace(PTRACE_DETACH, injection.pid, nullptr, nullptr);
+}
+#endif
+
+auto ProcessSnapshot::IsRcloneSupported() -> bool
+{
+#ifdef WINDOWS
+    return false;
+#else
+    /**
+     * Probing the system call number isn't safe, stock kernels since 6.7
+     * have futex_wait there. The patched kernel is the only one with a
+     * sys_rclone symbol.
+     */
+    static const auto supported = []
+    {
+        std::ifstream kallsyms("/proc/kallsyms");
+        std::string line;
+
+        while (std::getline(kallsyms, line))
+        {
+            if (line.ends_with(" sys_rclone")
+                or line.ends_with(" __x64_sys_rclone")
+                or line.ends_with(" __ia32_sys_rclone"))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }();
+
+    return supported;
+#endif
+}
+
+ProcessSnapshot::ProcessSnapshot(const ProcessBase& target,
+                                 const Method method)
+ : _target(target.id()),
+   _method(method),
+   _id(Process::INVALID_PID)
+{
+#ifdef WINDOWS
+    ASURA_EXCEPTION("Snapshots aren't supported on Windows");
+#else
+    if (MemoryBackend::Find(_target.id()))
+    {
+        ASURA_EXCEPTION("Memory backends can't be snapshotted");
+    }
+
+    if (_method == AUTO)
+    {
+        _method = IsRcloneSupported() ? RCLONE : PTRACE;
+    }
+
+    if (_method == RCLONE)
+    {
+        forkWithRclone();
+    }
+    else
+    {
+        forkWithPtrace();
+    }
+#endif
+}
+
+ProcessSnapshot::~ProcessSnapshot()
+{
+    release();
+}
+
+auto ProcessSnapshot::id() const -> process_id_t
+{
+    return _id;
+}
+
+auto ProcessSnapshot::process() const -> Process
+{
+    return Process(_id);
+}
+
+auto ProcessSnapshot::method() const -> Method
+{
+    return _method;
+}
+
+auto ProcessSnapshot::pauseDuration() const -> std::chrono::nanoseconds
+{
+    return _pause_duration;
+}
+
+auto ProcessSnapshot::release() -> void
+{
+#ifndef WINDOWS
+    if (_id == Process::INVALID_PID)
+    {
+        return;
+    }
+
+    ::kill(_id, SIGKILL);
+
+    if (_method == RCLONE)
+    {
+        siginfo_t siginfo;
+        waitid(P_PID, view_as<id_t>(_id), &siginfo, WEXITED);
+    }
+#ifdef __x86_64__
+    else
+    {
+        /**
+         * We're the tracer, reaping it only hands the zombie over to the
+         * target, which gets no SIGCHLD for it. The target reaps it in
+         * a wait4 of our own, its waitpid(-1) never sees the child.
+         */
+        waitpid(_id, nullptr, __WALL);
+
+        try
+        {
+            const auto injection = StopForInjection(_target.id(), 0);
+            auto regs            = SyscallRegs(injection,
+                                    __NR_wait4,
+                                    view_as<std::uint64_t>(_id),
+                                    0,
+                                    __WALL | WNOHANG);
+
+            ptrace(PTRACE_SETREGS, injection.pid, nullptr, &regs);
+            ptrace(PTRACE_SINGLESTEP, injection.pid, nullptr, nullptr);
+            WaitForStop(injection.pid, SIGTRAP);
+            Resume(injection);
+        }
+        catch (Exception&)
+        {
+            /* The target is gone, init got the zombie */
+        }
+    }
+#endif
+
+    _id = Process::INVALID_PID;
+#endif
+}
+
+auto ProcessSnapshot::forkWithRclone() -> void
+{
+#if not defined(WINDOWS) and defined(__x86_64__)
+    const auto code = MemoryUtils::AllocArea(
+      _target.id(),
+      nullptr,
+      PAUSE_LOOP_CODE.size(),
+      MemoryArea::ProtectionFlags::RW);
+
+    MemoryUtils::WriteProcessMemoryArea(_target.id(),
+                                        PAUSE_LOOP_CODE,
+                                        code);
+    MemoryUtils::ProtectMemoryArea(_target.id(),
+                                   code,
+                                   PAUSE_LOOP_CODE.size(),
+                                   MemoryArea::ProtectionFlags::RX);
+
+    RunnableTask<STACK_SIZE> task(_target, code);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    try
+    {
+        task.run<true, false>();
+    }
+    catch (Exception&)
+    {
+        task.freeStack();
+        MemoryUtils::FreeArea(_target.id(), code, PAUSE_LOOP_CODE.size());
+        throw;
+    }
+
+    _pause_duration = std::chrono::steady_clock::now() - start;
+    _id             = view_as<process_id_t>(task.id());
+
+    /* The child has its own copies */
+    task.freeStack();
+    MemoryUtils::FreeArea(_target.id(), code, PAUSE_LOOP_CODE.size());
+#else
+    ASURA_EXCEPTION("rclone snapshots are only supported on x86_64 Linux");
+#endif
+}
+
+auto ProcessSnapshot::forkWithPtrace() -> void
+{
+#if not defined(WINDOWS) and defined(__x86_64__)
+    const auto pid   = _target.id();
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto injection = StopForInjection(pid, PTRACE_O_TRACECLONE);
+
+    /**
+     * A fork without exit signal, the target never gets a SIGCHLD for
+     * the child and only waits that ask for __WCLONE or __WALL see it.
+     */
+    auto regs = SyscallRegs(injection, __NR_clone);
+
+    ptrace(PTRACE_SETREGS, pid, nullptr, &regs);
+    ptrace(PTRACE_CONT, pid, nullptr, nullptr);
+
+    unsigned long child = 0;
+
+    const auto cloned = WaitForStop(pid,
+                                    SIGTRAP | (PTRACE_EVENT_CLONE << 8));
+
+    if (cloned)
+    {
+        ptrace(PTRACE_GETEVENTMSG, pid, nullptr, &child);
+
+        /* Let the system call return, then put everything back */
+        ptrace(PTRACE_SINGLESTEP, pid, nullptr, nullptr);
+        WaitForStop(pid, SIGTRAP);
+    }
+
+    Resume(injection);
+
+    _pause_duration = std::chrono::steady_clock::now() - start;
+
+    if (not cloned or child == 0)
+    {
+        ASURA_EXCEPTION("Couldn't fork " + std::to_string(pid));
+    }
+
+    _id = view_as<process_id_t>(child);
+
+    /**
+     * The child is attached to us and starts stopped, it stays in that
+     * stop until it gets killed. It got the patched instruction too.
+     */
+    waitpid(_id, nullptr, __WALL);
+    ptrace(PTRACE_POKETEXT, _id, injection.address, injection.text);
+#else
+    ASURA_EXCEPTION("ptrace snapshots are only supported on x86_64 Linux");
+#endif
+}
@@ -0,0 +1,75 @@
+#ifndef ASURA_PROCESSSNAPSHOT_H
+#define ASURA_PROCESSSNAPSHOT_H
+
+#include "process.h"
+#include "processbase.h"
+
+namespace Asura
+{
+    /**
+     * Copy on write image of a process, frozen at the time it was taken:
+     *
+     * ProcessSnapshot snapshot(process);
+     * PatternScanning::searchInProcess(pattern, snapshot.process());
+     *
+     * The target is forked without CLONE_VM, the child never runs any of
+     * the target code so its memory stays as it was. Scanning or dumping
+     * it gives a consistent result while the target goes on, the target
+     * is only paused for the fork.
+     *
+     * RCLONE uses our rclone system call, the child loops on pause().
+     * AUTO only picks it when the kernel has the sys_rclone symbol.
+     * PTRACE works on stock kernels, a clone without exit signal is
+     * injected in the main thread and the child is kept in its ptrace
+     * stop. In both cases the child is killed and reaped when the
+     * snapshot is released.
+     * With PTRACE the target is the real parent of the child, it gets no
+     * SIGCHLD for it and a wait4 is injected to reap it on release.
+     */
+    class ProcessSnapshot
+    {
+      public:
+        enum Method : byte_t
+        {
+            AUTO,
+            RCLONE,
+            PTRACE
+        };
+
+        static constexpr std::size_t STACK_SIZE = 0x2000;
+
+      public:
+        static auto IsRcloneSupported() -> bool;
+
+      public:
+        explicit ProcessSnapshot(const ProcessBase& target,
+                                 const Method method = AUTO);
+        ~ProcessSnapshot();
+
+        ProcessSnapshot(const ProcessSnapshot&)                    = delete;
+        auto operator=(const ProcessSnapshot&) -> ProcessSnapshot& = delete;
+
+      public:
+        /* pid of the frozen child */
+        auto id() const -> process_id_t;
+        auto process() const -> Process;
+        auto method() const -> Method;
+        /* How long the target was stopped */
+        auto pauseDuration() const -> std::chrono::nanoseconds;
+
+      public:
+        auto release() -> void;
+
+      private:
+        auto forkWithRclone() -> void;
+        auto forkWithPtrace() -> void;
+
+      private:
+        ProcessBase _target;
+        Method _method;
+        process_id_t _id;
+        std::chrono::nanoseconds _pause_duration {};
+    };
+}
+
+#endif
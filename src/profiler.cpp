@@ -0,0 +1,295 @@
+#include "pch.h"
+
+#include "exception.h"
+#include "memoryutils.h"
+#include "profiler.h"
+
+using namespace Asura;
+
+#ifndef WINDOWS
+/* The records can wrap around the end of the ring */
+static auto CopyFromRing(const byte_t* data,
+                         const std::size_t dataSize,
+                         const std::uint64_t offset,
+                         const ptr_t destination,
+                         const std::size_t size) -> void
+{
+    const auto start = view_as<std::size_t>(offset % dataSize);
+    const auto first = std::min(size, dataSize - start);
+
+    std::memcpy(destination, data + start, first);
+    std::memcpy(view_as<byte_t*>(destination) + first, data, size - first);
+}
+
+Profiler::Profiler(const ProcessBase& processBase,
+                   const std::size_t frequency,
+                   const std::size_t ringPages)
+ : _process_base(processBase),
+   _page_size(MemoryUtils::GetPageSize())
+{
+    if (frequency == 0)
+    {
+        ASURA_EXCEPTION("The sampling frequency can't be 0");
+    }
+
+    if (ringPages == 0 or not std::has_single_bit(ringPages))
+    {
+        ASURA_EXCEPTION("The ring pages count must be a power of two");
+    }
+
+    /* The CPU clock counts nanoseconds */
+    _period    = std::max<std::uint64_t>(1'000'000'000 / frequency, 1);
+    _ring_size = ringPages * _page_size;
+
+    try
+    {
+        attach();
+    }
+    catch (...)
+    {
+        detach();
+        throw;
+    }
+}
+
+Profiler::~Profiler()
+{
+    detach();
+}
+
+auto Profiler::attach() -> std::size_t
+{
+    std::size_t attached_count = 0;
+
+    for (const auto& task : Task::list(_process_base))
+    {
+        if (std::any_of(_streams.begin(),
+                        _streams.end(),
+                        [&](const Stream& stream)
+                        {
+                            return stream.thread_id == task.id();
+                        }))
+        {
+            continue;
+        }
+
+        perf_event_attr attributes {};
+        attributes.size           = sizeof(attributes);
+        attributes.type           = PERF_TYPE_SOFTWARE;
+        attributes.config         = PERF_COUNT_SW_CPU_CLOCK;
+        attributes.sample_period  = _period;
+        attributes.sample_type    = PERF_SAMPLE_IP;
+        attributes.disabled       = not _running;
+        attributes.exclude_kernel = true;
+        attributes.exclude_hv     = true;
+
+        const auto fd = view_as<int>(syscall(SYS_perf_event_open,
+                                             &attributes,
+                                             task.id(),
+                                             -1,
+                                             -1,
+                                             PERF_FLAG_FD_CLOEXEC));
+
+        if (fd < 0)
+        {
+            /* Exited since it was listed */
+            if (errno == ESRCH)
+            {
+                continue;
+            }
+
+            ASURA_EXCEPTION("Couldn't open a perf event for thread "
+                            + std::to_string(task.id()) + ": "
+                            + std::strerror(errno));
+        }
+
+        /* Writable, so the kernel doesn't overwrite unread samples */
+        const auto ring = mmap(nullptr,
+                               _page_size + _ring_size,
+                               PROT_READ | PROT_WRITE,
+                               MAP_SHARED,
+                               fd,
+                               0);
+
+        if (ring == MAP_FAILED)
+        {
+            close(fd);
+            ASURA_EXCEPTION("Couldn't map the ring buffer of thread "
+                            + std::to_string(task.id()));
+        }
+
+        _streams.push_back({ task.id(), fd, view_as<byte_t*>(ring) });
+        attached_count++;
+    }
+
+    return attached_count;
+}
+
+auto Profiler::start() -> void
+{
+    for (const auto& stream : _streams)
+    {
+        ioctl(stream.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    _running = true;
+}
+
+auto Profiler::stop() -> void
+{
+    for (const auto& stream : _streams)
+    {
+        ioctl(stream.fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    _running = false;
+}
+
+auto Profiler::collect() -> std::size_t
+{
+    std::size_t new_samples = 0;
+
+    for (const auto& stream : _streams)
+    {
+        const auto header = view_as<perf_event_mmap_page*>(stream.ring);
+        const auto data   = stream.ring + _page_size;
+
+        /* Pairs with the kernel writing the records before the head */
+        const auto head = __atomic_load_n(&header->data_head,
+                                          __ATOMIC_ACQUIRE);
+        auto tail       = header->data_tail;
+
+        while (tail < head)
+        {
+            perf_event_header record;
+            CopyFromRing(data, _ring_size, tail, &record, sizeof(record));
+
+            switch (record.type)
+            {
+                case PERF_RECORD_SAMPLE:
+                {
+                    std::uint64_t ip;
+                    CopyFromRing(data,
+                                 _ring_size,
+                                 tail + sizeof(record),
+                                 &ip,
+                                 sizeof(ip));
+
+                    _samples[view_as<std::uintptr_t>(ip)]++;
+                    new_samples++;
+                    break;
+                }
+
+                /* id, then the count */
+                case PERF_RECORD_LOST:
+                {
+                    std::uint64_t lost;
+                    CopyFromRing(data,
+                                 _ring_size,
+                                 tail + sizeof(record)
+                                   + sizeof(std::uint64_t),
+                                 &lost,
+                                 sizeof(lost));
+
+                    _lost_count += view_as<std::size_t>(lost);
+                    break;
+                }
+            }
+
+            tail += record.size;
+        }
+
+        /* The kernel can reuse the space once it sees the tail */
+        __atomic_store_n(&header->data_tail, tail, __ATOMIC_RELEASE);
+    }
+
+    _samples_count += new_samples;
+
+    return new_samples;
+}
+
+auto Profiler::report(const SymbolIndex& symbolIndex) const -> Report
+{
+    Report report { _samples_count, _lost_count, {} };
+
+    /* By symbol, or by module for the addresses in no known function */
+    std::map<std::pair<const void*, const void*>, std::size_t> indices;
+
+    for (const auto& [ip, count] : _samples)
+    {
+        const auto location = symbolIndex.resolve(ip);
+        const std::pair<const void*, const void*> key {
+            location.module,
+            location.symbol
+        };
+
+        const auto [it, inserted] = indices.try_emplace(
+          key,
+          report.entries.size());
+
+        if (inserted)
+        {
+            Entry entry { {}, {}, 0, 0 };
+
+            if (location.module)
+            {
+                entry.module  = location.module->name();
+                entry.address = view_as<std::uintptr_t>(
+                  location.module->baseAddress());
+            }
+
+            if (location.symbol)
+            {
+                entry.symbol  = location.symbol->name;
+                entry.address = location.symbol->address;
+            }
+
+            report.entries.push_back(std::move(entry));
+        }
+
+        report.entries[it->second].samples += count;
+    }
+
+    std::sort(report.entries.begin(),
+              report.entries.end(),
+              [](const Entry& left, const Entry& right)
+              {
+                  return left.samples > right.samples;
+              });
+
+    return report;
+}
+
+auto Profiler::reset() -> void
+{
+    _samples.clear();
+    _samples_count = 0;
+    _lost_count    = 0;
+}
+
+auto Profiler::detach() -> void
+{
+    for (auto&& stream : _streams)
+    {
+        munmap(stream.ring, _page_size + _ring_size);
+        close(stream.fd);
+    }
+
+    _streams.clear();
+}
+
+auto Profiler::threadsCount() const -> std::size_t
+{
+    return _streams.size();
+}
+
+auto Profiler::samplesCount() const -> std::size_t
+{
+    return _samples_count;
+}
+
+auto Profiler::lostCount() const -> std::size_t
+{
+    return _lost_count;
+}
+#endif
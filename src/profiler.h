@@ -0,0 +1,111 @@
+#ifndef ASURA_PROFILER_H
+#define ASURA_PROFILER_H
+
+#include "process.h"
+#include "symbolindex.h"
+#include "task.h"
+
+#ifndef WINDOWS
+namespace Asura
+{
+    /**
+     * Sampling profiler for the threads of a process:
+     *
+     * Profiler profiler(process);
+     * profiler.start();
+     * ... then every now and then
+     * profiler.collect();
+     * ...
+     * for (auto&& entry : profiler.report(SymbolIndex(process)).entries)
+     *     entry.module, entry.symbol, entry.samples
+     *
+     * Every thread gets a perf_event_open software CPU clock, only
+     * ticking while the thread runs, that samples its instruction
+     * pointer in user space. The kernel writes the samples into a ring
+     * buffer mapped in our memory, collecting them is reading memory,
+     * no syscall and no stopping the target. Samples are only counted
+     * by address, symbols are resolved in report().
+     * Threads created after attach() aren't sampled until it's called
+     * again. When collect() isn't called often enough the ring buffers
+     * fill up and the kernel drops samples, they're counted as lost.
+     */
+    class Profiler
+    {
+      public:
+        /* Not a multiple of the usual timer rates, to not be in phase */
+        static constexpr std::size_t DEFAULT_FREQUENCY = 997;
+        /* A power of two */
+        static constexpr std::size_t DEFAULT_RING_PAGES = 8;
+
+        struct Entry
+        {
+            /* Empty when the address isn't in a module */
+            std::string module;
+            /* Empty when it's in no known function */
+            std::string symbol;
+            /* Of the symbol, else of the module */
+            std::uintptr_t address;
+            std::size_t samples;
+        };
+
+        struct Report
+        {
+            std::size_t samples;
+            std::size_t lost;
+            /* Most samples first */
+            std::vector<Entry> entries;
+        };
+
+      public:
+        /* frequency is in samples per second of CPU time */
+        explicit Profiler(const ProcessBase& processBase,
+                          const std::size_t frequency = DEFAULT_FREQUENCY,
+                          const std::size_t ringPages = DEFAULT_RING_PAGES);
+        ~Profiler();
+
+        Profiler(const Profiler&)                    = delete;
+        auto operator=(const Profiler&) -> Profiler& = delete;
+
+      public:
+        /* Attaches to the new threads, returns how many */
+        auto attach() -> std::size_t;
+        auto start() -> void;
+        auto stop() -> void;
+        /* Reads the ring buffers, returns the count of new samples */
+        auto collect() -> std::size_t;
+        auto report(const SymbolIndex& symbolIndex) const -> Report;
+        /* Forgets the samples, the threads stay attached */
+        auto reset() -> void;
+
+      public:
+        auto threadsCount() const -> std::size_t;
+        auto samplesCount() const -> std::size_t;
+        auto lostCount() const -> std::size_t;
+
+      private:
+        struct Stream
+        {
+            thread_id_t thread_id;
+            int fd;
+            byte_t* ring;
+        };
+
+      private:
+        auto detach() -> void;
+
+      private:
+        ProcessBase _process_base;
+        std::uint64_t _period;
+        std::size_t _page_size;
+        std::size_t _ring_size;
+        bool _running {};
+
+        std::vector<Stream> _streams;
+        std::unordered_map<std::uintptr_t, std::size_t> _samples;
+        std::size_t _samples_count {};
+        std::size_t _lost_count {};
+    };
+}
+#endif
+
+#endif
@@ -0,0 +1,388 @@
+#ifndef ASURA_REMOTEVIEW_H
+#define ASURA_REMOTEVIEW_H
+
+#include "expected.h"
+#include "memoryutils.h"
+#include "offset.h"
+#include "processbase.h"
+
+namespace Asura
+{
+    template <std::size_t O, typename T>
+      requires std::is_trivially_copyable_v<T>
+    struct RemoteField
+    {
+        using type = T;
+
+        static constexpr std::size_t offset = O;
+        static constexpr std::size_t size   = sizeof(T);
+    };
+
+    template <typename... F>
+    struct RemoteLayout
+    {
+    };
+
+    template <typename L>
+    class RemoteView;
+
+    /**
+     * Local copy of a remote object, with its fields known at compile
+     * time:
+     *
+     * using Health   = RemoteField<0x10, float>;
+     * using Position = RemoteField<0x40, Vector3>;
+     * RemoteView<RemoteLayout<Health, Position>> player(process, addr);
+     *
+     * player.fetch();
+     * player.set<Health>(player.get<Health>() + 10.f);
+     * player.commit();
+     *
+     * fetch() reads every field with a single process_vm_readv, fields
+     * close to each other are read as one range. commit() only writes
+     * back the fields that were set, also in a single call.
+     * The copy is laid out like the remote object, so Offset based
+     * classes can be used on it through local().
+     */
+    template <typename... F>
+    class RemoteView<RemoteLayout<F...>>
+    {
+      public:
+        static constexpr std::size_t FIELDS_COUNT = sizeof...(F);
+        /* Reading a few more bytes is cheaper than one more iovec */
+        static constexpr std::size_t COALESCE_GAP = 64;
+
+        struct Range
+        {
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        struct Ranges
+        {
+            std::array<Range, FIELDS_COUNT> ranges;
+            std::size_t count;
+        };
+
+        static_assert(FIELDS_COUNT > 0, "Layout must have fields");
+
+      private:
+        static constexpr auto Coalesce(
+          std::array<Range, FIELDS_COUNT> ranges,
+          const std::size_t gap) -> Ranges
+        {
+            std::sort(ranges.begin(),
+                      ranges.end(),
+                      [](const Range& a, const Range& b)
+                      {
+                          return a.offset < b.offset;
+                      });
+
+            Ranges result {};
+
+            for (const auto& range : ranges)
+            {
+                if (result.count > 0)
+                {
+                    auto& last           = result.ranges[result.count - 1];
+                    const auto last_end  = last.offset + last.size;
+                    const auto range_end = range.offset + range.size;
+
+                    if (range.offset <= last_end + gap)
+                    {
+                        last.size = std::max(last_end, range_end)
+                                    - last.offset;
+                        continue;
+                    }
+                }
+
+                result.ranges[result.count++] = range;
+            }
+
+            return result;
+        }
+
+        static constexpr auto SortFields(
+          const std::array<Range, FIELDS_COUNT>& ranges)
+          -> std::array<std::size_t, FIELDS_COUNT>
+        {
+            std::array<std::size_t, FIELDS_COUNT> order {};
+
+            for (std::size_t i = 0; i < FIELDS_COUNT; i++)
+            {
+                order[i] = i;
+            }
+
+            std::sort(order.begin(),
+                      order.end(),
+                      [&](const std::size_t a, const std::size_t b)
+                      {
+                          return ranges[a].offset < ranges[b].offset;
+                      });
+
+            return order;
+        }
+
+        template <typename G>
+        static consteval auto FieldIndex() -> std::size_t
+        {
+            constexpr std::array<bool, FIELDS_COUNT> matches {
+                std::is_same_v<G, F>...
+            };
+
+            for (std::size_t i = 0; i < FIELDS_COUNT; i++)
+            {
+                if (matches[i])
+                {
+                    return i;
+                }
+            }
+
+            return FIELDS_COUNT;
+        }
+
+      public:
+        static constexpr std::array<Range, FIELDS_COUNT> FIELD_RANGES {
+            Range { F::offset, F::size }...
+        };
+
+        static constexpr std::size_t SPAN_SIZE = std::max(
+          { (F::offset + F::size)... });
+
+        static constexpr Ranges READ_RANGES = Coalesce(FIELD_RANGES,
+                                                       COALESCE_GAP);
+
+        /* Field indices sorted by offset */
+        static constexpr std::array<std::size_t, FIELDS_COUNT> FIELD_ORDER
+          = SortFields(FIELD_RANGES);
+
+      public:
+        RemoteView(const ProcessBase& processBase, const auto address)
+         : _process_base(processBase.id()),
+           _address(view_as<std::uintptr_t>(address))
+        {
+        }
+
+      public:
+        auto address() const -> std::uintptr_t
+        {
+            return _address;
+        }
+
+        template <typename G>
+        auto get() const -> typename G::type
+        {
+            static_assert(FieldIndex<G>() < FIELDS_COUNT,
+                          "Field is not part of the layout");
+
+            typename G::type value;
+            std::memcpy(&value, &_data[G::offset], sizeof(value));
+            return value;
+        }
+
+        template <typename G>
+        auto isDirty() const -> bool
+        {
+            return _dirty.test(FieldIndex<G>());
+        }
+
+        template <typename T = Offset>
+        auto local() const -> const T*
+        {
+            return view_as<const T*>(_data.data());
+        }
+
+      public:
+        /* Reuse the view for another object of the same layout */
+        auto setAddress(const auto address) -> void
+        {
+            _address = view_as<std::uintptr_t>(address);
+            _dirty.reset();
+        }
+
+        template <typename G>
+        auto set(const typename G::type& value) -> void
+        {
+            static_assert(FieldIndex<G>() < FIELDS_COUNT,
+                          "Field is not part of the layout");
+
+            std::memcpy(&_data[G::offset], &value, sizeof(value));
+            _dirty.set(FieldIndex<G>());
+        }
+
+        auto tryFetch() -> Expected<void>
+        {
+            const auto result = transfer(READ_RANGES, false);
+
+            if (result)
+            {
+                _dirty.reset();
+            }
+
+            return result;
+        }
+
+        auto fetch() -> void
+        {
+            const auto result = tryFetch();
+
+            if (not result)
+            {
+                ASURA_EXCEPTION(std::string("Couldn't fetch remote view: ")
+                                + ErrorCodeStr(result.error()));
+            }
+        }
+
+        auto tryCommit() -> Expected<void>
+        {
+            if (_dirty.none())
+            {
+                return {};
+            }
+
+            /**
+             * Only merge fields that touch, the bytes in between weren't
+             * set and may be outdated.
+             */
+            Ranges ranges {};
+
+            for (const auto index : FIELD_ORDER)
+            {
+                if (not _dirty.test(index))
+                {
+                    continue;
+                }
+
+                const auto& range = FIELD_RANGES[index];
+
+                if (ranges.count > 0)
+                {
+                    auto& last          = ranges.ranges[ranges.count - 1];
+                    const auto last_end = last.offset + last.size;
+
+                    if (range.offset <= last_end)
+                    {
+                        last.size = std::max(last_end,
+                                             range.offset + range.size)
+                                    - last.offset;
+                        continue;
+                    }
+                }
+
+                ranges.ranges[ranges.count++] = range;
+            }
+
+            const auto result = transfer(ranges, true);
+
+            if (result)
+            {
+                _dirty.reset();
+            }
+
+            return result;
+        }
+
+        auto commit() -> void
+        {
+            const auto result = tryCommit();
+
+            if (not result)
+            {
+                ASURA_EXCEPTION(std::string("Couldn't commit remote view: ")
+                                + ErrorCodeStr(result.error()));
+            }
+        }
+
+      private:
+        auto transfer(const Ranges& ranges, const bool write)
+          -> Expected<void>
+        {
+#ifndef WINDOWS
+            if (MemoryBackend::Find(_process_base.id()))
+            {
+                return transferEach(ranges, write);
+            }
+
+            std::array<iovec, FIELDS_COUNT> locals;
+            std::array<iovec, FIELDS_COUNT> remotes;
+            std::size_t total_size = 0;
+
+            for (std::size_t i = 0; i < ranges.count; i++)
+            {
+                const auto& range = ranges.ranges[i];
+
+                locals[i]  = { .iov_base = &_data[range.offset],
+                               .iov_len  = range.size };
+                remotes[i] = { .iov_base = view_as<ptr_t>(_address
+                                                          + range.offset),
+                               .iov_len  = range.size };
+                total_size += range.size;
+            }
+
+            const auto ret = write ? process_vm_writev(_process_base.id(),
+                                                       locals.data(),
+                                                       ranges.count,
+                                                       remotes.data(),
+                                                       ranges.count,
+                                                       0) :
+                                     process_vm_readv(_process_base.id(),
+                                                      locals.data(),
+                                                      ranges.count,
+                                                      remotes.data(),
+                                                      ranges.count,
+                                                      0);
+
+            if (ret < 0)
+            {
+                return Unexpected(LastErrorCode());
+            }
+
+            if (view_as<std::size_t>(ret) != total_size)
+            {
+                return Unexpected(ErrorCode::PARTIAL_TRANSFER);
+            }
+
+            return {};
+#else
+            return transferEach(ranges, write);
+#endif
+        }
+
+        /* One call per range, for Windows and memory backends */
+        auto transferEach(const Ranges& ranges, const bool write)
+          -> Expected<void>
+        {
+            for (std::size_t i = 0; i < ranges.count; i++)
+            {
+                const auto& range = ranges.ranges[i];
+
+                const auto result = write ?
+                                      MemoryUtils::TryWriteProcessMemoryArea(
+                                        _process_base.id(),
+                                        _address + range.offset,
+                                        &_data[range.offset],
+                                        range.size) :
+                                      MemoryUtils::TryReadProcessMemoryArea(
+                                        _process_base.id(),
+                                        _address + range.offset,
+                                        &_data[range.offset],
+                                        range.size);
+
+                if (not result)
+                {
+                    return result;
+                }
+            }
+
+            return {};
+        }
+
+      private:
+        ProcessBase _process_base;
+        std::uintptr_t _address;
+        alignas(std::max_align_t) std::array<byte_t, SPAN_SIZE> _data {};
+        std::bitset<FIELDS_COUNT> _dirty;
+    };
+}
+
+#endif
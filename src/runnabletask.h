@@ -27,7 +27,11 @@ namespace Asura
       public:
         auto& routineAddress();
 
-        template <bool untraced>
+        /**
+         * Without sharedMemory the task gets a copy on write of the
+         * process memory, like fork.
+         */
+        template <bool untraced, bool sharedMemory = true>
         auto run() -> void;
 
       public:
@@ -128,7 +132,7 @@ namespace Asura
     }
 
     template <std::size_t N>
-    template <bool untraced>
+    template <bool untraced, bool sharedMemory>
     auto RunnableTask<N>::run() -> void
     {
 #ifdef WINDOWS
@@ -172,9 +176,11 @@ namespace Asura
             return 0;
         }();
 
+        constexpr auto vm_flag = sharedMemory ? CLONE_VM : 0;
+
         _id = syscall(__NR_rclone,
                       _process_base.id(),
-                      CLONE_VM | SIGCHLD | untraced_flag,
+                      vm_flag | SIGCHLD | untraced_flag,
                       _routine_address,
                       view_as<std::uintptr_t>(_base_stack) - N
                         + MemoryUtils::GetPageSize(),
@@ -158,6 +158,21 @@ namespace Asura
 #endif
         }
 
+        static inline auto Xor(const auto mm1, const auto mm2)
+        {
+#if defined(__AVX512BW__)
+            return _mm512_xor_si512(mm1, mm2);
+#elif defined(__AVX2__)
+            return _mm256_xor_si256(mm1, mm2);
+#elif defined(__SSE2__)
+            return _mm_xor_si128(mm1, mm2);
+#elif defined(__SSE__)
+            return _mm_xor_si64(mm1, mm2);
+#else
+            return mm1 ^ mm2;
+#endif
+        }
+
         static inline auto Load(const auto mm1)
         {
 #if defined(__AVX512BW__)
@@ -188,6 +203,21 @@ namespace Asura
 #endif
         }
 
+        static inline auto StoreUnaligned(const auto mm1, const auto mm2)
+        {
+#if defined(__AVX512BW__)
+            _mm512_storeu_si512(view_as<__m512i*>(mm1), mm2);
+#elif defined(__AVX2__)
+            _mm256_storeu_si256(view_as<__m256i*>(mm1), mm2);
+#elif defined(__SSE2__)
+            _mm_storeu_si128(mm1, mm2);
+#elif defined(__SSE__)
+            *view_as<__m64*>(mm1) = mm2;
+#else
+            *mm1 = mm2;
+#endif
+        }
+
         static inline auto LoadAuto(const auto mm1)
         {
             return ((view_as<std::uintptr_t>(mm1) & (sizeof(value_t) - 1))
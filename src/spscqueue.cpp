@@ -0,0 +1,3 @@
+#include "pch.h"
+
+#include "spscqueue.h"
@@ -0,0 +1,96 @@
+#ifndef ASURA_SPSCQUEUE_H
+#define ASURA_SPSCQUEUE_H
+
+#include "types.h"
+
+namespace Asura
+{
+    /**
+     * Lock free queue for exactly one producer thread and one consumer
+     * thread. N must be a power of two, push fails when it's full.
+     * Head and tail are on their own cache lines, so both sides don't
+     * keep stealing the line from each other.
+     */
+    template <typename T, std::size_t N>
+    class SPSCQueue
+    {
+        static_assert(std::has_single_bit(N), "N must be a power of two");
+
+      public:
+        static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+      public:
+        SPSCQueue();
+
+        SPSCQueue(const SPSCQueue&)                    = delete;
+        auto operator=(const SPSCQueue&) -> SPSCQueue& = delete;
+
+      public:
+        auto size() const -> std::size_t;
+        auto empty() const -> bool;
+
+      public:
+        /* Producer side */
+        auto push(T element) -> bool;
+        /* Consumer side */
+        auto pop() -> std::optional<T>;
+
+      private:
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head {};
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail {};
+        alignas(CACHE_LINE_SIZE) std::vector<T> _slots;
+    };
+
+    template <typename T, std::size_t N>
+    SPSCQueue<T, N>::SPSCQueue()
+     : _slots(N)
+    {
+    }
+
+    template <typename T, std::size_t N>
+    auto SPSCQueue<T, N>::size() const -> std::size_t
+    {
+        return _tail.load(std::memory_order_acquire)
+               - _head.load(std::memory_order_acquire);
+    }
+
+    template <typename T, std::size_t N>
+    auto SPSCQueue<T, N>::empty() const -> bool
+    {
+        return size() == 0;
+    }
+
+    template <typename T, std::size_t N>
+    auto SPSCQueue<T, N>::push(T element) -> bool
+    {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+
+        if (tail - _head.load(std::memory_order_acquire) == N)
+        {
+            return false;
+        }
+
+        _slots[tail & (N - 1)] = std::move(element);
+        _tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    template <typename T, std::size_t N>
+    auto SPSCQueue<T, N>::pop() -> std::optional<T>
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+
+        if (head == _tail.load(std::memory_order_acquire))
+        {
+            return std::nullopt;
+        }
+
+        auto element = std::move(_slots[head & (N - 1)]);
+        _head.store(head + 1, std::memory_order_release);
+
+        return element;
+    }
+}
+
+#endif
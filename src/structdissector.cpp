@@ -0,0 +1,354 @@
+#include "pch.h"
+
+#include "memoryutils.h"
+#include "structdissector.h"
+
+using namespace Asura;
+
+/**
+ * Classify 32 bits values, kept branchless so it gets vectorized.
+ * Small integers have a null exponent (or all bits set if negative)
+ * when viewed as a float, so they never overlap with FLOAT.
+ * The ranges are checked with a single unsigned comparison each, and
+ * the vectors are only touched through their data, stores to byte
+ * types could alias them otherwise.
+ */
+static auto Classify32bits(const std::vector<std::uint32_t>& values,
+                           std::vector<StructDissector::SlotType>& types)
+  -> void
+{
+    constexpr std::uint32_t float_min_exponent = 127 - 20;
+    constexpr std::uint32_t float_exponents    = 40;
+    constexpr auto small_int_max = view_as<std::uint32_t>(
+      StructDissector::SMALL_INT_MAX);
+
+    const auto count       = values.size();
+    const auto values_data = values.data();
+    const auto types_data  = types.data();
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const auto value    = values_data[i];
+        const auto exponent = (value >> 23) & 0xFF;
+        const auto is_zero  = value == 0;
+        const auto is_small_int = value + (small_int_max - 1)
+                                  < 2 * small_int_max - 1;
+        const auto is_float = exponent - float_min_exponent
+                              <= float_exponents;
+
+        types_data[i] = is_zero ?
+                          StructDissector::ZERO :
+                          (is_small_int ?
+                             StructDissector::SMALL_INT :
+                             (is_float ? StructDissector::FLOAT :
+                                         StructDissector::UNKNOWN));
+    }
+}
+
+static auto MakeSlot(const std::size_t offset,
+                     const std::size_t size,
+                     const std::vector<StructDissector::SlotType>& types,
+                     const std::vector<bool>& valids)
+  -> StructDissector::Slot
+{
+    StructDissector::Slot slot { offset,
+                                 size,
+                                 StructDissector::UNKNOWN,
+                                 0.f,
+                                 {} };
+
+    std::size_t valid_count = 0;
+
+    for (std::size_t i = 0; i < types.size(); i++)
+    {
+        if (valids[i])
+        {
+            slot.votes[types[i]]++;
+            valid_count++;
+        }
+    }
+
+    /**
+     * Null values are ambiguous (null pointer, zero integer...), so they
+     * only win if nothing else has been seen.
+     */
+    const auto best = std::max_element(slot.votes.begin()
+                                         + StructDissector::SMALL_INT,
+                                       slot.votes.end());
+
+    if (*best > 0)
+    {
+        slot.type = view_as<StructDissector::SlotType>(
+          std::distance(slot.votes.begin(), best));
+
+        slot.confidence = view_as<float>(*best)
+                          / view_as<float>(
+                            valid_count
+                            - slot.votes[StructDissector::ZERO]);
+    }
+    else if (slot.votes[StructDissector::ZERO] > 0)
+    {
+        slot.type       = StructDissector::ZERO;
+        slot.confidence = view_as<float>(
+                            slot.votes[StructDissector::ZERO])
+                          / view_as<float>(valid_count);
+    }
+
+    return slot;
+}
+
+auto StructDissector::SlotTypeStr(const SlotType slotType) -> std::string
+{
+    static const std::string strings[] = { "unknown",
+                                           "zero",
+                                           "small int",
+                                           "float",
+                                           "heap pointer",
+                                           "module pointer",
+                                           "string pointer",
+                                           "vtable" };
+
+    if (slotType >= MAX_SLOT_TYPES)
+    {
+        return "unknown";
+    }
+
+    return strings[slotType];
+}
+
+StructDissector::StructDissector(const Process& process)
+ : _process_base(process.id())
+{
+    refresh(process.mmap());
+}
+
+auto StructDissector::mmap() const -> const ProcessMemoryMap&
+{
+    return _mmap;
+}
+
+auto StructDissector::search(const std::uintptr_t address) const
+  -> const ProcessMemoryArea*
+{
+    const auto area = _mmap.find(address);
+
+    if (not area or area->isDeniedByOS())
+    {
+        return nullptr;
+    }
+
+    return area;
+}
+
+auto StructDissector::refresh(const ProcessMemoryMap& mmap) -> void
+{
+    _mmap = mmap;
+
+    const auto& areas = _mmap.areas();
+
+    if (areas.empty())
+    {
+        _lowest_address  = 0;
+        _highest_address = 0;
+        return;
+    }
+
+    _lowest_address  = areas.front()->begin();
+    _highest_address = areas.back()->end();
+}
+
+auto StructDissector::classifyPointers(
+  const std::vector<std::uintptr_t>& values,
+  const std::vector<bool>& valids,
+  std::vector<SlotType>& types) const -> void
+{
+    std::vector<byte_t> candidates(values.size());
+
+    constexpr auto small_int_max = view_as<std::uintptr_t>(SMALL_INT_MAX);
+
+    const auto addresses_size = _highest_address - _lowest_address;
+
+    /* First pass, branchless pre-filter on the whole column */
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        const auto value        = values[i];
+        const auto is_zero      = value == 0;
+        const auto is_small_int = value + (small_int_max - 1)
+                                  < 2 * small_int_max - 1;
+
+        candidates[i] = value - _lowest_address < addresses_size;
+
+        types[i] = is_zero ? ZERO : (is_small_int ? SMALL_INT : UNKNOWN);
+    }
+
+    /**
+     * Second pass, only values that fell inside the address space get
+     * looked up, and the ones pointing to data are dereferenced all at
+     * once.
+     */
+    std::vector<const ProcessMemoryArea*> pointed_areas(values.size());
+    std::vector<std::uintptr_t> deref_addresses;
+
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        if (not candidates[i] or not valids[i])
+        {
+            continue;
+        }
+
+        const auto area = search(values[i]);
+
+        if (not area or not area->isReadable())
+        {
+            continue;
+        }
+
+        pointed_areas[i] = area;
+
+        if (area->protectionFlags().cachedValue()
+            & MemoryArea::ProtectionFlags::X)
+        {
+            types[i] = area->isFileBacked() ? MODULE_POINTER :
+                                              HEAP_POINTER;
+            continue;
+        }
+
+        deref_addresses.push_back(values[i]);
+    }
+
+    std::sort(deref_addresses.begin(), deref_addresses.end());
+    deref_addresses.erase(std::unique(deref_addresses.begin(),
+                                      deref_addresses.end()),
+                          deref_addresses.end());
+
+    const auto [derefs, deref_valids] = MemoryUtils::ReadProcessMemoryAreas(
+      _process_base.id(),
+      deref_addresses,
+      DEREF_SIZE);
+
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        const auto area = pointed_areas[i];
+
+        if (not area or types[i] != UNKNOWN)
+        {
+            continue;
+        }
+
+        types[i] = area->isFileBacked() ? MODULE_POINTER : HEAP_POINTER;
+
+        const auto deref_index = std::distance(
+          deref_addresses.begin(),
+          std::lower_bound(deref_addresses.begin(),
+                           deref_addresses.end(),
+                           values[i]));
+
+        if (not deref_valids[deref_index])
+        {
+            continue;
+        }
+
+        const auto deref = &derefs[deref_index * DEREF_SIZE];
+
+        std::uintptr_t first_entry;
+        std::memcpy(&first_entry, deref, sizeof(first_entry));
+
+        const auto first_entry_area = search(first_entry);
+
+        if (area->isFileBacked() and first_entry_area
+            and first_entry_area->isFileBacked()
+            and (first_entry_area->protectionFlags().cachedValue()
+                 & MemoryArea::ProtectionFlags::X))
+        {
+            types[i] = VTABLE;
+            continue;
+        }
+
+        std::size_t printable_chars = 0;
+
+        while (printable_chars < DEREF_SIZE
+               and std::isprint(deref[printable_chars]))
+        {
+            printable_chars++;
+        }
+
+        if (printable_chars >= MIN_STRING_SIZE
+            and (printable_chars == DEREF_SIZE
+                 or deref[printable_chars] == '\0'))
+        {
+            types[i] = STRING_POINTER;
+        }
+    }
+}
+
+auto StructDissector::dissect(const std::vector<std::uintptr_t>& instances,
+                              const std::size_t structSize) -> slots_t
+{
+    slots_t slots;
+
+    if (instances.empty() or structSize == 0)
+    {
+        return slots;
+    }
+
+    const auto [data, valids] = MemoryUtils::ReadProcessMemoryAreas(
+      _process_base.id(),
+      instances,
+      structSize);
+
+    std::vector<std::uintptr_t> pointers_column(instances.size());
+    std::vector<std::uint32_t> values_column(instances.size());
+    std::vector<SlotType> types(instances.size());
+
+    const auto gather_column = [&](auto& column, const std::size_t offset)
+    {
+        for (std::size_t i = 0; i < column.size(); i++)
+        {
+            std::memcpy(&column[i],
+                        &data[i * structSize + offset],
+                        sizeof(column[i]));
+        }
+    };
+
+    std::size_t offset = 0;
+
+    while (offset < structSize)
+    {
+        if ((offset % sizeof(std::uintptr_t)) == 0
+            and offset + sizeof(std::uintptr_t) <= structSize)
+        {
+            gather_column(pointers_column, offset);
+            classifyPointers(pointers_column, valids, types);
+
+            const auto slot = MakeSlot(offset,
+                                       sizeof(std::uintptr_t),
+                                       types,
+                                       valids);
+
+            if (slot.type >= HEAP_POINTER)
+            {
+                slots.push_back(slot);
+                offset += sizeof(std::uintptr_t);
+                continue;
+            }
+        }
+
+        if (offset + sizeof(std::uint32_t) <= structSize)
+        {
+            gather_column(values_column, offset);
+            Classify32bits(values_column, types);
+
+            slots.push_back(
+              MakeSlot(offset, sizeof(std::uint32_t), types, valids));
+            offset += sizeof(std::uint32_t);
+            continue;
+        }
+
+        /* Trailing bytes that can't form a slot */
+        slots.push_back(
+          { offset, structSize - offset, UNKNOWN, 0.f, {} });
+        break;
+    }
+
+    return slots;
+}
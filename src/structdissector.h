@@ -0,0 +1,81 @@
+#ifndef ASURA_STRUCTDISSECTOR_H
+#define ASURA_STRUCTDISSECTOR_H
+
+#include "process.h"
+
+namespace Asura
+{
+    /**
+     * Infers the layout of a structure from many live instances of it.
+     * All instances are gathered with one batched read, then every slot
+     * is classified column by column (same offset across all instances)
+     * with branchless loops. The 32 bits one gets vectorized by the
+     * compiler (-O3), the pointers one stays scalar: narrowing 64 bits
+     * compares to byte types doesn't vectorize without AVX512, it's a
+     * few compares per value anyway, the area lookups cost the most.
+     * The final type of a slot is the one that got the most votes, the
+     * confidence being the ratio of instances agreeing with it.
+     */
+    class StructDissector
+    {
+      public:
+        enum SlotType : byte_t
+        {
+            UNKNOWN,
+            ZERO,
+            SMALL_INT,
+            FLOAT,
+            HEAP_POINTER,
+            MODULE_POINTER,
+            STRING_POINTER,
+            VTABLE,
+            MAX_SLOT_TYPES
+        };
+
+        struct Slot
+        {
+            std::size_t offset;
+            std::size_t size;
+            SlotType type;
+            float confidence;
+            std::array<std::uint32_t, MAX_SLOT_TYPES> votes;
+        };
+
+        using slots_t = std::vector<Slot>;
+
+        /* Bytes read behind each pointer to spot strings and vtables */
+        static constexpr std::size_t DEREF_SIZE      = 16;
+        static constexpr std::size_t MIN_STRING_SIZE = 4;
+        static constexpr std::int64_t SMALL_INT_MAX  = 0x10000;
+
+      public:
+        static auto SlotTypeStr(const SlotType slotType) -> std::string;
+
+      public:
+        explicit StructDissector(const Process& process);
+
+      public:
+        auto mmap() const -> const ProcessMemoryMap&;
+        /* nullptr when it's in no area or one denied by the OS */
+        auto search(const std::uintptr_t address) const
+          -> const ProcessMemoryArea*;
+
+      public:
+        auto refresh(const ProcessMemoryMap& mmap) -> void;
+        auto dissect(const std::vector<std::uintptr_t>& instances,
+                     const std::size_t structSize) -> slots_t;
+
+      private:
+        auto classifyPointers(const std::vector<std::uintptr_t>& values,
+                              const std::vector<bool>& valids,
+                              std::vector<SlotType>& types) const -> void;
+
+      private:
+        ProcessBase _process_base;
+        ProcessMemoryMap _mmap;
+        std::uintptr_t _lowest_address {};
+        std::uintptr_t _highest_address {};
+    };
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include "pch.h"
+
+#include "elfview.h"
+#include "exception.h"
+#include "mappedfile.h"
+#include "peimage.h"
+#include "symbolindex.h"
+
+using namespace Asura;
+
+#ifndef WINDOWS
+template <ELF::IntType T>
+static auto AddELFSymbols(const MappedFile& file,
+                          const std::uintptr_t baseAddress,
+                          const std::size_t module,
+                          std::vector<SymbolIndex::Symbol>& symbols) -> void
+{
+    const ELFView view(file);
+
+    const auto header          = view.at<ELF::Elf_Ehdr<T>>(0);
+    const auto section_headers = view.at<ELF::Elf_Shdr<T>>(
+      header->e_shoff,
+      header->e_shnum);
+    const auto first_address = view.firstLoadAddress<T>();
+
+    if (not first_address)
+    {
+        return;
+    }
+
+    const auto load_bias = ELFView::LoadBias(baseAddress, *first_address);
+
+    for (std::uint16_t i = 0; i < header->e_shnum; i++)
+    {
+        const auto& section_header = section_headers[i];
+
+        if ((section_header.sh_type != ELF::SHT_SYMTAB
+             and section_header.sh_type != ELF::SHT_DYNSYM)
+            or section_header.sh_link >= header->e_shnum)
+        {
+            continue;
+        }
+
+        const auto& strings_header = section_headers[section_header
+                                                       .sh_link];
+        const auto strings = view.at<char>(strings_header.sh_offset,
+                                           strings_header.sh_size);
+
+        const auto symbols_count = section_header.sh_size
+                                   / sizeof(ELF::Elf_Sym<T>);
+        const auto elf_symbols = view.at<ELF::Elf_Sym<T>>(
+          section_header.sh_offset,
+          symbols_count);
+
+        for (std::size_t j = 0; j < symbols_count; j++)
+        {
+            const auto& symbol = elf_symbols[j];
+            const auto type    = symbol.st_info & 0xF;
+
+            /* Imports have no value and no section */
+            if ((type != ELF::STT_FUNC and type != ELF::STT_GNU_IFUNC)
+                or symbol.st_value == 0 or symbol.st_shndx == 0
+                or symbol.st_name >= strings_header.sh_size)
+            {
+                continue;
+            }
+
+            symbols.push_back(
+              { load_bias + view_as<std::uintptr_t>(symbol.st_value),
+                view_as<std::size_t>(symbol.st_size),
+                std::string(&strings[symbol.st_name],
+                            strnlen(&strings[symbol.st_name],
+                                    strings_header.sh_size
+                                      - symbol.st_name)),
+                module });
+        }
+    }
+}
+
+static auto AddModuleSymbols(const ProcessMemoryMap::ModuleAreas& areas,
+                             const std::uintptr_t baseAddress,
+                             const std::size_t module,
+                             std::vector<SymbolIndex::Symbol>& symbols)
+  -> void
+{
+    const MappedFile file(areas.path, areas.device, areas.inode);
+
+    if (file.size() < sizeof(ELF::Elf_Parent_Ehdr))
+    {
+        return;
+    }
+
+    const auto header = view_as<const ELF::Elf_Parent_Ehdr*>(file.data());
+
+    std::uint32_t elf_magic;
+    std::memcpy(&elf_magic, header->e_ident, sizeof(elf_magic));
+
+    std::uint16_t pe_magic;
+    std::memcpy(&pe_magic, file.data(), sizeof(pe_magic));
+
+    if (elf_magic == ELF::MAGIC_NUMBER)
+    {
+        switch (header->e_ident[ELF::EI_CLASS])
+        {
+            case ELF::ELFCLASS32:
+                return AddELFSymbols<std::uint32_t>(file,
+                                                    baseAddress,
+                                                    module,
+                                                    symbols);
+            case ELF::ELFCLASS64:
+                return AddELFSymbols<std::uint64_t>(file,
+                                                    baseAddress,
+                                                    module,
+                                                    symbols);
+            default:
+                ASURA_EXCEPTION("Unknown ELF class");
+        }
+    }
+    /* Wine maps the headers at the base, like Windows */
+    else if (pe_magic == PE::MAGIC_NUMBER)
+    {
+        const PEImage image(areas.path);
+
+        for (auto&& pe_export : image.exports())
+        {
+            symbols.push_back({ baseAddress + pe_export.rva,
+                                0,
+                                pe_export.name.empty() ?
+                                  "#" + std::to_string(pe_export.ordinal) :
+                                  std::move(pe_export.name),
+                                module });
+        }
+    }
+}
+
+SymbolIndex::SymbolIndex(const Process& process)
+{
+    const auto& module_areas = process.mmap().moduleAreas();
+
+    for (const auto& module : process.modules())
+    {
+        const auto areas = std::find_if(
+          module_areas.begin(),
+          module_areas.end(),
+          [&](const ProcessMemoryMap::ModuleAreas& moduleAreas)
+          {
+              return moduleAreas.path == module.path();
+          });
+
+        if (areas == module_areas.end() or areas->areas.empty())
+        {
+            continue;
+        }
+
+        const auto index = _modules.size();
+        _modules.push_back(module);
+
+        auto begin = std::numeric_limits<std::uintptr_t>::max();
+        std::uintptr_t end {};
+
+        for (const auto& area : areas->areas)
+        {
+            begin = std::min(begin, area->begin());
+            end   = std::max(end, area->end());
+        }
+
+        _ranges.push_back({ begin, end, index });
+
+        try
+        {
+            AddModuleSymbols(*areas,
+                             view_as<std::uintptr_t>(module.baseAddress()),
+                             index,
+                             _symbols);
+        }
+        catch (Exception&)
+        {
+        }
+    }
+
+    std::sort(_ranges.begin(),
+              _ranges.end(),
+              [](const ModuleRange& left, const ModuleRange& right)
+              {
+                  return left.begin < right.begin;
+              });
+
+    /**
+     * .symtab and .dynsym share most of their functions, aliases only
+     * keep the first name, the one with a size if any.
+     */
+    std::sort(_symbols.begin(),
+              _symbols.end(),
+              [](const Symbol& left, const Symbol& right)
+              {
+                  return std::tie(left.address, right.size)
+                         < std::tie(right.address, left.size);
+              });
+
+    _symbols.erase(std::unique(_symbols.begin(),
+                               _symbols.end(),
+                               [](const Symbol& left, const Symbol& right)
+                               {
+                                   return left.address == right.address;
+                               }),
+                   _symbols.end());
+}
+
+auto SymbolIndex::resolve(const std::uintptr_t address) const -> Location
+{
+    const auto range = std::upper_bound(
+      _ranges.begin(),
+      _ranges.end(),
+      address,
+      [](const std::uintptr_t value, const ModuleRange& moduleRange)
+      {
+          return value < moduleRange.begin;
+      });
+
+    if (range == _ranges.begin() or address >= std::prev(range)->end)
+    {
+        return {};
+    }
+
+    const auto module_index = std::prev(range)->module;
+    const auto& module      = _modules[module_index];
+
+    const auto symbol = std::upper_bound(
+      _symbols.begin(),
+      _symbols.end(),
+      address,
+      [](const std::uintptr_t value, const Symbol& symbol)
+      {
+          return value < symbol.address;
+      });
+
+    if (symbol != _symbols.begin())
+    {
+        const auto& found = *std::prev(symbol);
+
+        if (found.module == module_index
+            and (found.size == 0 or address - found.address < found.size))
+        {
+            return { &module, &found, address - found.address };
+        }
+    }
+
+    return { &module,
+             nullptr,
+             address - view_as<std::uintptr_t>(module.baseAddress()) };
+}
+
+auto SymbolIndex::modules() const -> const std::vector<Process::Module>&
+{
+    return _modules;
+}
+
+auto SymbolIndex::symbols() const -> const std::vector<Symbol>&
+{
+    return _symbols;
+}
+#endif
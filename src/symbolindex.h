@@ -0,0 +1,73 @@
+#ifndef ASURA_SYMBOLINDEX_H
+#define ASURA_SYMBOLINDEX_H
+
+#include "process.h"
+
+#ifndef WINDOWS
+namespace Asura
+{
+    /**
+     * Turns addresses of a process into a module and a function:
+     *
+     * SymbolIndex index(process);
+     * const auto location = index.resolve(address);
+     * if (location.symbol)
+     *     location.symbol->name + "+" + location.offset
+     *
+     * ELF modules give the functions of their .symtab and .dynsym, PE
+     * modules (Wine) their exports. Everything is sorted by address
+     * once, a lookup is two binary searches.
+     * Functions without a size, like the exports, run up to the next
+     * one of the same module.
+     */
+    class SymbolIndex
+    {
+      public:
+        struct Symbol
+        {
+            std::uintptr_t address;
+            /* 0 when unknown */
+            std::size_t size;
+            std::string name;
+            /* Index in modules() */
+            std::size_t module;
+        };
+
+        struct Location
+        {
+            /* Null when the address isn't in a module */
+            const Process::Module* module {};
+            /* Null when it's in no known function */
+            const Symbol* symbol {};
+            /* From the symbol, or from the module base */
+            std::uintptr_t offset {};
+        };
+
+      public:
+        /* Modules that can't be parsed only resolve to the module */
+        explicit SymbolIndex(const Process& process);
+
+      public:
+        auto resolve(const std::uintptr_t address) const -> Location;
+        auto modules() const -> const std::vector<Process::Module>&;
+        auto symbols() const -> const std::vector<Symbol>&;
+
+      private:
+        struct ModuleRange
+        {
+            std::uintptr_t begin;
+            std::uintptr_t end;
+            std::size_t module;
+        };
+
+      private:
+        std::vector<Process::Module> _modules;
+        /* Sorted by begin */
+        std::vector<ModuleRange> _ranges;
+        /* Sorted by address */
+        std::vector<Symbol> _symbols;
+    };
+}
+#endif
+
+#endif
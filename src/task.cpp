@@ -42,9 +42,11 @@ auto Task::list(ProcessBase processBase) -> tasks_t
     std::filesystem::path filepath_tasks(
       "/proc/" + std::to_string(processBase.id()) + "/task/");
 
-    for (const auto& task_id_path : filepath_tasks)
+    /* One directory per thread, the main one included */
+    for (const auto& task_id_path :
+         std::filesystem::directory_iterator(filepath_tasks))
     {
-        const auto task_id = task_id_path.generic_string();
+        const auto task_id = task_id_path.path().filename().string();
 
         const Task task(processBase, std::stoi(task_id));
 
@@ -70,11 +72,6 @@ auto Task::list(ProcessBase processBase) -> tasks_t
 
         tasks.push_back(task);
     }
-
-    /**
-     * The base process is also a task
-     */
-    tasks.push_back(Task(processBase, processBase.id()));
 #endif
 
     return tasks;
@@ -24,6 +24,27 @@ auto rogue() -> void
     std::cout << "Hehe" << std::endl;
 }
 
+static Instrumentation::Probe rogue_probe("rogue");
+
+auto counted(int value) -> int
+{
+    return value + 1;
+}
+
+static Instrumentation::Probe counted_probe("counted");
+
+static auto Check(const bool passed, const std::string& name) -> void
+{
+    if (passed)
+    {
+        ConsoleOutput("Passed ") << name << std::endl;
+        return;
+    }
+
+    ConsoleOutput("Didn't pass ") << name << " test" << std::endl;
+    g_PassedTests = false;
+}
+
 auto Asura::Test::run() -> void
 {
     ConsoleOutput("Starting test") << std::endl;
@@ -99,15 +120,6 @@ auto Asura::Test::run() -> void
         g_PassedTests = false;
     }
 
-    if (g_PassedTests)
-    {
-        ConsoleOutput("Passed all tests") << std::endl;
-    }
-    else
-    {
-        ConsoleOutput("Failed test(s)") << std::endl;
-    }
-
     using VAPI_t = VirtualTable<Test::API>;
 
     VAPI_t* api   = view_as<VAPI_t*>(&g_API);
@@ -163,7 +175,9 @@ auto Asura::Test::run() -> void
     {
         std::cout << std::hex << "[ " << area->begin() << " - "
                   << area->end() << " ]"
-                  << " -> " << area->name() << std::endl;
+                  << " -> " << area->name() << " ("
+                  << ProcessMemoryArea::CategoryStr(area->category())
+                  << ")" << std::endl;
     }
 
     try
@@ -430,7 +444,10 @@ auto Asura::Test::run() -> void
     {
         auto encoded = XKC<byte_t>::encode(random_bytes);
 
-        ConsoleOutput("size of encoded: ") << encoded.size() << std::endl;
+        ConsoleOutput("size of encoded: ")
+          << encoded.size() << " (tree: "
+          << XKC<byte_t>::encode(random_bytes, XKC<byte_t>::TREE).size()
+          << ")" << std::endl;
 
         auto decoded = XKC<byte_t>::decode(encoded);
 
@@ -442,6 +459,84 @@ auto Asura::Test::run() -> void
           << std::endl;
     }
 
+    try
+    {
+        constexpr std::size_t window_size = 0x10000;
+
+        const std::vector<PatternByte::Value> pattern_bytes {
+            'X', 'K', 'C', PatternByte::Value::UNKNOWN, 'w', 'i', 'n',
+            'd', 'o', 'w', 's', ' ', 'e', 'd', 'g', 'e'
+        };
+
+        std::mt19937 random_generator(1337);
+        bytes_t plain(window_size * 4 + 123);
+
+        for (auto&& byte : plain)
+        {
+            byte = view_as<byte_t>(random_generator() % 4);
+        }
+
+        /**
+         * Each decoded window starts with the last bytes of the
+         * previous one, same overlap as searchInXKC
+         */
+        const auto overlap = MemoryUtils::AlignToPageSize(
+          pattern_bytes.size() - 1 + sizeof(SIMD::value_t),
+          sizeof(SIMD::value_t));
+        const auto decoded_window = window_size - overlap;
+
+        const std::vector<std::size_t> offsets {
+            100,
+            decoded_window - 5,
+            decoded_window * 2 - 9,
+            decoded_window * 3,
+            plain.size() - pattern_bytes.size()
+        };
+
+        for (const auto offset : offsets)
+        {
+            for (std::size_t i = 0; i < pattern_bytes.size(); i++)
+            {
+                plain[offset + i] = view_as<byte_t>(
+                  pattern_bytes[i].value == PatternByte::Value::UNKNOWN ?
+                    '?' :
+                    pattern_bytes[i].value);
+            }
+        }
+
+        for (const auto backend : { XKC<byte_t>::HUFFMAN,
+                                    XKC<byte_t>::TREE })
+        {
+            auto encoded = XKC<byte_t>::encode(plain, backend);
+
+            PatternByte pattern(pattern_bytes);
+            PatternScanning::searchInXKC(pattern,
+                                         encoded.data(),
+                                         encoded.size(),
+                                         nullptr,
+                                         PatternScanning::searchV4,
+                                         window_size);
+
+            std::vector<std::size_t> found;
+
+            for (const auto match : pattern.matches())
+            {
+                found.push_back(view_as<std::size_t>(match));
+            }
+
+            std::sort(found.begin(), found.end());
+
+            Check(found == offsets,
+                  std::string("XKC search, ")
+                    + (backend == XKC<byte_t>::TREE ? "tree" : "huffman"));
+        }
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
     Timer timer {};
 
     auto aligned_memory = align_alloc<data_t>(size_of_random * 8,
@@ -751,6 +846,21 @@ auto Asura::Test::run() -> void
 
     std::cout << member.first()->ok << std::endl;
 
+    try
+    {
+        using First = RemoteField<0x0, TestMember::Something*>;
+        RemoteView<RemoteLayout<First>> member_view(Process::self(),
+                                                    &member);
+
+        member_view.fetch();
+
+        std::cout << member_view.get<First>()->ok << std::endl;
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+    }
+
     rogue();
 
     try
@@ -775,6 +885,1599 @@ auto Asura::Test::run() -> void
         std::cout << e.msg() << std::endl;
     }
 
+    try
+    {
+        struct DissectMe
+        {
+            Test::API* api;
+            const char* str;
+            float fl;
+            int integer;
+        };
+
+        std::vector<DissectMe> to_dissect(64);
+        std::vector<std::uintptr_t> instances;
+
+        for (std::size_t i = 0; i < to_dissect.size(); i++)
+        {
+            to_dissect[i] = { &g_API, "Life is a game", 42.42f, 1337 };
+            instances.push_back(
+              view_as<std::uintptr_t>(&to_dissect[i]));
+        }
+
+        StructDissector struct_dissector(Process::self());
+
+        for (const auto& slot :
+             struct_dissector.dissect(instances, sizeof(DissectMe)))
+        {
+            ConsoleOutput("slot at ")
+              << std::dec << slot.offset << ": "
+              << StructDissector::SlotTypeStr(slot.type) << " ("
+              << slot.confidence << ")" << std::endl;
+        }
+    }
+    catch (Exception& e)
+    {
+        std::cout << e.msg() << std::endl;
+    }
+
+    try
+    {
+        MockProcess mock_process("modules");
+
+        std::uintptr_t address = 0x400000;
+
+        for (const auto name : { "/usr/lib/libmock.so",
+                                 "/memfd:jit (deleted)",
+                                 "/usr/lib/libold.so (deleted)",
+                                 "/SYSV00000000 (deleted)",
+                                 "/dev/zero" })
+        {
+            mock_process.addArea(address,
+                                 0x1000,
+                                 MemoryArea::ProtectionFlags::READ,
+                                 name);
+            address += 0x1000;
+        }
+
+        const auto modules = mock_process.process().modules();
+
+        /* The process itself has no module that isn't a regular file */
+        const auto self_modules = Process::self().modules();
+
+        Check(modules.size() == 1
+                and modules.front().path() == "/usr/lib/libmock.so"
+                and not self_modules.empty()
+                and std::all_of(self_modules.begin(),
+                                self_modules.end(),
+                                [](const Process::Module& module)
+                                {
+                                    return std::filesystem::is_regular_file(
+                                      module.path());
+                                }),
+              "modules filter");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        MockProcess mock_process("mock");
+        mock_process.addArea(0x400000,
+                             0x2000,
+                             MemoryArea::ProtectionFlags::READ
+                               | MemoryArea::ProtectionFlags::WRITE,
+                             "/usr/bin/mock",
+                             { 0x48, 0x89, 0xE5, 0xC3 });
+
+        /* A new pattern for each search, matches add up otherwise */
+        const auto search = [](const Process& process)
+        {
+            PatternByte pattern({ 0x89, PatternByte::Value::UNKNOWN, 0xC3 });
+            PatternScanning::searchInProcess(pattern, process);
+            return pattern.matches();
+        };
+
+        const auto mock_matches = search(mock_process.process());
+
+        for (const auto& match : mock_matches)
+        {
+            ConsoleOutput("mock match at ") << match << std::endl;
+        }
+
+        MemoryTrace trace;
+        std::vector<ptr_t> recorded_matches;
+        Expected<ptr_t> bad_alloc = nullptr;
+        Expected<void> bad_free;
+
+        {
+            MemoryRecorder recorder(ProcessBase(mock_process.id()));
+            recorded_matches = search(recorder.process());
+            bad_alloc        = recorder.tryAlloc(
+              0,
+              0,
+              MemoryArea::ProtectionFlags::READ);
+            bad_free = recorder.tryFree(0x400000, 0);
+            trace    = recorder.trace();
+        }
+
+        /* Errors are recorded as they came, not as unknown ones */
+        const auto& alloc_event = trace.events[trace.events.size() - 2];
+        const auto& free_event  = trace.events.back();
+
+        MemoryReplayer replayer(MemoryTrace::Decode(trace.encode()));
+        const auto replayed_matches = search(replayer.process());
+
+        ConsoleOutput("replayed ")
+          << std::dec << replayer.matchedCount() << "/"
+          << trace.events.size() << " events" << std::endl;
+
+        /* Validity bits that don't match the addresses */
+        auto corrupted = trace;
+        corrupted.events.push_back(
+          { .type      = MemoryTrace::Event::READ_BATCH,
+            .size      = 8,
+            .addresses = { 0x400000, 0x400008 },
+            .valids    = { true } });
+
+        bool corrupted_rejected = false;
+
+        try
+        {
+            MemoryTrace::Decode(corrupted.encode());
+        }
+        catch (Exception&)
+        {
+            corrupted_rejected = true;
+        }
+
+        const std::uintptr_t expected_match = 0x400001;
+
+        Check(mock_matches.size() == 1
+                and mock_matches.front() == view_as<ptr_t>(expected_match)
+                and recorded_matches == mock_matches
+                and replayed_matches == mock_matches
+                and not bad_alloc
+                and bad_alloc.error() == ErrorCode::INVALID_ARGUMENT
+                and alloc_event.error == ErrorCode::INVALID_ARGUMENT
+                and not bad_free
+                and free_event.error == ErrorCode::INVALID_ARGUMENT
+                and corrupted_rejected,
+              "memory trace");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+#ifndef WINDOWS
+    try
+    {
+        const bytes_t needle { 0x41, 0x53, 0x55, 0x52, 0x41, 0x46, 0x4C, 0x54 };
+        const auto page_size = MemoryUtils::GetPageSize();
+
+        /* A file mapping shared with the child, and an anonymous page */
+        const auto path = std::filesystem::temp_directory_path()
+                          / ("asura_fleet_"
+                             + std::to_string(Process::self().id()));
+        bytes_t file_bytes(page_size);
+        std::copy(needle.begin(), needle.end(), file_bytes.begin() + 0x10);
+        std::ofstream(path, std::ios::binary)
+          .write(view_as<const char*>(file_bytes.data()),
+                 view_as<std::streamsize>(file_bytes.size()));
+
+        const auto fd        = open(path.c_str(), O_RDONLY);
+        const auto file_page = view_as<byte_t*>(
+          ::mmap(nullptr, page_size, PROT_READ, MAP_PRIVATE, fd, 0));
+        const auto anon_page = view_as<byte_t*>(
+          ::mmap(nullptr,
+                 page_size,
+                 PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS,
+                 -1,
+                 0));
+        close(fd);
+
+        std::copy(needle.begin(), needle.end(), anon_page + 0x10);
+
+        int ready[2];
+        pipe(ready);
+
+        const auto child = fork();
+
+        /**
+         * The child copies a page of the file mapping on write and
+         * moves the needle of its anonymous page.
+         */
+        if (child == 0)
+        {
+            ::mprotect(file_page, page_size, PROT_READ | PROT_WRITE);
+            std::copy(needle.begin(), needle.end(), file_page + 0x300);
+            ::mprotect(file_page, page_size, PROT_READ);
+
+            anon_page[0x10] = 0;
+            std::copy(needle.begin(), needle.end(), anon_page + 0x200);
+
+            write(ready[1], "", 1);
+
+            while (true)
+            {
+                pause();
+            }
+        }
+
+        char byte;
+        read(ready[0], &byte, 1);
+        close(ready[0]);
+        close(ready[1]);
+
+        const std::vector<Process> fleet { Process::self(),
+                                           Process(child) };
+
+        const auto parent_private = MemoryUtils::HasPrivatePages(
+          fleet[0].id(),
+          file_page,
+          page_size);
+        const auto child_private = MemoryUtils::HasPrivatePages(
+          fleet[1].id(),
+          file_page,
+          page_size);
+
+        PatternByte fleet_pattern(
+          std::vector<PatternByte::Value>(needle.begin(), needle.end()));
+
+        const auto fleet_matches = PatternScanning::searchInProcesses(
+          fleet_pattern,
+          fleet,
+          PatternScanning::searchV4,
+          true);
+
+        ::kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+        std::filesystem::remove(path);
+
+        /* Only the matches of the two pages, the needle is elsewhere too */
+        const auto offsets = [&](const std::vector<ptr_t>& matches)
+        {
+            std::vector<std::tuple<bool, std::size_t>> result;
+
+            for (const auto match : matches)
+            {
+                const auto address = view_as<byte_t*>(match);
+
+                if (address >= file_page and address < file_page + page_size)
+                {
+                    result.emplace_back(true, address - file_page);
+                }
+                else if (address >= anon_page
+                         and address < anon_page + page_size)
+                {
+                    result.emplace_back(false, address - anon_page);
+                }
+            }
+
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+
+        using Offsets = std::vector<std::tuple<bool, std::size_t>>;
+
+        Check(not parent_private and child_private
+                and offsets(fleet_matches[0])
+                      == Offsets { { false, 0x10 }, { true, 0x10 } }
+                and offsets(fleet_matches[1])
+                      == Offsets { { false, 0x200 },
+                                   { true, 0x10 },
+                                   { true, 0x300 } },
+              "fleet search");
+
+        ::munmap(file_page, page_size);
+        ::munmap(anon_page, page_size);
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+#endif
+
+    try
+    {
+        auto process = Process::self();
+        process.refreshModules();
+
+        for (const auto& report : ModuleIntegrity::CheckAll(process))
+        {
+            ConsoleOutput(report.module.name())
+              << ": " << std::dec << report.checked_size << " bytes, "
+              << report.diffs.size() << " modified ranges" << std::endl;
+        }
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+    }
+
+#ifndef WINDOWS
+    try
+    {
+        const auto self = Process::self();
+        const auto libm = std::find_if(
+          self.modules().begin(),
+          self.modules().end(),
+          [](const Process::Module& candidate)
+          {
+              return candidate.name().starts_with("libm.so");
+          });
+        if (libm == self.modules().end())
+        {
+            throw Exception("module integrity, libm isn't loaded");
+        }
+
+        /* A copy of libm gets its own inode, so the loader maps it again */
+        const auto module_path = std::filesystem::temp_directory_path()
+                                 / "asura_integrity_libm.so";
+        std::filesystem::copy_file(
+          libm->path(),
+          module_path,
+          std::filesystem::copy_options::overwrite_existing);
+
+        const auto handle = ::dlopen(module_path.c_str(),
+                                     RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr)
+        {
+            throw Exception("module integrity, can't load the copy");
+        }
+
+        const auto code = view_as<std::uint8_t*>(::dlsym(handle, "cos"));
+
+        auto process = Process::self();
+        const auto module = std::find_if(
+          process.modules().begin(),
+          process.modules().end(),
+          [&](const Process::Module& candidate)
+          {
+              return candidate.path() == module_path.string();
+          });
+        if (code == nullptr or module == process.modules().end())
+        {
+            throw Exception("module integrity, copy isn't listed");
+        }
+
+        const auto address = view_as<std::uintptr_t>(code);
+        const auto covers = [&](const ModuleIntegrity::Report& report)
+        {
+            return std::any_of(report.diffs.begin(),
+                               report.diffs.end(),
+                               [&](const ModuleIntegrity::Range& diff)
+                               {
+                                   return address >= diff.address
+                                          and address
+                                                < diff.address + diff.size;
+                               });
+        };
+
+        const auto clean = ModuleIntegrity::Check(process, *module);
+        Check(clean.checked_size > 0 and not covers(clean),
+              "module integrity, clean copy");
+
+        const auto page_size = static_cast<std::uintptr_t>(
+          ::sysconf(_SC_PAGESIZE));
+        const auto page = view_as<void*>(address & ~(page_size - 1));
+
+        if (::mprotect(page, page_size, PROT_READ | PROT_WRITE | PROT_EXEC)
+            != 0)
+        {
+            throw Exception("module integrity, can't unprotect the code");
+        }
+
+        *code ^= 0xFF;
+        const auto corrupted = ModuleIntegrity::Check(process, *module);
+        *code ^= 0xFF;
+        ::mprotect(page, page_size, PROT_READ | PROT_EXEC);
+
+        Check(covers(corrupted), "module integrity, corrupted byte");
+
+        ::dlclose(handle);
+        std::filesystem::remove(module_path);
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+#endif
+
+    try
+    {
+        volatile int watched_value = 1;
+
+        ValueWatcher watcher(ProcessBase::self());
+        watcher.add(view_as<std::uintptr_t>(&watched_value),
+                    sizeof(watched_value));
+        watcher.tick();
+
+        watched_value = 2;
+        watcher.tick();
+
+        while (const auto change = watcher.poll())
+        {
+            int value;
+            std::memcpy(&value, change->value.data(), sizeof(value));
+
+            ConsoleOutput("watch ")
+              << std::dec << change->watch << " changed to " << value
+              << std::endl;
+        }
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+    }
+
+    try
+    {
+        const auto decrypted = ASURA_OBFUSCATED_STRING("Hello, obfuscated")
+                                 .decrypt();
+        const auto& cached = ASURA_OBFUSCATED_STRING("Hello, cached")
+                               .cached();
+
+        /* Built at run time, so the whole literals aren't in the binary */
+        const auto hello = std::string("Hello, ");
+
+        Check(decrypted.view() == hello + "obfuscated"
+                and std::strlen(decrypted.c_str()) == decrypted.view().size()
+                and cached == hello + "cached",
+              "obfuscated string, decrypt");
+
+#ifndef WINDOWS
+        std::ifstream executable("/proc/self/exe", std::ios::binary);
+        const bytes_t file { std::istreambuf_iterator<char>(executable),
+                             std::istreambuf_iterator<char>() };
+
+        const auto header = view_as<const ELF::Elf_Ehdr<std::uint64_t>*>(
+          file.data());
+        const auto sections = view_as<const ELF::Elf_Shdr<std::uint64_t>*>(
+          file.data() + header->e_shoff);
+        const auto names = view_as<const char*>(
+          file.data() + sections[header->e_shstrndx].sh_offset);
+
+        bool found_rodata = false;
+        bool leaked       = false;
+
+        for (std::uint16_t i = 0; i < header->e_shnum; i++)
+        {
+            if (std::string_view(names + sections[i].sh_name) != ".rodata")
+            {
+                continue;
+            }
+
+            const auto begin = file.begin()
+                               + view_as<std::ptrdiff_t>(
+                                 sections[i].sh_offset);
+            const auto end = begin
+                             + view_as<std::ptrdiff_t>(sections[i].sh_size);
+
+            for (const std::string_view plain : { decrypted.view(),
+                                                  std::string_view(cached) })
+            {
+                leaked = leaked
+                         or std::search(begin,
+                                        end,
+                                        plain.begin(),
+                                        plain.end())
+                              != end;
+            }
+
+            /* The plain prefix is there, the search does work */
+            found_rodata = std::search(begin, end, hello.begin(), hello.end())
+                           != end;
+        }
+
+        Check(found_rodata and not leaked, "obfuscated string, not in rodata");
+#endif
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        PacketAuthenticator::key_t key;
+
+        for (std::size_t i = 0; i < key.size(); i++)
+        {
+            key[i] = view_as<byte_t>(i);
+        }
+
+        /* Reference vectors, message 00 01 02... of the given size */
+        constexpr std::array<std::pair<std::size_t, std::uint64_t>, 4>
+          vectors { { { 0, 0x726FDB47DD0E0E31 },
+                      { 1, 0x74F839C593DC67FD },
+                      { 8, 0x93F5F5799A932462 },
+                      { 15, 0xA129CA6149BE45E5 } } };
+
+        std::array<byte_t, 15> message;
+
+        for (std::size_t i = 0; i < message.size(); i++)
+        {
+            message[i] = view_as<byte_t>(i);
+        }
+
+        for (const auto& [size, expected] : vectors)
+        {
+            Check(PacketAuthenticator::SipHash(key, message.data(), size)
+                    == expected,
+                  "siphash-2-4, " + std::to_string(size) + " bytes");
+        }
+
+        PacketAuthenticator sender(key), receiver(key);
+
+        std::array<byte_t, UDPSize> packet_data {};
+        NetworkWriteBuffer packet(packet_data.data(), packet_data.size());
+        packet.writeVar<type_32us>(1337);
+        sender.sign(packet);
+
+        const auto packet_size = packet.writtenBits() / CHAR_BIT;
+
+        NetworkReadBuffer received(packet_data.data(), packet_size);
+        const auto first = receiver.verify(received);
+
+        NetworkReadBuffer replayed(packet_data.data(), packet_size);
+        const auto second = receiver.verify(replayed);
+
+        Check(first == PacketAuthenticator::Status::valid
+                and received.readVar<type_32us>() == 1337
+                and second == PacketAuthenticator::Status::replayed,
+              "authenticated packet");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        using Opcode = VirtualMachine::Opcode;
+
+        constexpr std::uint64_t iterations = 10000000;
+        constexpr std::uint64_t seed       = 88172645463325252;
+        constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15;
+
+        /* r0 iterations, r1 xorshift state, r2 counter, r3 sum */
+        VirtualMachine::Assembler assembler;
+        const auto loop = assembler.newLabel();
+        const auto end  = assembler.newLabel();
+
+        assembler.movi(2, 0);
+        assembler.movi(3, 0);
+        assembler.movi(5, multiplier);
+        assembler.jump(Opcode::jge, 2, 0, end);
+        assembler.bind(loop);
+        assembler.alui(Opcode::shli, 4, 1, 13);
+        assembler.alu(Opcode::bit_xor, 1, 1, 4);
+        assembler.alui(Opcode::shri, 4, 1, 7);
+        assembler.alu(Opcode::bit_xor, 1, 1, 4);
+        assembler.alui(Opcode::shli, 4, 1, 17);
+        assembler.alu(Opcode::bit_xor, 1, 1, 4);
+        assembler.alu(Opcode::mul, 4, 1, 5);
+        assembler.alu(Opcode::add, 3, 3, 4);
+        assembler.alui(Opcode::addi, 2, 2, 1);
+        assembler.jump(Opcode::jlt, 2, 0, loop);
+        assembler.bind(end);
+        assembler.ret(3);
+
+        std::array<byte_t, 0x1000> bytecode;
+        WriteBuffer write_buffer(bytecode.data(), bytecode.size());
+        assembler.write(write_buffer);
+
+        ReadBuffer read_buffer(bytecode.data(), write_buffer.writeSize());
+        VirtualMachine vm(read_buffer);
+
+        VirtualMachine::registers_t registers { iterations, seed };
+
+        Timer bench_timer {};
+        bench_timer.start();
+        const auto vm_result = vm.run(registers);
+        bench_timer.end();
+
+        const auto vm_time = bench_timer.difference();
+
+        bench_timer.start();
+
+        std::uint64_t state = seed, native_result = 0;
+
+        for (std::uint64_t i = 0; i < iterations; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            native_result += state * multiplier;
+
+            /* Keep it a loop like the VM one, not vectorized */
+            asm("" : "+r"(native_result));
+        }
+
+        bench_timer.end();
+
+        ConsoleOutput("vm: ")
+          << std::dec << vm_time << " nanoseconds, native: "
+          << bench_timer.difference() << " nanoseconds, "
+          << vm.superinstructionsCount() << " superinstructions, "
+          << (vm_result == native_result ? "same" : "different")
+          << " result" << std::endl;
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+    }
+
+#ifndef WINDOWS
+    try
+    {
+        /**
+         * A small PE32+ DLL, built here: .text at 0x1000 is as big as a
+         * page so it's mapped from the file, .rdata at 0x2000 holds the
+         * exports. The image base is above 4 GiB, the RVAs stay 32 bits.
+         */
+        constexpr std::uint64_t image_base = 0x180000000;
+        constexpr std::uint32_t text_rva   = 0x1000;
+        constexpr std::uint32_t rdata_rva  = 0x2000;
+        constexpr std::uint32_t rdata_raw  = 0x2000;
+
+        bytes_t file(0x2200);
+
+        const auto at = [&]<typename S>(const std::size_t offset)
+        {
+            return view_as<S*>(file.data() + offset);
+        };
+
+        const auto dos_header = at.operator()<PE::IMAGE::DOS_HEADER>(0);
+        dos_header->e_magic   = PE::MAGIC_NUMBER;
+        dos_header->e_lfanew  = 0x40;
+
+        const auto nt_headers = at.operator()<
+          PE::IMAGE::NT_HEADERS<std::uint64_t>>(0x40);
+        nt_headers->Signature = PE::IMAGE::NT_SIGNATURE;
+
+        auto& file_header                = nt_headers->FileHeader;
+        file_header.Machine              = PE::IMAGE::FILE_MACHINE_AMD64;
+        file_header.NumberOfSections     = 2;
+        file_header.SizeOfOptionalHeader = sizeof(
+          PE::IMAGE::OPTIONAL_HEADER<std::uint64_t>);
+
+        auto& optional_header               = nt_headers->OptionalHeader;
+        optional_header.Magic               = PE::IMAGE::
+          NT_OPTIONAL_HDR64_MAGIC;
+        optional_header.ImageBase           = image_base;
+        optional_header.SectionAlignment    = 0x1000;
+        optional_header.FileAlignment       = 0x200;
+        optional_header.SizeOfImage         = 0x3000;
+        optional_header.SizeOfHeaders       = 0x200;
+        optional_header.NumberOfrvaAndSizes = PE::IMAGE::
+          NUMBEROF_DIRECTORY_ENTRIES;
+        optional_header.DataDirectory[PE::IMAGE::DIRECTORY_ENTRY_EXPORT] = {
+            rdata_rva,
+            0x100
+        };
+
+        const auto sections = nt_headers->first_section();
+        std::memcpy(sections[0].Name, ".text", 5);
+        sections[0].Misc.VirtualSize = 0x1000;
+        sections[0].VirtualAddress   = text_rva;
+        sections[0].SizeOfRawData    = 0x1000;
+        sections[0].PointerToRawData = text_rva;
+        sections[0].Characteristics  = PE::IMAGE::SCN_MEM_EXECUTE;
+        std::memcpy(sections[1].Name, ".rdata", 6);
+        sections[1].Misc.VirtualSize = 0x200;
+        sections[1].VirtualAddress   = rdata_rva;
+        sections[1].SizeOfRawData    = 0x200;
+        sections[1].PointerToRawData = rdata_raw;
+
+        /* mov rax, [rip + 0x11223344] in Func */
+        const std::array<byte_t, 7> mov_rax { 0x48, 0x8B, 0x05, 0x44,
+                                              0x33, 0x22, 0x11 };
+        std::copy(mov_rax.begin(), mov_rax.end(), &file[0x1010]);
+
+        /**
+         * Func and FuncEx by name, a third one by ordinal only. Names
+         * are sorted, FuncEx shares Func's prefix.
+         */
+        const auto directory = at.operator()<PE::IMAGE::EXPORT_DIRECTORY>(
+          rdata_raw);
+        directory->Base                  = 1;
+        directory->NumberOfFunctions     = 3;
+        directory->NumberOfNames         = 2;
+        directory->AddressOfFunctions    = rdata_rva + 0x40;
+        directory->AddressOfNames        = rdata_rva + 0x50;
+        directory->AddressOfNameOrdinals = rdata_rva + 0x60;
+
+        const auto funcs = at.operator()<std::uint32_t>(rdata_raw + 0x40);
+        funcs[0]         = text_rva + 0x10;
+        funcs[1]         = text_rva + 0x20;
+        funcs[2]         = text_rva + 0x30;
+
+        const auto names = at.operator()<std::uint32_t>(rdata_raw + 0x50);
+        names[0]         = rdata_rva + 0x80;
+        names[1]         = rdata_rva + 0x90;
+
+        const auto ordinals = at.operator()<std::uint16_t>(rdata_raw
+                                                           + 0x60);
+        ordinals[0]         = 0;
+        ordinals[1]         = 1;
+
+        std::memcpy(&file[rdata_raw + 0x80], "Func", 5);
+        std::memcpy(&file[rdata_raw + 0x90], "FuncEx", 7);
+
+        const auto dll_path = std::filesystem::temp_directory_path()
+                              / "asura_test.dll";
+        std::ofstream(dll_path, std::ios::binary)
+          .write(view_as<const char*>(file.data()),
+                 view_as<std::streamsize>(file.size()));
+
+        PEImage pe_image(dll_path.string());
+        std::filesystem::remove(dll_path);
+
+        Check(pe_image.is64Bits()
+                and pe_image.machine() == PE::IMAGE::FILE_MACHINE_AMD64
+                and pe_image.imageBase() == image_base
+                and pe_image.imageSize() == 0x3000,
+              "pe image, PE32+ optional header");
+
+        const auto text = pe_image.findSection(".text");
+        Check(text != nullptr and text->rva == text_rva
+                and text->zero_copy
+                and pe_image.zeroCopySize() == 0x1000,
+              "pe image, sections");
+
+        Check(pe_image.findExport("Func") == image_base + text_rva + 0x10
+                and pe_image.findExport("FuncEx")
+                      == image_base + text_rva + 0x20
+                and pe_image.findExport("3") == image_base + text_rva + 0x30,
+              "pe image, exports above 4 GiB");
+
+        Check(pe_image.findExport("Fun") == 0
+                and pe_image.findExport("FuncE") == 0
+                and pe_image.findExport("FuncExA") == 0,
+              "pe image, exact export names");
+
+        const auto exports = pe_image.exports();
+        Check(exports.size() == 3 and exports[0].name == "Func"
+                and exports[1].name == "FuncEx" and exports[2].name.empty()
+                and exports[2].ordinal == 3,
+              "pe image, exports list");
+
+        /* mov rax, [rip + 0x11??????], can't end with an unknown byte */
+        PatternByte pe_pattern({ 0x48,
+                                 0x8B,
+                                 0x05,
+                                 PatternByte::Value::UNKNOWN,
+                                 PatternByte::Value::UNKNOWN,
+                                 PatternByte::Value::UNKNOWN,
+                                 0x11 });
+
+        PatternScanning::searchInPEImage(pe_pattern,
+                                         pe_image,
+                                         PatternScanning::searchV4,
+                                         ".text");
+
+        Check(pe_pattern.matches().size() == 1
+                and view_as<std::uintptr_t>(pe_pattern.matches()[0])
+                      == image_base + text_rva + 0x10,
+              "pe image, search in .text");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+#endif
+
+#ifndef WINDOWS
+    try
+    {
+        std::atomic<bool> profiled_running { true };
+
+        /* Something to sample */
+        std::thread profiled_thread(
+          [&]()
+          {
+              volatile double value = 1.0;
+
+              while (profiled_running)
+              {
+                  value = std::sqrt(value + 1.0);
+              }
+          });
+
+        Profiler profiler(ProcessBase::self());
+        profiler.start();
+
+        for (int i = 0; i < 10; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            profiler.collect();
+        }
+
+        profiler.stop();
+        profiled_running = false;
+        profiled_thread.join();
+
+        const auto report = profiler.report(SymbolIndex(Process::self()));
+
+        ConsoleOutput("profiler: ")
+          << std::dec << profiler.threadsCount() << " threads, "
+          << report.samples << " samples, " << report.lost << " lost"
+          << std::endl;
+
+        for (std::size_t i = 0; i < std::min<std::size_t>(
+                                  5,
+                                  report.entries.size());
+             i++)
+        {
+            const auto& entry = report.entries[i];
+
+            ConsoleOutput(entry.module)
+              << "!" << (entry.symbol.empty() ? "?" : entry.symbol) << ": "
+              << std::dec << entry.samples << std::endl;
+        }
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+    }
+#endif
+
+    try
+    {
+        rogue_probe.setOriginal(view_as<ptr_t>(&rogue));
+        rogue_probe.reset();
+
+        for (int i = 0; i < 3; i++)
+        {
+            Instrumentation::Hook<rogue_probe, void>();
+        }
+
+        Check(rogue_probe.read().calls == 3, "instrumentation, hook");
+
+        const auto timestamps_per_second = Instrumentation::
+          TimestampsPerSecond();
+
+        for (auto&& stats : Instrumentation::Read())
+        {
+            ConsoleOutput(stats.name)
+              << ": " << stats.calls << " calls, "
+              << stats.cycles * 1'000'000'000
+                   / timestamps_per_second / std::max<std::uint64_t>(
+                     stats.calls,
+                     1)
+              << " ns per call, " << stats.threads << " threads"
+              << std::endl;
+        }
+
+        /* An exited thread gives its slot to the next one */
+        std::size_t first_slot {}, second_slot {};
+
+        std::thread(
+          [&]()
+          {
+              first_slot = Instrumentation::ThreadSlot();
+          })
+          .join();
+        std::thread(
+          [&]()
+          {
+              second_slot = Instrumentation::ThreadSlot();
+          })
+          .join();
+
+        Check(first_slot == second_slot
+                and first_slot != Instrumentation::ThreadSlot(),
+              "instrumentation, thread slot reuse");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+#if not defined(WINDOWS) and defined(__x86_64__)
+    try
+    {
+        /**
+         * sub rsp, 8; call counted; add rsp, 8; ret
+         * In the binary, so counted and the hook are in rel32 range.
+         */
+        alignas(0x1000) static byte_t thunk[0x1000];
+
+        constexpr std::size_t call_offset = 4;
+        const std::array<byte_t, 13> code { 0x48, 0x83, 0xEC, 0x08, 0xE8,
+                                            0,    0,    0,    0,    0x48,
+                                            0x83, 0xC4, 0x08 };
+
+        std::copy(code.begin(), code.end(), thunk);
+        thunk[code.size()] = 0xC3;
+
+        const auto call_site = view_as<std::uintptr_t>(&thunk[call_offset]);
+        const auto rel32 = view_as<std::int32_t>(
+          view_as<std::uintptr_t>(&counted) - (call_site + 5));
+        std::memcpy(&thunk[call_offset + 1], &rel32, sizeof(rel32));
+
+        if (::mprotect(thunk,
+                       sizeof(thunk),
+                       PROT_READ | PROT_WRITE | PROT_EXEC)
+            != 0)
+        {
+            throw Exception("instrumentation, can't make the thunk "
+                            "executable");
+        }
+
+        const auto thunk_func = view_as<int (*)(int)>(&thunk[0]);
+
+        /* Already writable, no need for the remote mprotect */
+        const auto keep_protection = [](ptr_t, int (*)(int)) {};
+
+        Instrumentation::HookCall<counted_probe, int, int>(
+          view_as<ptr_t>(call_site),
+          keep_protection,
+          keep_protection);
+        counted_probe.reset();
+
+        const auto results_match = thunk_func(1) == 2 and thunk_func(41) == 42;
+
+        Check(results_match and counted_probe.read().calls == 2
+                and counted_probe.original() == view_as<ptr_t>(&counted),
+              "instrumentation, hook call site");
+
+        /* Anonymous mappings are far from the binary */
+        const auto far_page = ::mmap(nullptr,
+                                     0x1000,
+                                     PROT_READ | PROT_WRITE | PROT_EXEC,
+                                     MAP_PRIVATE | MAP_ANONYMOUS,
+                                     -1,
+                                     0);
+
+        if (far_page == MAP_FAILED)
+        {
+            throw Exception("instrumentation, can't map the far page");
+        }
+
+        const auto far_site = view_as<byte_t*>(far_page);
+        std::copy_n(&thunk[call_offset], 5, far_site);
+
+        const auto distance = view_as<std::uintptr_t>(far_site)
+                              - view_as<std::uintptr_t>(&counted);
+        const auto far = std::min(distance, ~distance + 1) > 0x80000000;
+
+        bool out_of_range = false;
+
+        try
+        {
+            Instrumentation::HookCall<counted_probe, int, int>(
+              far_site,
+              keep_protection,
+              keep_protection);
+        }
+        catch (Exception&)
+        {
+            out_of_range = true;
+        }
+
+        Check(not far
+                or (out_of_range
+                    and std::equal(far_site,
+                                   far_site + 5,
+                                   &thunk[call_offset])),
+              "instrumentation, rel32 out of range");
+
+        ::munmap(far_page, 0x1000);
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+#endif
+
+    try
+    {
+        const auto regions = EntropyMap::Map(Process::self());
+
+        for (const auto& region : regions)
+        {
+            const auto random_pages = std::count_if(
+              region.entropies.begin(),
+              region.entropies.end(),
+              [](const std::uint8_t entropy)
+              {
+                  return entropy != EntropyMap::UNREADABLE
+                         and EntropyMap::ToBits(entropy) > 7.5;
+              });
+
+            ConsoleOutput(region.name)
+              << ": " << std::hex << region.address << std::dec << " "
+              << EntropyMap::Entropy(region.histogram)
+              << " bits per byte, " << random_pages << "/"
+              << region.entropies.size() << " random pages" << std::endl;
+        }
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+    }
+
+#ifndef WINDOWS
+    try
+    {
+        struct Other
+        {
+            virtual ~Other() = default;
+        };
+
+        const auto vtable_of = [](const void* const object)
+        {
+            return *view_as<const std::uintptr_t*>(object);
+        };
+
+        const auto apis  = std::make_unique<Test::API[]>(2);
+        const auto other = std::make_unique<Other>();
+
+        /* Objects at the start of the first and the last page */
+        const auto page_size = MemoryUtils::GetPageSize();
+        const auto pages     = view_as<byte_t*>(::mmap(nullptr,
+                                                    page_size * 3,
+                                                    PROT_READ | PROT_WRITE,
+                                                    MAP_PRIVATE
+                                                      | MAP_ANONYMOUS,
+                                                    -1,
+                                                    0));
+
+        const auto api_vtable = vtable_of(&apis[0]);
+        std::memcpy(pages, &api_vtable, sizeof(api_vtable));
+        std::memcpy(pages + page_size * 2,
+                    &api_vtable,
+                    sizeof(api_vtable));
+
+        /* The middle page goes away after the refresh of the map */
+        const auto process = Process::self();
+        ::munmap(pages + page_size, page_size);
+
+        const ObjectEnumerator enumerator(
+          { api_vtable, vtable_of(other.get()), api_vtable });
+        const auto instances = enumerator.scan(process);
+
+        const auto has = [&](const std::size_t index, const void* object)
+        {
+            return std::find(instances[index].begin(),
+                             instances[index].end(),
+                             object)
+                   != instances[index].end();
+        };
+
+        Check(has(0, &apis[0]) and has(0, &apis[1]) and has(0, pages)
+                and has(0, pages + page_size * 2) and has(1, other.get())
+                and not has(1, &apis[0]) and instances[2] == instances[0],
+              "object enumerator");
+
+        ::munmap(pages, page_size);
+        ::munmap(pages + page_size * 2, page_size);
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+#endif
+
+    try
+    {
+        const auto page_size = MemoryUtils::GetPageSize();
+
+        /* Matches that run into an empty page, or sit on area edges */
+        const std::vector<std::size_t> offsets { 0,
+                                                 page_size - 2,
+                                                 page_size * 2 + 0x10,
+                                                 page_size * 5 - 3 };
+
+        bytes_t bytes(page_size * 5);
+
+        for (const auto offset : offsets)
+        {
+            bytes[offset]     = 0xAB;
+            bytes[offset + 1] = 0xCD;
+        }
+
+        MockProcess mock_process("empty pages");
+        mock_process.addArea(0x400000,
+                             bytes.size(),
+                             MemoryArea::ProtectionFlags::READ,
+                             "",
+                             bytes);
+
+        const auto found = [&](const bool skipEmptyPages)
+        {
+            PatternByte pattern({ 0xAB, 0xCD, 0x00 });
+            PatternScanning::searchInProcess(pattern,
+                                             mock_process.process(),
+                                             PatternScanning::searchV4,
+                                             skipEmptyPages);
+
+            std::vector<std::size_t> result;
+
+            for (const auto match : pattern.matches())
+            {
+                result.push_back(view_as<std::uintptr_t>(match) - 0x400000);
+            }
+
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+
+        Check(found(true) == offsets and found(false) == offsets,
+              "empty pages search");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+#ifndef WINDOWS
+    try
+    {
+        const auto page_size = MemoryUtils::GetPageSize();
+        const auto page      = view_as<byte_t*>(::mmap(nullptr,
+                                                   page_size * 2,
+                                                   PROT_READ | PROT_WRITE,
+                                                   MAP_PRIVATE
+                                                     | MAP_ANONYMOUS,
+                                                   -1,
+                                                   0));
+
+        /* The second page is unmapped, reads and writes there fail */
+        ::munmap(page + page_size, page_size);
+
+        const auto process         = Process::self();
+        const std::uint32_t value  = 0xDEADBEEF;
+        const auto unmapped        = page + page_size;
+        std::uint32_t across_pages = 0;
+
+        const auto written   = process.tryWrite(page, &value, sizeof(value));
+        const auto read      = process.tryRead<std::uint32_t>(page);
+        const auto bad_read  = process.tryRead<std::uint32_t>(unmapped);
+        const auto bad_write = process.tryWrite(unmapped,
+                                                &value,
+                                                sizeof(value));
+        const auto partial   = process.tryRead(unmapped - 2,
+                                               &across_pages,
+                                               sizeof(across_pages));
+
+        Check(written and read and *read == value and not bad_read
+                and bad_read.error() == ErrorCode::BAD_ADDRESS
+                and not bad_write and not partial,
+              "try read and write");
+
+        ::munmap(page, page_size);
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+#endif
+
+    try
+    {
+        MockProcess mock_process("protect");
+        mock_process.addArea(0x400000,
+                             0x2000,
+                             MemoryArea::ProtectionFlags::READ
+                               | MemoryArea::ProtectionFlags::WRITE);
+
+        auto process              = mock_process.process();
+        const std::uint32_t value = 0x1337;
+
+        const std::uintptr_t area = 0x400000;
+
+        const auto protect = process.tryProtect(
+          area,
+          0x1000,
+          MemoryArea::ProtectionFlags::READ);
+        const auto denied_write = process.tryWrite(area,
+                                                   &value,
+                                                   sizeof(value));
+        const auto allowed_write = process.tryWrite(area + 0x1000,
+                                                    &value,
+                                                    sizeof(value));
+        const auto bad_protect = process.tryProtect(
+          area + 0x2000,
+          0x1000,
+          MemoryArea::ProtectionFlags::READ);
+
+        Check(protect and not denied_write and allowed_write
+                and not bad_protect
+                and bad_protect.error() == ErrorCode::BAD_ADDRESS,
+              "try protect");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        MonotonicArena arena(0x100);
+
+        const auto first  = arena.allocate(0x10, 8);
+        const auto second = arena.allocate(0x30, 0x20);
+        const auto big    = arena.allocate(0x400, 0x40);
+
+        const auto aligned = view_as<std::uintptr_t>(second) % 0x20 == 0
+                             and view_as<std::uintptr_t>(big) % 0x40 == 0
+                             and first != second;
+        const auto used     = arena.used();
+        const auto capacity = arena.capacity();
+
+        /* The blocks get merged, the same frame fits in one of them */
+        arena.reset();
+
+        const auto first_again = view_as<std::uintptr_t>(
+          arena.allocate(0x10, 8));
+        const auto second_again = view_as<std::uintptr_t>(
+          arena.allocate(0x30, 0x20));
+        const auto big_again = view_as<std::uintptr_t>(
+          arena.allocate(0x400, 0x40));
+
+        Check(aligned and used == 0x440 and arena.used() == used
+                and arena.capacity() == capacity
+                and first_again < second_again and second_again < big_again
+                and big_again + 0x400 - first_again <= capacity,
+              "monotonic arena");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        MockProcess mock_process("scoped resource");
+        mock_process.addArea(0x400000,
+                             0x2000,
+                             MemoryArea::ProtectionFlags::READ,
+                             "",
+                             { 0x48, 0x89, 0xE5, 0xC3 });
+
+        MonotonicArena arena;
+        const auto previous = MemoryResource::current();
+        auto process        = mock_process.process();
+        PatternByte pattern({ 0x89, 0xE5 });
+
+        bool scoped = false;
+        std::size_t map_used;
+
+        {
+            const ScopedMemoryResource scoped_resource(&arena);
+            scoped = MemoryResource::current() == &arena;
+
+            /* Memory maps outlive the arena, they mustn't come from it */
+            process.mmap().refresh();
+            map_used = arena.used();
+
+            PatternScanning::searchInProcess(pattern, process);
+        }
+
+        const auto scan_used = arena.used();
+        arena.reset();
+
+        Check(scoped and MemoryResource::current() == previous
+                and map_used == 0 and scan_used > 0
+                and process.mmap().areas().size() == 1
+                and process.mmap().areas().front()->begin() == 0x400000
+                and pattern.matches().size() == 1,
+              "scoped memory resource");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        MockProcess mock_process("remote view");
+        mock_process.addArea(0x400000,
+                             0x1000,
+                             MemoryArea::ProtectionFlags::READ
+                               | MemoryArea::ProtectionFlags::WRITE);
+
+        /* Word and Half overlap, Next touches them, Far is on its own */
+        using Word   = RemoteField<0x0, std::uint32_t>;
+        using Half   = RemoteField<0x2, std::uint16_t>;
+        using Next   = RemoteField<0x4, std::uint32_t>;
+        using Unset  = RemoteField<0x10, std::uint32_t>;
+        using Far    = RemoteField<0x200, std::uint32_t>;
+        using Layout = RemoteLayout<Far, Unset, Next, Half, Word>;
+
+        RemoteView<Layout> view(ProcessBase(mock_process.id()), 0x400000);
+
+        const auto calls_before_fetch = mock_process.callsCount();
+        view.fetch();
+        const auto fetch_calls = mock_process.callsCount()
+                                 - calls_before_fetch;
+
+        /* Written behind the view's back, committing mustn't undo it */
+        const std::uint32_t unset_value = 0x600DF00D;
+        mock_process.tryWrite(0x400010, &unset_value, sizeof(unset_value));
+
+        view.set<Word>(0x11223344);
+        view.set<Half>(0xAABB);
+        view.set<Next>(0x55667788);
+        view.set<Far>(0x99AABBCC);
+
+        const auto calls_before_commit = mock_process.callsCount();
+        view.commit();
+        const auto commit_calls = mock_process.callsCount()
+                                  - calls_before_commit;
+
+        std::array<std::uint32_t, 4> remote {};
+
+        for (const auto& [index, offset] :
+             { std::pair<std::size_t, std::uintptr_t> { 0, 0x0 },
+               { 1, 0x4 },
+               { 2, 0x10 },
+               { 3, 0x200 } })
+        {
+            mock_process.tryRead(0x400000 + offset,
+                                 &remote[index],
+                                 sizeof(remote[index]));
+        }
+
+        Check(fetch_calls == 2 and commit_calls == 2
+                and remote[0] == 0xAABB3344 and remote[1] == 0x55667788
+                and remote[2] == unset_value and remote[3] == 0x99AABBCC
+                and not view.isDirty<Word>(),
+              "remote view commit");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        MockProcess mock_process("pointer chains");
+        mock_process.addArea(0x400000,
+                             0x1000,
+                             MemoryArea::ProtectionFlags::READ
+                               | MemoryArea::ProtectionFlags::WRITE);
+
+        const auto write_pointer = [&](const std::uintptr_t address,
+                                       const std::uintptr_t pointer)
+        {
+            mock_process.tryWrite(address, &pointer, sizeof(pointer));
+        };
+
+        write_pointer(0x400000, 0x400100);
+        write_pointer(0x400110, 0x400200);
+        /* Points to nothing, following it further must fail */
+        write_pointer(0x400118, 0xDEAD0000);
+
+        PointerChainResolver resolver(ProcessBase(mock_process.id()));
+        const auto field  = resolver.add(0x400000, { 0, 0x8 });
+        const auto nested = resolver.add(0x400000, { 0, 0x10, 0x4 });
+        const auto broken = resolver.add(0x400000, { 0, 0x18, 0, 0 });
+
+        const auto calls_before = mock_process.callsCount();
+        resolver.resolve();
+        const auto calls = mock_process.callsCount() - calls_before;
+
+        const auto field_address  = resolver.address(field);
+        const auto nested_address = resolver.address(nested);
+        const auto broken_address = resolver.address(broken);
+
+        /* The shared prefix is a single node, one read per level */
+        Check(field_address and *field_address == 0x400108
+                and nested_address and *nested_address == 0x400204
+                and not broken_address
+                and broken_address.error() == ErrorCode::BAD_ADDRESS
+                and resolver.address(3).error()
+                      == ErrorCode::INVALID_ARGUMENT
+                and resolver.nodes().size() == 8 and calls == 3,
+              "pointer chain resolver");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+    try
+    {
+        const auto folder = std::filesystem::temp_directory_path()
+                            / ("asura_dump_"
+                               + std::to_string(Process::self().id()));
+        std::filesystem::create_directories(folder);
+
+        const auto dump = [&](const std::string& name)
+        {
+            std::ofstream file(folder / name, std::ios::binary);
+            file << "\x7F" "ELF";
+        };
+
+        const auto rx = std::to_string(MemoryArea::ProtectionFlags::RX);
+        dump("_usr_lib_lib_mock.so_400000_401000_" + rx);
+        dump("_usr_lib_old.so_402000_403000_" + rx);
+        dump("[heap]_404000_405000_"
+             + std::to_string(MemoryArea::ProtectionFlags::READ));
+
+        /* The old module has no line, like a dump from before the file */
+        std::ofstream(folder / MockProcess::DUMP_MAPS_NAME)
+          << "00400000-00401000 r-xp 00001000 08:01 1234 "
+             "/usr/lib/lib_mock.so\n"
+             "00404000-00405000 rw-p 00000000 00:00 0 [heap]\n";
+
+        bool found_backend = false;
+        process_id_t mock_id;
+        std::list<Process::Module> modules;
+        std::vector<std::tuple<std::string, std::uint64_t>> areas;
+
+        {
+            MockProcess mock_process("dump");
+            mock_process.loadDump(folder.string());
+            mock_id       = mock_process.id();
+            found_backend = MemoryBackend::Find(mock_id) == &mock_process;
+
+            auto process = mock_process.process();
+            modules      = process.modules();
+
+            for (const auto& area : process.mmap().areas())
+            {
+                areas.emplace_back(area->name(), area->inode());
+            }
+        }
+
+        std::filesystem::remove_all(folder);
+
+        const auto has_module = [&](const std::string& path)
+        {
+            return std::any_of(modules.begin(),
+                               modules.end(),
+                               [&](const Process::Module& module)
+                               {
+                                   return module.path() == path;
+                               });
+        };
+
+        Check(found_backend and MemoryBackend::Find(mock_id) == nullptr
+                and areas.size() == 3
+                and areas[0] == std::make_tuple("/usr/lib/lib_mock.so", 1234)
+                and std::get<0>(areas[1]) == "/usr/lib/old.so"
+                and std::get<1>(areas[1]) != 0
+                and areas[2] == std::make_tuple("[heap]", 0)
+                and modules.size() == 2
+                and has_module("/usr/lib/lib_mock.so")
+                and has_module("/usr/lib/old.so"),
+              "mock process dump");
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+
+#ifndef WINDOWS
+    try
+    {
+        static volatile std::uint64_t counter = 0;
+
+        std::vector<ProcessSnapshot::Method> methods {
+            ProcessSnapshot::PTRACE
+        };
+
+        if (ProcessSnapshot::IsRcloneSupported())
+        {
+            methods.push_back(ProcessSnapshot::RCLONE);
+        }
+
+        for (const auto method : methods)
+        {
+            const auto target = fork();
+
+            if (target == 0)
+            {
+                while (true)
+                {
+                    counter = counter + 1;
+
+                    /* The snapshot must never show up as a child */
+                    if (waitpid(-1, nullptr, WNOHANG) > 0)
+                    {
+                        _exit(3);
+                    }
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            const auto read_counter = [&](const process_id_t pid)
+            {
+                return MemoryUtils::TryReadProcessMemory<std::uint64_t>(
+                         pid,
+                         &counter)
+                  .value_or(0);
+            };
+
+            int status;
+
+            const auto stop_target = [&]
+            {
+                ::kill(target, SIGKILL);
+                waitpid(target, &status, 0);
+            };
+
+            std::uint64_t frozen = 0;
+            bool still_frozen    = false;
+            bool target_went_on  = false;
+            bool reaped          = false;
+
+            try
+            {
+                ProcessSnapshot snapshot(ProcessBase(target), method);
+                const auto snapshot_id = snapshot.id();
+                frozen                 = read_counter(snapshot_id);
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+                still_frozen   = read_counter(snapshot_id) == frozen;
+                target_went_on = read_counter(target) > frozen;
+
+                snapshot.release();
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+                reaped = ::kill(snapshot_id, 0) < 0 and errno == ESRCH;
+            }
+            catch (Exception&)
+            {
+                stop_target();
+                throw;
+            }
+
+            stop_target();
+
+            Check(frozen > 0 and still_frozen and target_went_on and reaped
+                    and WIFSIGNALED(status),
+                  std::string("process snapshot, ")
+                    + (method == ProcessSnapshot::PTRACE ? "ptrace" :
+                                                           "rclone"));
+        }
+    }
+    catch (Exception& e)
+    {
+        ConsoleOutput(e.msg()) << std::endl;
+        g_PassedTests = false;
+    }
+#endif
+
+    if (g_PassedTests)
+    {
+        ConsoleOutput("Passed all tests") << std::endl;
+    }
+    else
+    {
+        ConsoleOutput("Failed test(s)") << std::endl;
+    }
+
     // std::getchar();
 }
 
@@ -13,6 +13,8 @@ namespace Asura
     using byte_t  = unsigned char;
     using data_t  = byte_t*;
     using bytes_t = std::vector<byte_t>;
+    /* bytes_t allocated from a std::pmr::memory_resource */
+    using pmr_bytes_t = std::pmr::vector<byte_t>;
 #ifndef WINDOWS
     /* linux pid_t */
     using process_id_t = std::int32_t;
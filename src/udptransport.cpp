@@ -0,0 +1,280 @@
+#include "pch.h"
+
+#include "udptransport.h"
+
+#ifndef WINDOWS
+using namespace Asura;
+
+UDPTransport::UDPTransport(const std::uint16_t port,
+                           const std::size_t poolSize,
+                           const std::size_t socketSize)
+ : _write_slab(poolSize * PACKET_SIZE),
+   _read_slab(BATCH_SIZE * PACKET_SIZE),
+   _packets(BATCH_SIZE)
+{
+    if (poolSize == 0)
+    {
+        ASURA_EXCEPTION("The pool needs at least one buffer");
+    }
+
+    _socket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (_socket < 0)
+    {
+        ASURA_EXCEPTION(std::string("Couldn't create the socket: ")
+                        + std::strerror(errno));
+    }
+
+    /* Bigger queues, so a burst of batches isn't dropped */
+    const int size = view_as<int>(socketSize);
+    setsockopt(_socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(_socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    sockaddr_in address {};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port        = htons(port);
+
+    socklen_t address_size = sizeof(address);
+
+    if (bind(_socket, view_as<sockaddr*>(&address), sizeof(address)) < 0
+        or getsockname(_socket,
+                       view_as<sockaddr*>(&address),
+                       &address_size)
+             < 0)
+    {
+        const auto error = errno;
+        close(_socket);
+
+        ASURA_EXCEPTION("Couldn't bind to port " + std::to_string(port)
+                        + ": " + std::strerror(error));
+    }
+
+    _port = ntohs(address.sin_port);
+
+    _writers.reserve(poolSize);
+    _free_writers.reserve(poolSize);
+
+    for (std::size_t i = 0; i < poolSize; i++)
+    {
+        _writers.emplace_back(&_write_slab[i * PACKET_SIZE], PACKET_SIZE);
+        _free_writers.push_back(poolSize - i - 1);
+    }
+
+    for (std::size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        _send_headers[i].msg_hdr.msg_name    = &_send_addresses[i];
+        _send_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        _send_headers[i].msg_hdr.msg_iov     = &_send_iovecs[i];
+        _send_headers[i].msg_hdr.msg_iovlen  = 1;
+
+        _receive_iovecs[i].iov_base = &_read_slab[i * PACKET_SIZE];
+        _receive_iovecs[i].iov_len  = PACKET_SIZE;
+
+        _receive_headers[i].msg_hdr.msg_name   = &_receive_addresses[i];
+        _receive_headers[i].msg_hdr.msg_iov    = &_receive_iovecs[i];
+        _receive_headers[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+UDPTransport::~UDPTransport()
+{
+    try
+    {
+        flush();
+    }
+    catch (Exception&)
+    {
+    }
+
+    close(_socket);
+}
+
+auto UDPTransport::Address(const std::string& ip, const std::uint16_t port)
+  -> sockaddr_in
+{
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(port);
+
+    if (inet_pton(AF_INET, ip.c_str(), &address.sin_addr) != 1)
+    {
+        ASURA_EXCEPTION("Invalid IPv4 address " + ip);
+    }
+
+    return address;
+}
+
+auto UDPTransport::port() const -> std::uint16_t
+{
+    return _port;
+}
+
+auto UDPTransport::pendingCount() const -> std::size_t
+{
+    return _pending_count;
+}
+
+auto UDPTransport::freeCount() const -> std::size_t
+{
+    return _free_writers.size();
+}
+
+auto UDPTransport::acquire() -> NetworkWriteBuffer&
+{
+    if (_free_writers.empty())
+    {
+        flush();
+    }
+
+    if (_free_writers.empty())
+    {
+        ASURA_EXCEPTION("All the buffers of the pool are in use");
+    }
+
+    const auto index = _free_writers.back();
+    _free_writers.pop_back();
+
+    auto&& writer = _writers[index];
+    std::fill_n(writer.data(), PACKET_SIZE, 0);
+    writer.pos(0);
+
+    return writer;
+}
+
+auto UDPTransport::release(NetworkWriteBuffer& buffer) -> void
+{
+    _free_writers.push_back(indexOf(buffer));
+}
+
+auto UDPTransport::send(NetworkWriteBuffer& buffer, const sockaddr_in& to)
+  -> void
+{
+    const auto index = indexOf(buffer);
+
+    _send_iovecs[_pending_count].iov_base = buffer.data();
+    _send_iovecs[_pending_count].iov_len  = (buffer.writtenBits()
+                                            + CHAR_BIT - 1)
+                                           / CHAR_BIT;
+    _send_addresses[_pending_count] = to;
+    _send_writers[_pending_count]   = index;
+
+    if (++_pending_count == BATCH_SIZE)
+    {
+        flush();
+    }
+}
+
+auto UDPTransport::flush() -> void
+{
+    std::size_t sent = 0;
+
+    while (sent < _pending_count)
+    {
+        const auto ret = sendmmsg(_socket,
+                                  &_send_headers[sent],
+                                  view_as<unsigned int>(_pending_count
+                                                        - sent),
+                                  0);
+
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            const auto error = errno;
+
+            /* The rest is dropped, the buffers must go back anyway */
+            for (std::size_t i = 0; i < _pending_count; i++)
+            {
+                _free_writers.push_back(_send_writers[i]);
+            }
+
+            _pending_count = 0;
+
+            ASURA_EXCEPTION(std::string("Couldn't send the packets: ")
+                            + std::strerror(error));
+        }
+
+        sent += view_as<std::size_t>(ret);
+    }
+
+    for (std::size_t i = 0; i < _pending_count; i++)
+    {
+        _free_writers.push_back(_send_writers[i]);
+    }
+
+    _pending_count = 0;
+}
+
+auto UDPTransport::receive(const std::chrono::milliseconds timeout)
+  -> std::span<Packet>
+{
+    pollfd poll_fd { .fd = _socket, .events = POLLIN, .revents = 0 };
+
+    const auto ready = poll(&poll_fd, 1, view_as<int>(timeout.count()));
+
+    if (ready < 0 and errno != EINTR)
+    {
+        ASURA_EXCEPTION(std::string("Couldn't poll the socket: ")
+                        + std::strerror(errno));
+    }
+
+    if (ready <= 0)
+    {
+        return {};
+    }
+
+    for (auto&& header : _receive_headers)
+    {
+        header.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+
+    const auto count = recvmmsg(_socket,
+                                _receive_headers.data(),
+                                BATCH_SIZE,
+                                MSG_DONTWAIT,
+                                nullptr);
+
+    if (count < 0)
+    {
+        if (errno == EAGAIN or errno == EWOULDBLOCK or errno == EINTR)
+        {
+            return {};
+        }
+
+        ASURA_EXCEPTION(std::string("Couldn't receive the packets: ")
+                        + std::strerror(errno));
+    }
+
+    for (std::size_t i = 0; i < view_as<std::size_t>(count); i++)
+    {
+        const auto size = std::min<std::size_t>(_receive_headers[i].msg_len,
+                                                PACKET_SIZE);
+
+        _packets[i].buffer = NetworkReadBuffer(&_read_slab[i * PACKET_SIZE],
+                                               size);
+        _packets[i].from   = _receive_addresses[i];
+        _packets[i].size   = size;
+    }
+
+    return { _packets.data(), view_as<std::size_t>(count) };
+}
+
+auto UDPTransport::indexOf(const NetworkWriteBuffer& buffer) const
+  -> std::size_t
+{
+    const auto offset = view_as<std::uintptr_t>(&buffer)
+                        - view_as<std::uintptr_t>(_writers.data());
+    const auto index  = offset / sizeof(NetworkWriteBuffer);
+
+    if (offset % sizeof(NetworkWriteBuffer) != 0 or index >= _writers.size())
+    {
+        ASURA_EXCEPTION("The buffer doesn't belong to this transport");
+    }
+
+    return index;
+}
+#endif
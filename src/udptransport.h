@@ -0,0 +1,109 @@
+#ifndef ASURA_UDPTRANSPORT_H
+#define ASURA_UDPTRANSPORT_H
+
+#include "networkreadbuffer.h"
+#include "networkwritebuffer.h"
+
+#ifndef WINDOWS
+namespace Asura
+{
+    /**
+     * UDP socket moving packets by batches:
+     *
+     * UDPTransport transport;
+     * auto&& packet = transport.acquire();
+     * packet.writeVar<type_32us>(42);
+     * transport.send(packet, UDPTransport::Address("127.0.0.1", 1337));
+     * transport.flush();
+     * ...
+     * for (auto&& received : transport.receive(timeout))
+     *     received.buffer.readVar<type_32us>();
+     *
+     * Packets are written into a pool of buffers allocated once, queued
+     * and sent BATCH_SIZE at a time with one sendmmsg. Receiving fills
+     * up to BATCH_SIZE buffers registered at construction with one
+     * recvmmsg, the read buffers are views on them, nothing is copied or
+     * allocated after the constructor.
+     */
+    class UDPTransport
+    {
+      public:
+        static constexpr std::size_t BATCH_SIZE  = 64;
+        static constexpr std::size_t PACKET_SIZE = UDPSize;
+
+        struct Packet
+        {
+            NetworkReadBuffer buffer;
+            sockaddr_in from;
+            /* Bigger packets are truncated to PACKET_SIZE */
+            std::size_t size;
+        };
+
+      public:
+        explicit UDPTransport(const std::uint16_t port     = 0,
+                              const std::size_t poolSize   = 0x400,
+                              const std::size_t socketSize = 0x400000);
+        ~UDPTransport();
+
+        UDPTransport(const UDPTransport&)                    = delete;
+        auto operator=(const UDPTransport&) -> UDPTransport& = delete;
+
+      public:
+        static auto Address(const std::string& ip, const std::uint16_t port)
+          -> sockaddr_in;
+
+      public:
+        auto port() const -> std::uint16_t;
+        auto pendingCount() const -> std::size_t;
+        auto freeCount() const -> std::size_t;
+
+      public:
+        /**
+         * A cleared buffer of PACKET_SIZE bytes, flushes the queued
+         * packets when the pool is empty.
+         */
+        auto acquire() -> NetworkWriteBuffer&;
+        /* Gives back a buffer that won't be sent */
+        auto release(NetworkWriteBuffer& buffer) -> void;
+        /**
+         * Queues the written bytes of buffer, it goes back to the pool
+         * once sent. Flushes when a batch is full.
+         */
+        auto send(NetworkWriteBuffer& buffer, const sockaddr_in& to)
+          -> void;
+        auto flush() -> void;
+        /**
+         * Waits up to timeout for packets, the views are valid until
+         * the next call.
+         */
+        auto receive(const std::chrono::milliseconds timeout = {})
+          -> std::span<Packet>;
+
+      private:
+        auto indexOf(const NetworkWriteBuffer& buffer) const
+          -> std::size_t;
+
+      private:
+        int _socket;
+        std::uint16_t _port {};
+
+        bytes_t _write_slab;
+        std::vector<NetworkWriteBuffer> _writers;
+        std::vector<std::size_t> _free_writers;
+
+        std::array<mmsghdr, BATCH_SIZE> _send_headers {};
+        std::array<iovec, BATCH_SIZE> _send_iovecs {};
+        std::array<sockaddr_in, BATCH_SIZE> _send_addresses {};
+        std::array<std::size_t, BATCH_SIZE> _send_writers {};
+        std::size_t _pending_count {};
+
+        bytes_t _read_slab;
+        std::array<mmsghdr, BATCH_SIZE> _receive_headers {};
+        std::array<iovec, BATCH_SIZE> _receive_iovecs {};
+        std::array<sockaddr_in, BATCH_SIZE> _receive_addresses {};
+        std::vector<Packet> _packets;
+    };
+}
+#endif
+
+#endif
@@ -0,0 +1,498 @@
+#include "pch.h"
+
+#include "memorybackend.h"
+#include "memoryutils.h"
+#include "simd.h"
+#include "valuewatcher.h"
+
+using namespace Asura;
+
+ValueWatcher::ValueWatcher(const ProcessBase& processBase,
+                           const std::chrono::nanoseconds interval)
+ : _process_base(processBase),
+   _interval(interval)
+{
+}
+
+ValueWatcher::~ValueWatcher()
+{
+    stop();
+}
+
+auto ValueWatcher::interval() const -> std::chrono::nanoseconds
+{
+    std::lock_guard lock(_mutex);
+    return _interval;
+}
+
+auto ValueWatcher::isRunning() const -> bool
+{
+    return _thread.joinable();
+}
+
+auto ValueWatcher::ticksCount() const -> std::uint64_t
+{
+    return _ticks_count;
+}
+
+auto ValueWatcher::droppedCount() const -> std::size_t
+{
+    return _dropped_count;
+}
+
+auto ValueWatcher::pagesCount() const -> std::size_t
+{
+    std::lock_guard lock(_mutex);
+    return _valids.size();
+}
+
+auto ValueWatcher::add(const std::uintptr_t address, const std::size_t size)
+  -> std::size_t
+{
+    if (size == 0)
+    {
+        ASURA_EXCEPTION("Can't watch 0 bytes");
+    }
+
+    std::lock_guard lock(_mutex);
+
+    _watches.push_back({ address, size });
+    _dirty = true;
+
+    return _watches.size() - 1;
+}
+
+auto ValueWatcher::remove(const std::size_t watch) -> void
+{
+    std::lock_guard lock(_mutex);
+
+    if (watch >= _watches.size())
+    {
+        ASURA_EXCEPTION("No watch " + std::to_string(watch));
+    }
+
+    _watches[watch].removed = true;
+    _dirty                  = true;
+}
+
+auto ValueWatcher::setInterval(const std::chrono::nanoseconds interval)
+  -> void
+{
+    {
+        std::lock_guard lock(_mutex);
+        _interval = interval;
+    }
+
+    _wake_up.notify_one();
+}
+
+auto ValueWatcher::start() -> void
+{
+    if (_thread.joinable())
+    {
+        return;
+    }
+
+    _stopping = false;
+    _thread   = std::thread(&ValueWatcher::run, this);
+}
+
+auto ValueWatcher::stop() -> void
+{
+    if (not _thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+
+    _wake_up.notify_one();
+    _thread.join();
+}
+
+auto ValueWatcher::poll() -> std::optional<Change>
+{
+    return _changes.pop();
+}
+
+auto ValueWatcher::run() -> void
+{
+    auto next_tick = std::chrono::steady_clock::now();
+
+    std::unique_lock lock(_mutex);
+
+    while (not _stopping)
+    {
+        lock.unlock();
+        tick();
+        lock.lock();
+
+        /* Don't try to catch up when a tick took too long */
+        next_tick = std::max(next_tick + _interval,
+                             std::chrono::steady_clock::now());
+
+        _wake_up.wait_until(lock,
+                            next_tick,
+                            [this]()
+                            {
+                                return _stopping;
+                            });
+    }
+}
+
+auto ValueWatcher::tick() -> void
+{
+    constexpr auto simd_size = sizeof(SIMD::value_t);
+
+    std::lock_guard lock(_mutex);
+
+    if (_dirty)
+    {
+        rebuild();
+    }
+
+    read();
+
+    const auto this_tick  = ++_ticks_count;
+    const auto page_size  = MemoryUtils::GetPageSize();
+    const auto page_count = _valids.size();
+
+    const auto check_watch = [&](const std::size_t index)
+    {
+        auto&& watch = _watches[index];
+
+        if (watch.last_seen_tick == this_tick)
+        {
+            return;
+        }
+
+        watch.last_seen_tick = this_tick;
+
+        const auto first_page = watch.offset / page_size;
+        const auto last_page  = (watch.offset + watch.size - 1) / page_size;
+
+        bool valid = true;
+
+        for (auto page = first_page; page <= last_page; page++)
+        {
+            valid = valid and _valids[page];
+        }
+
+        const auto current = &_current[watch.offset];
+
+        if (watch.fresh)
+        {
+            watch.fresh = false;
+            watch.valid = valid;
+            return;
+        }
+
+        if (valid == watch.valid
+            and (not valid
+                 or std::equal(current,
+                               current + watch.size,
+                               &_previous[watch.offset])))
+        {
+            return;
+        }
+
+        watch.valid = valid;
+
+        Change change { index,
+                        watch.address,
+                        valid ? bytes_t(current, current + watch.size) :
+                                bytes_t(),
+                        this_tick };
+
+        if (not _changes.push(std::move(change)))
+        {
+            _dropped_count++;
+        }
+    };
+
+    /* Watches touching the SIMD value at offset */
+    const auto check_value = [&](const std::size_t offset)
+    {
+        auto sorted_watch = std::lower_bound(
+          _sorted_watches.begin(),
+          _sorted_watches.end(),
+          offset - std::min(offset, _max_watch_size - 1),
+          [this](const std::size_t index, const std::size_t value)
+          {
+              return _watches[index].offset < value;
+          });
+
+        for (; sorted_watch != _sorted_watches.end()
+               and _watches[*sorted_watch].offset < offset + simd_size;
+             sorted_watch++)
+        {
+            const auto& watch = _watches[*sorted_watch];
+
+            if (watch.offset + watch.size > offset)
+            {
+                check_watch(*sorted_watch);
+            }
+        }
+    };
+
+    for (std::size_t page = 0; page < page_count; page++)
+    {
+        const auto page_offset = page * page_size;
+
+        if (_valids[page] != _previous_valids[page])
+        {
+            for (std::size_t offset = page_offset;
+                 offset < page_offset + page_size;
+                 offset += simd_size)
+            {
+                check_value(offset);
+            }
+
+            continue;
+        }
+
+        if (not _valids[page])
+        {
+            continue;
+        }
+
+        for (std::size_t offset = page_offset;
+             offset < page_offset + page_size;
+             offset += simd_size)
+        {
+            const auto equal = SIMD::CMPMask8bits(
+                                 SIMD::LoadUnaligned(
+                                   view_as<SIMD::value_t*>(
+                                     &_current[offset])),
+                                 SIMD::LoadUnaligned(
+                                   view_as<SIMD::value_t*>(
+                                     &_previous[offset])))
+                               == SIMD::cmp_all;
+
+            if (not equal)
+            {
+                check_value(offset);
+            }
+        }
+    }
+
+    /* Added since the last tick, they only get their first value */
+    if (_has_fresh_watches)
+    {
+        for (const auto index : _sorted_watches)
+        {
+            if (_watches[index].fresh)
+            {
+                check_watch(index);
+            }
+        }
+
+        _has_fresh_watches = false;
+    }
+
+    std::swap(_current, _previous);
+    std::swap(_valids, _previous_valids);
+}
+
+auto ValueWatcher::rebuild() -> void
+{
+    const auto page_size = MemoryUtils::GetPageSize();
+
+    _sorted_watches.clear();
+    _ranges.clear();
+    _max_watch_size = 0;
+
+    for (std::size_t i = 0; i < _watches.size(); i++)
+    {
+        if (not _watches[i].removed)
+        {
+            _sorted_watches.push_back(i);
+        }
+    }
+
+    std::sort(_sorted_watches.begin(),
+              _sorted_watches.end(),
+              [this](const std::size_t left, const std::size_t right)
+              {
+                  return _watches[left].address < _watches[right].address;
+              });
+
+    /* Merge the pages of every watch */
+    for (const auto index : _sorted_watches)
+    {
+        const auto& watch = _watches[index];
+        const auto begin  = watch.address - watch.address % page_size;
+        const auto end    = MemoryUtils::AlignToPageSize(watch.address
+                                                           + watch.size,
+                                                         page_size);
+
+        if (_ranges.empty())
+        {
+            _ranges.push_back({ begin, end - begin, 0 });
+            continue;
+        }
+
+        auto&& last = _ranges.back();
+
+        if (begin <= last.address + last.size)
+        {
+            last.size = std::max(last.size, end - last.address);
+            continue;
+        }
+
+        _ranges.push_back({ begin, end - begin, last.offset + last.size });
+    }
+
+    const auto snapshot_size = _ranges.empty() ?
+                                 0 :
+                                 _ranges.back().offset
+                                   + _ranges.back().size;
+
+    /* Keep what was seen of the watches already reported */
+    const auto old_previous = std::move(_previous);
+
+    _current.assign(snapshot_size, 0);
+    _previous.assign(snapshot_size, 0);
+    _valids.assign(snapshot_size / page_size, false);
+    _previous_valids.assign(snapshot_size / page_size, false);
+
+    auto range = _ranges.begin();
+
+    for (const auto index : _sorted_watches)
+    {
+        auto&& watch = _watches[index];
+
+        while (watch.address >= range->address + range->size)
+        {
+            range++;
+        }
+
+        const auto offset = range->offset
+                            + (watch.address - range->address);
+
+        if (not watch.fresh)
+        {
+            std::copy_n(&old_previous[watch.offset],
+                        watch.size,
+                        &_previous[offset]);
+
+            for (auto page = offset / page_size;
+                 page <= (offset + watch.size - 1) / page_size;
+                 page++)
+            {
+                _previous_valids[page] = watch.valid;
+            }
+        }
+
+        watch.offset       = offset;
+        _max_watch_size    = std::max(_max_watch_size, watch.size);
+        _has_fresh_watches = _has_fresh_watches or watch.fresh;
+    }
+
+    _dirty = false;
+}
+
+auto ValueWatcher::read() -> void
+{
+    const auto pid       = _process_base.id();
+    const auto page_size = MemoryUtils::GetPageSize();
+
+    std::fill(_valids.begin(), _valids.end(), true);
+
+    /* Slow path for a range that failed, page by page */
+    const auto read_pages = [&](const Range& range)
+    {
+        for (std::size_t page = 0; page < range.size / page_size; page++)
+        {
+            const auto offset = range.offset + page * page_size;
+
+            if (not MemoryUtils::TryReadProcessMemoryArea(
+                  pid,
+                  range.address + page * page_size,
+                  &_current[offset],
+                  page_size))
+            {
+                std::fill_n(&_current[offset], page_size, 0);
+                _valids[offset / page_size] = false;
+            }
+        }
+    };
+
+#ifndef WINDOWS
+    if (not MemoryBackend::Find(pid))
+    {
+        std::vector<iovec> locals, remotes;
+
+        std::size_t index = 0;
+
+        while (index < _ranges.size())
+        {
+            const auto count = std::min(_ranges.size() - index,
+                                        MemoryUtils::MAX_IOVECS);
+
+            locals.clear();
+            remotes.clear();
+
+            std::size_t expected = 0;
+
+            for (std::size_t i = index; i < index + count; i++)
+            {
+                const auto& range = _ranges[i];
+
+                locals.push_back(
+                  { .iov_base = &_current[range.offset],
+                    .iov_len  = range.size });
+                remotes.push_back(
+                  { .iov_base = view_as<ptr_t>(range.address),
+                    .iov_len  = range.size });
+
+                expected += range.size;
+            }
+
+            const auto ret = process_vm_readv(pid,
+                                              locals.data(),
+                                              count,
+                                              remotes.data(),
+                                              count,
+                                              0);
+
+            if (ret == view_as<decltype(ret)>(expected))
+            {
+                index += count;
+                continue;
+            }
+
+            /**
+             * The kernel stops at the first page it can't read, the
+             * ranges before it are complete.
+             */
+            auto read = ret < 0 ? 0 : view_as<std::size_t>(ret);
+
+            while (read >= _ranges[index].size)
+            {
+                read -= _ranges[index].size;
+                index++;
+            }
+
+            read_pages(_ranges[index]);
+            index++;
+        }
+
+        return;
+    }
+#endif
+
+    for (const auto& range : _ranges)
+    {
+        if (not MemoryUtils::TryReadProcessMemoryArea(pid,
+                                                      range.address,
+                                                      &_current[range.offset],
+                                                      range.size))
+        {
+            read_pages(range);
+        }
+    }
+}
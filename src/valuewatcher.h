@@ -0,0 +1,127 @@
+#ifndef ASURA_VALUEWATCHER_H
+#define ASURA_VALUEWATCHER_H
+
+#include "processbase.h"
+#include "spscqueue.h"
+
+namespace Asura
+{
+    /**
+     * Watches many values of a process and reports the ones that
+     * changed:
+     *
+     * ValueWatcher watcher(process, std::chrono::milliseconds(10));
+     * const auto health = watcher.add(player + 0x100, sizeof(int));
+     * watcher.start();
+     * ...
+     * while (const auto change = watcher.poll())
+     *     ...
+     *
+     * Watches are merged into ranges of pages, every tick reads all of
+     * them with one vectored read and compares the pages with the
+     * previous tick, SIMD value by SIMD value. Only the watches inside
+     * values that changed are looked at, so a tick costs about the same
+     * for one watch or thousands of them in the same pages.
+     *
+     * A watch is reported each time its bytes change or it becomes
+     * readable or unreadable, the first tick after it's added only
+     * records its value.
+     * Changes go through a lock free queue, poll() must always be called
+     * from the same thread. When the queue is full, changes are dropped
+     * and counted.
+     */
+    class ValueWatcher
+    {
+      public:
+        static constexpr std::size_t QUEUE_SIZE = 0x1000;
+
+        struct Change
+        {
+            std::size_t watch;
+            std::uintptr_t address;
+            /* Empty when it can't be read */
+            bytes_t value;
+            std::uint64_t tick;
+        };
+
+      public:
+        explicit ValueWatcher(const ProcessBase& processBase,
+                              const std::chrono::nanoseconds interval
+                              = std::chrono::milliseconds(10));
+        ~ValueWatcher();
+
+        ValueWatcher(const ValueWatcher&)                    = delete;
+        auto operator=(const ValueWatcher&) -> ValueWatcher& = delete;
+
+      public:
+        auto interval() const -> std::chrono::nanoseconds;
+        auto isRunning() const -> bool;
+        auto ticksCount() const -> std::uint64_t;
+        auto droppedCount() const -> std::size_t;
+        /* Pages read every tick */
+        auto pagesCount() const -> std::size_t;
+
+      public:
+        /* Returns the watch index, can be called while running */
+        auto add(const std::uintptr_t address, const std::size_t size)
+          -> std::size_t;
+        auto remove(const std::size_t watch) -> void;
+        auto setInterval(const std::chrono::nanoseconds interval) -> void;
+        auto start() -> void;
+        auto stop() -> void;
+        /* Polls once from the calling thread, when it isn't running */
+        auto tick() -> void;
+        auto poll() -> std::optional<Change>;
+
+      private:
+        struct Watch
+        {
+            std::uintptr_t address;
+            std::size_t size;
+            /* Inside the snapshots */
+            std::size_t offset {};
+            bool removed {};
+            bool valid {};
+            /* No value recorded yet */
+            bool fresh { true };
+            std::uint64_t last_seen_tick {};
+        };
+
+        struct Range
+        {
+            std::uintptr_t address;
+            std::size_t size;
+            /* Inside the snapshots */
+            std::size_t offset;
+        };
+
+      private:
+        auto run() -> void;
+        /* Both must be called with _mutex held */
+        auto rebuild() -> void;
+        auto read() -> void;
+
+      private:
+        ProcessBase _process_base;
+        std::chrono::nanoseconds _interval;
+        std::vector<Watch> _watches;
+        /* Indices of the watches, sorted by offset */
+        std::vector<std::size_t> _sorted_watches;
+        std::size_t _max_watch_size {};
+        std::vector<Range> _ranges;
+        bytes_t _current, _previous;
+        /* Per page */
+        std::vector<bool> _valids, _previous_valids;
+        bool _dirty {};
+        bool _has_fresh_watches {};
+        std::atomic<std::uint64_t> _ticks_count {};
+        std::atomic<std::size_t> _dropped_count {};
+        mutable std::mutex _mutex;
+        std::condition_variable _wake_up;
+        bool _stopping {};
+        std::thread _thread;
+        SPSCQueue<Change, QUEUE_SIZE> _changes;
+    };
+}
+
+#endif
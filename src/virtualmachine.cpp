@@ -0,0 +1,685 @@
+#include "pch.h"
+
+#include "virtualmachine.h"
+
+using namespace Asura;
+
+using Opcode = VirtualMachine::Opcode;
+
+/* Fused by the loader, they go after the opcodes */
+enum Superinstruction : std::size_t
+{
+    /* addi a, a, i then jlt a, b, t */
+    addi_jlt = view_as<std::size_t>(Opcode::count),
+    /* mul t, a, b then add d, d, t */
+    mul_add,
+    /* shli t, a, i then bit_xor a, a, t */
+    shli_xor,
+    /* shri t, a, i then bit_xor a, a, t */
+    shri_xor,
+    operations_count
+};
+
+enum class Operands
+{
+    r,
+    ri,
+    rr,
+    rrr,
+    rri,
+    t,
+    rt,
+    rrt
+};
+
+static auto OperandsOf(const Opcode opcode) -> Operands
+{
+    if (opcode == Opcode::ret)
+    {
+        return Operands::r;
+    }
+    else if (opcode == Opcode::movi)
+    {
+        return Operands::ri;
+    }
+    else if (opcode == Opcode::mov)
+    {
+        return Operands::rr;
+    }
+    else if (opcode <= Opcode::shr)
+    {
+        return Operands::rrr;
+    }
+    else if (opcode <= Opcode::shri)
+    {
+        return Operands::rri;
+    }
+    else if (opcode == Opcode::jmp)
+    {
+        return Operands::t;
+    }
+    else if (opcode <= Opcode::jnz)
+    {
+        return Operands::rt;
+    }
+
+    return Operands::rrt;
+}
+
+auto VirtualMachine::Assembler::newLabel() -> std::size_t
+{
+    _labels.push_back(std::numeric_limits<std::size_t>::max());
+    return _labels.size() - 1;
+}
+
+auto VirtualMachine::Assembler::bind(const std::size_t label) -> void
+{
+    if (label >= _labels.size())
+    {
+        ASURA_EXCEPTION("No label " + std::to_string(label));
+    }
+
+    if (_labels[label] != std::numeric_limits<std::size_t>::max())
+    {
+        ASURA_EXCEPTION("Label " + std::to_string(label)
+                        + " is already bound");
+    }
+
+    _labels[label] = _code.size();
+}
+
+auto VirtualMachine::Assembler::ret(const reg_t value) -> void
+{
+    emit(Opcode::ret);
+    emitRegister(value);
+}
+
+auto VirtualMachine::Assembler::movi(const reg_t destination,
+                                     const std::uint64_t value) -> void
+{
+    emit(Opcode::movi);
+    emitRegister(destination);
+    emitImmediate(value);
+}
+
+auto VirtualMachine::Assembler::mov(const reg_t destination,
+                                    const reg_t source) -> void
+{
+    emit(Opcode::mov);
+    emitRegister(destination);
+    emitRegister(source);
+}
+
+auto VirtualMachine::Assembler::alu(const Opcode opcode,
+                                    const reg_t destination,
+                                    const reg_t left,
+                                    const reg_t right) -> void
+{
+    if (OperandsOf(opcode) != Operands::rrr)
+    {
+        ASURA_EXCEPTION("Not an operation between registers");
+    }
+
+    emit(opcode);
+    emitRegister(destination);
+    emitRegister(left);
+    emitRegister(right);
+}
+
+auto VirtualMachine::Assembler::alui(const Opcode opcode,
+                                     const reg_t destination,
+                                     const reg_t left,
+                                     const std::uint64_t right) -> void
+{
+    if (OperandsOf(opcode) != Operands::rri)
+    {
+        ASURA_EXCEPTION("Not an operation with an immediate");
+    }
+
+    emit(opcode);
+    emitRegister(destination);
+    emitRegister(left);
+    emitImmediate(right);
+}
+
+auto VirtualMachine::Assembler::jmp(const std::size_t label) -> void
+{
+    emit(Opcode::jmp);
+    emitTarget(label);
+}
+
+auto VirtualMachine::Assembler::jump(const Opcode opcode,
+                                     const reg_t value,
+                                     const std::size_t label) -> void
+{
+    if (OperandsOf(opcode) != Operands::rt)
+    {
+        ASURA_EXCEPTION("Not a jump testing one register");
+    }
+
+    emit(opcode);
+    emitRegister(value);
+    emitTarget(label);
+}
+
+auto VirtualMachine::Assembler::jump(const Opcode opcode,
+                                     const reg_t left,
+                                     const reg_t right,
+                                     const std::size_t label) -> void
+{
+    if (OperandsOf(opcode) != Operands::rrt)
+    {
+        ASURA_EXCEPTION("Not a jump comparing two registers");
+    }
+
+    emit(opcode);
+    emitRegister(left);
+    emitRegister(right);
+    emitTarget(label);
+}
+
+auto VirtualMachine::Assembler::code() const -> bytes_t
+{
+    auto code = _code;
+
+    for (const auto& [offset, label] : _fixups)
+    {
+        const auto target = _labels[label];
+
+        if (target == std::numeric_limits<std::size_t>::max())
+        {
+            ASURA_EXCEPTION("Label " + std::to_string(label)
+                            + " is never bound");
+        }
+
+        for (std::size_t i = 0; i < sizeof(std::uint32_t); i++)
+        {
+            code[offset + i] = view_as<byte_t>(target >> (i * CHAR_BIT));
+        }
+    }
+
+    return code;
+}
+
+auto VirtualMachine::Assembler::write(WriteBuffer& writeBuffer) const
+  -> void
+{
+    auto code = this->code();
+
+    writeBuffer.addVar<type_32us>(VERSION);
+    writeBuffer.addVar<type_array>(code.data(), code.size());
+}
+
+auto VirtualMachine::Assembler::emit(const Opcode opcode) -> void
+{
+    _code.push_back(view_as<byte_t>(opcode));
+}
+
+auto VirtualMachine::Assembler::emitRegister(const reg_t value) -> void
+{
+    if (value >= REGISTERS_COUNT)
+    {
+        ASURA_EXCEPTION("No register " + std::to_string(value));
+    }
+
+    _code.push_back(value);
+}
+
+auto VirtualMachine::Assembler::emitImmediate(const std::uint64_t value)
+  -> void
+{
+    for (std::size_t i = 0; i < sizeof(value); i++)
+    {
+        _code.push_back(view_as<byte_t>(value >> (i * CHAR_BIT)));
+    }
+}
+
+auto VirtualMachine::Assembler::emitTarget(const std::size_t label) -> void
+{
+    if (label >= _labels.size())
+    {
+        ASURA_EXCEPTION("No label " + std::to_string(label));
+    }
+
+    _fixups.push_back({ _code.size(), label });
+    _code.insert(_code.end(), sizeof(std::uint32_t), 0);
+}
+
+VirtualMachine::VirtualMachine(ReadBuffer& readBuffer)
+{
+    const auto version = readBuffer.readVar<type_32us>();
+
+    if (version != VERSION)
+    {
+        ASURA_EXCEPTION("Unsupported bytecode version "
+                        + std::to_string(version));
+    }
+
+    std::size_t size;
+    const auto code = readBuffer.readVar<type_array>(&size);
+
+    load(code, size);
+}
+
+VirtualMachine::VirtualMachine(const bytes_t& code)
+{
+    load(code.data(), code.size());
+}
+
+auto VirtualMachine::instructionsCount() const -> std::size_t
+{
+    return _instructions.size();
+}
+
+auto VirtualMachine::superinstructionsCount() const -> std::size_t
+{
+    return _superinstructions_count;
+}
+
+auto VirtualMachine::run(registers_t& registers) const -> std::uint64_t
+{
+    return Execute(_instructions.data(), registers.data(), nullptr);
+}
+
+auto VirtualMachine::load(const byte_t* code, const std::size_t size)
+  -> void
+{
+    std::size_t offset = 0, start = 0;
+
+    const auto read = [&](const std::size_t bytes)
+    {
+        if (offset + bytes > size)
+        {
+            ASURA_EXCEPTION("Truncated instruction at "
+                            + std::to_string(start));
+        }
+
+        std::uint64_t value = 0;
+
+        for (std::size_t i = 0; i < bytes; i++)
+        {
+            value |= view_as<std::uint64_t>(code[offset + i])
+                     << (i * CHAR_BIT);
+        }
+
+        offset += bytes;
+
+        return value;
+    };
+
+    const auto read_register = [&]()
+    {
+        const auto value = read(sizeof(reg_t));
+
+        if (value >= REGISTERS_COUNT)
+        {
+            ASURA_EXCEPTION("No register " + std::to_string(value));
+        }
+
+        return view_as<reg_t>(value);
+    };
+
+    /* Instruction index at each byte offset, or none */
+    std::vector<std::size_t> indices(size + 1,
+                                     std::numeric_limits<std::size_t>::max());
+
+    _instructions.clear();
+
+    while (offset < size)
+    {
+        start          = offset;
+        indices[start] = _instructions.size();
+
+        const auto opcode = read(sizeof(Opcode));
+
+        if (opcode >= view_as<std::uint64_t>(Opcode::count))
+        {
+            ASURA_EXCEPTION("Invalid opcode at " + std::to_string(start));
+        }
+
+        Instruction instruction;
+        instruction.operation = opcode;
+
+        const auto operands = OperandsOf(view_as<Opcode>(opcode));
+
+        switch (operands)
+        {
+            case Operands::r:
+            case Operands::rt:
+            {
+                instruction.registers[0] = read_register();
+                break;
+            }
+            case Operands::ri:
+            {
+                instruction.registers[0] = read_register();
+                instruction.immediate    = read(sizeof(std::uint64_t));
+                break;
+            }
+            case Operands::rr:
+            case Operands::rrt:
+            {
+                instruction.registers[0] = read_register();
+                instruction.registers[1] = read_register();
+                break;
+            }
+            case Operands::rrr:
+            {
+                instruction.registers[0] = read_register();
+                instruction.registers[1] = read_register();
+                instruction.registers[2] = read_register();
+                break;
+            }
+            case Operands::rri:
+            {
+                instruction.registers[0] = read_register();
+                instruction.registers[1] = read_register();
+                instruction.immediate    = read(sizeof(std::uint64_t));
+                break;
+            }
+            case Operands::t:
+            {
+                break;
+            }
+        }
+
+        if (operands == Operands::t or operands == Operands::rt
+            or operands == Operands::rrt)
+        {
+            instruction.target_index = read(sizeof(std::uint32_t));
+        }
+
+        _instructions.push_back(instruction);
+    }
+
+    /* Running past the end returns r0 */
+    indices[size] = _instructions.size();
+    _instructions.push_back({});
+
+    std::vector<bool> targets(_instructions.size());
+
+    for (auto&& instruction : _instructions)
+    {
+        const auto operands = OperandsOf(
+          view_as<Opcode>(instruction.operation));
+
+        if (operands != Operands::t and operands != Operands::rt
+            and operands != Operands::rrt)
+        {
+            continue;
+        }
+
+        if (instruction.target_index > size
+            or indices[instruction.target_index]
+                 == std::numeric_limits<std::size_t>::max())
+        {
+            ASURA_EXCEPTION("Jump to the middle of an instruction at "
+                            + std::to_string(instruction.target_index));
+        }
+
+        instruction.target_index = indices[instruction.target_index];
+        targets[instruction.target_index] = true;
+    }
+
+    fuse(targets);
+
+    /* Thread the code */
+    static const auto handlers = []()
+    {
+        const void* const* table;
+        Execute(nullptr, nullptr, &table);
+        return table;
+    }();
+
+    for (auto&& instruction : _instructions)
+    {
+        instruction.handler = handlers[instruction.operation];
+        instruction.target  = &_instructions[instruction.target_index];
+    }
+}
+
+auto VirtualMachine::fuse(const std::vector<bool>& targets) -> void
+{
+    std::vector<Instruction> fused;
+    std::vector<std::size_t> indices(_instructions.size());
+
+    _superinstructions_count = 0;
+
+    for (std::size_t i = 0; i < _instructions.size(); i++)
+    {
+        indices[i] = fused.size();
+
+        auto first = _instructions[i];
+
+        if (i + 1 >= _instructions.size() or targets[i + 1])
+        {
+            fused.push_back(first);
+            continue;
+        }
+
+        const auto& second = _instructions[i + 1];
+        const auto& a      = first.registers;
+        const auto& b      = second.registers;
+
+        const auto is = [](const Instruction& instruction,
+                           const Opcode opcode)
+        {
+            return instruction.operation == view_as<std::size_t>(opcode);
+        };
+
+        if (is(first, Opcode::addi) and is(second, Opcode::jlt)
+            and a[0] == a[1] and b[0] == a[0])
+        {
+            first.operation    = addi_jlt;
+            first.registers[1] = b[1];
+            first.target_index = second.target_index;
+        }
+        else if (is(first, Opcode::mul) and is(second, Opcode::add)
+                 and ((b[0] == b[1] and b[2] == a[0])
+                      or (b[0] == b[2] and b[1] == a[0])))
+        {
+            first.operation    = mul_add;
+            first.registers[3] = b[0];
+        }
+        else if ((is(first, Opcode::shli) or is(first, Opcode::shri))
+                 and is(second, Opcode::bit_xor) and b[0] == a[1]
+                 and ((b[1] == a[1] and b[2] == a[0])
+                      or (b[2] == a[1] and b[1] == a[0])))
+        {
+            first.operation = is(first, Opcode::shli) ? shli_xor :
+                                                        shri_xor;
+        }
+        else
+        {
+            fused.push_back(first);
+            continue;
+        }
+
+        fused.push_back(first);
+        _superinstructions_count++;
+
+        /* Nothing jumps to the second one */
+        indices[++i] = fused.size() - 1;
+    }
+
+    for (auto&& instruction : fused)
+    {
+        instruction.target_index = indices[instruction.target_index];
+    }
+
+    _instructions = std::move(fused);
+}
+
+/**
+ * Labels as values, GCC and clang only. Each handler ends with its own
+ * indirect jump to the next one, which predicts a lot better than the
+ * single one of a switch.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+auto VirtualMachine::Execute(const Instruction* instruction,
+                             std::uint64_t* registers,
+                             const void* const** handlers) -> std::uint64_t
+{
+    static const void* const table[] = {
+        &&op_ret,      &&op_movi,     &&op_mov,      &&op_add,
+        &&op_sub,      &&op_mul,      &&op_udiv,     &&op_urem,
+        &&op_bit_and,  &&op_bit_or,   &&op_bit_xor,  &&op_shl,
+        &&op_shr,      &&op_addi,     &&op_subi,     &&op_muli,
+        &&op_andi,     &&op_ori,      &&op_xori,     &&op_shli,
+        &&op_shri,     &&op_jmp,      &&op_jz,       &&op_jnz,
+        &&op_jeq,      &&op_jne,      &&op_jlt,      &&op_jge,
+        &&op_addi_jlt, &&op_mul_add,  &&op_shli_xor, &&op_shri_xor
+    };
+
+    static_assert(std::size(table) == operations_count);
+
+    if (handlers)
+    {
+        *handlers = table;
+        return 0;
+    }
+
+    auto ip = instruction;
+
+#define ASURA_VM_R(n) registers[ip->registers[n]]
+#define ASURA_VM_NEXT() goto* (++ip)->handler
+#define ASURA_VM_JUMP() goto* (ip = ip->target)->handler
+
+    goto* ip->handler;
+
+op_ret:
+    return ASURA_VM_R(0);
+op_movi:
+    ASURA_VM_R(0) = ip->immediate;
+    ASURA_VM_NEXT();
+op_mov:
+    ASURA_VM_R(0) = ASURA_VM_R(1);
+    ASURA_VM_NEXT();
+op_add:
+    ASURA_VM_R(0) = ASURA_VM_R(1) + ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_sub:
+    ASURA_VM_R(0) = ASURA_VM_R(1) - ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_mul:
+    ASURA_VM_R(0) = ASURA_VM_R(1) * ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_udiv:
+    if (ASURA_VM_R(2) == 0)
+    {
+        ASURA_EXCEPTION("Division by zero");
+    }
+    ASURA_VM_R(0) = ASURA_VM_R(1) / ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_urem:
+    if (ASURA_VM_R(2) == 0)
+    {
+        ASURA_EXCEPTION("Division by zero");
+    }
+    ASURA_VM_R(0) = ASURA_VM_R(1) % ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_bit_and:
+    ASURA_VM_R(0) = ASURA_VM_R(1) & ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_bit_or:
+    ASURA_VM_R(0) = ASURA_VM_R(1) | ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_bit_xor:
+    ASURA_VM_R(0) = ASURA_VM_R(1) ^ ASURA_VM_R(2);
+    ASURA_VM_NEXT();
+op_shl:
+    ASURA_VM_R(0) = ASURA_VM_R(1) << (ASURA_VM_R(2) & 63);
+    ASURA_VM_NEXT();
+op_shr:
+    ASURA_VM_R(0) = ASURA_VM_R(1) >> (ASURA_VM_R(2) & 63);
+    ASURA_VM_NEXT();
+op_addi:
+    ASURA_VM_R(0) = ASURA_VM_R(1) + ip->immediate;
+    ASURA_VM_NEXT();
+op_subi:
+    ASURA_VM_R(0) = ASURA_VM_R(1) - ip->immediate;
+    ASURA_VM_NEXT();
+op_muli:
+    ASURA_VM_R(0) = ASURA_VM_R(1) * ip->immediate;
+    ASURA_VM_NEXT();
+op_andi:
+    ASURA_VM_R(0) = ASURA_VM_R(1) & ip->immediate;
+    ASURA_VM_NEXT();
+op_ori:
+    ASURA_VM_R(0) = ASURA_VM_R(1) | ip->immediate;
+    ASURA_VM_NEXT();
+op_xori:
+    ASURA_VM_R(0) = ASURA_VM_R(1) ^ ip->immediate;
+    ASURA_VM_NEXT();
+op_shli:
+    ASURA_VM_R(0) = ASURA_VM_R(1) << (ip->immediate & 63);
+    ASURA_VM_NEXT();
+op_shri:
+    ASURA_VM_R(0) = ASURA_VM_R(1) >> (ip->immediate & 63);
+    ASURA_VM_NEXT();
+op_jmp:
+    ASURA_VM_JUMP();
+op_jz:
+    if (ASURA_VM_R(0) == 0)
+    {
+        ASURA_VM_JUMP();
+    }
+    ASURA_VM_NEXT();
+op_jnz:
+    if (ASURA_VM_R(0) != 0)
+    {
+        ASURA_VM_JUMP();
+    }
+    ASURA_VM_NEXT();
+op_jeq:
+    if (ASURA_VM_R(0) == ASURA_VM_R(1))
+    {
+        ASURA_VM_JUMP();
+    }
+    ASURA_VM_NEXT();
+op_jne:
+    if (ASURA_VM_R(0) != ASURA_VM_R(1))
+    {
+        ASURA_VM_JUMP();
+    }
+    ASURA_VM_NEXT();
+op_jlt:
+    if (ASURA_VM_R(0) < ASURA_VM_R(1))
+    {
+        ASURA_VM_JUMP();
+    }
+    ASURA_VM_NEXT();
+op_jge:
+    if (ASURA_VM_R(0) >= ASURA_VM_R(1))
+    {
+        ASURA_VM_JUMP();
+    }
+    ASURA_VM_NEXT();
+op_addi_jlt:
+    ASURA_VM_R(0) += ip->immediate;
+    if (ASURA_VM_R(0) < ASURA_VM_R(1))
+    {
+        ASURA_VM_JUMP();
+    }
+    ASURA_VM_NEXT();
+op_mul_add:
+    ASURA_VM_R(0)  = ASURA_VM_R(1) * ASURA_VM_R(2);
+    ASURA_VM_R(3) += ASURA_VM_R(0);
+    ASURA_VM_NEXT();
+op_shli_xor:
+    ASURA_VM_R(0)  = ASURA_VM_R(1) << (ip->immediate & 63);
+    ASURA_VM_R(1) ^= ASURA_VM_R(0);
+    ASURA_VM_NEXT();
+op_shri_xor:
+    ASURA_VM_R(0)  = ASURA_VM_R(1) >> (ip->immediate & 63);
+    ASURA_VM_R(1) ^= ASURA_VM_R(0);
+    ASURA_VM_NEXT();
+
+#undef ASURA_VM_R
+#undef ASURA_VM_NEXT
+#undef ASURA_VM_JUMP
+}
+
+#pragma GCC diagnostic pop
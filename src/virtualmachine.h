@@ -0,0 +1,183 @@
+#ifndef ASURA_VIRTUALMACHINE_H
+#define ASURA_VIRTUALMACHINE_H
+
+#include "readbuffer.h"
+#include "writebuffer.h"
+
+namespace Asura
+{
+    /**
+     * Register based virtual machine, to move logic out of native code:
+     *
+     * VirtualMachine::Assembler assembler;
+     * const auto loop = assembler.newLabel();
+     * assembler.movi(1, 0);
+     * assembler.bind(loop);
+     * assembler.alu(VirtualMachine::Opcode::add, 1, 1, 0);
+     * assembler.alui(VirtualMachine::Opcode::subi, 0, 0, 1);
+     * assembler.jump(VirtualMachine::Opcode::jnz, 0, loop);
+     * assembler.ret(1);
+     * assembler.write(write_buffer);
+     * ...
+     * VirtualMachine vm(read_buffer);
+     * VirtualMachine::registers_t registers { 10 };
+     * vm.run(registers); // 55
+     *
+     * The bytecode is compact, an opcode byte followed by its operands,
+     * and is stored as an array inside a WriteBuffer. Loading translates
+     * it once into threaded code: every instruction holds the address of
+     * its handler and its decoded operands, and each handler jumps
+     * straight to the next one, no decoding or switch at run time.
+     * Common sequences are fused into superinstructions while loading,
+     * when nothing jumps between them.
+     */
+    class VirtualMachine
+    {
+      public:
+        static constexpr std::uint32_t VERSION       = 1;
+        static constexpr std::size_t REGISTERS_COUNT = 16;
+
+        using registers_t = std::array<std::uint64_t, REGISTERS_COUNT>;
+        using reg_t       = byte_t;
+
+        /**
+         * Operands, r for a register, i for a 64 bits immediate and t
+         * for a jump target. Comparisons are unsigned.
+         */
+        enum class Opcode : byte_t
+        {
+            /* r */
+            ret,
+            /* r i */
+            movi,
+            /* r r */
+            mov,
+            /* r r r */
+            add,
+            sub,
+            mul,
+            udiv,
+            urem,
+            bit_and,
+            bit_or,
+            bit_xor,
+            shl,
+            shr,
+            /* r r i */
+            addi,
+            subi,
+            muli,
+            andi,
+            ori,
+            xori,
+            shli,
+            shri,
+            /* t */
+            jmp,
+            /* r t */
+            jz,
+            jnz,
+            /* r r t */
+            jeq,
+            jne,
+            jlt,
+            jge,
+            count
+        };
+
+        class Assembler
+        {
+          public:
+            auto newLabel() -> std::size_t;
+            auto bind(const std::size_t label) -> void;
+
+            auto ret(const reg_t value) -> void;
+            auto movi(const reg_t destination, const std::uint64_t value)
+              -> void;
+            auto mov(const reg_t destination, const reg_t source) -> void;
+            /* add to shr */
+            auto alu(const Opcode opcode,
+                     const reg_t destination,
+                     const reg_t left,
+                     const reg_t right) -> void;
+            /* addi to shri */
+            auto alui(const Opcode opcode,
+                      const reg_t destination,
+                      const reg_t left,
+                      const std::uint64_t right) -> void;
+            auto jmp(const std::size_t label) -> void;
+            /* jz, jnz */
+            auto jump(const Opcode opcode,
+                      const reg_t value,
+                      const std::size_t label) -> void;
+            /* jeq to jge */
+            auto jump(const Opcode opcode,
+                      const reg_t left,
+                      const reg_t right,
+                      const std::size_t label) -> void;
+
+            /* With the jump targets resolved */
+            auto code() const -> bytes_t;
+            auto write(WriteBuffer& writeBuffer) const -> void;
+
+          private:
+            auto emit(const Opcode opcode) -> void;
+            auto emitRegister(const reg_t value) -> void;
+            auto emitImmediate(const std::uint64_t value) -> void;
+            auto emitTarget(const std::size_t label) -> void;
+
+          private:
+            bytes_t _code;
+            std::vector<std::size_t> _labels;
+            /* Offset of the target to patch, label */
+            std::vector<std::pair<std::size_t, std::size_t>> _fixups;
+        };
+
+      public:
+        explicit VirtualMachine(ReadBuffer& readBuffer);
+        explicit VirtualMachine(const bytes_t& code);
+
+        /* The threaded code points to itself */
+        VirtualMachine(const VirtualMachine&)                    = delete;
+        auto operator=(const VirtualMachine&) -> VirtualMachine& = delete;
+        VirtualMachine(VirtualMachine&&)                         = default;
+        auto operator=(VirtualMachine&&) -> VirtualMachine&      = default;
+
+      public:
+        auto instructionsCount() const -> std::size_t;
+        auto superinstructionsCount() const -> std::size_t;
+
+      public:
+        /* Returns the value of ret, registers are the arguments */
+        auto run(registers_t& registers) const -> std::uint64_t;
+
+      private:
+        struct Instruction
+        {
+            const void* handler {};
+            const Instruction* target {};
+            std::uint64_t immediate {};
+            std::array<reg_t, 4> registers {};
+            /* Opcode or superinstruction */
+            std::size_t operation {};
+            /* Byte offset, then index of target */
+            std::size_t target_index {};
+        };
+
+      private:
+        /* Gives the handlers instead when handlers isn't null */
+        static auto Execute(const Instruction* instruction,
+                            std::uint64_t* registers,
+                            const void* const** handlers) -> std::uint64_t;
+
+      private:
+        auto load(const byte_t* code, const std::size_t size) -> void;
+        auto fuse(const std::vector<bool>& targets) -> void;
+
+      private:
+        std::vector<Instruction> _instructions;
+        std::size_t _superinstructions_count {};
+    };
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "bits.h"
 #include "buffer.h"
+#include "builtins.h"
+#include "simd.h"
 #include "types.h"
 
 /**
@@ -27,8 +29,8 @@ namespace Asura
         struct Occurrence
         {
             T letter_value;
-            /* let's limit the occurences to 256 times */
-            byte_t count {};
+            /* TREE streams limit them to 255 */
+            std::uint64_t count {};
         };
 
         struct Letter
@@ -92,14 +94,189 @@ namespace Asura
         using alphabet_t    = std::vector<Letter>;
         using occurrences_t = std::vector<Occurrence>;
 
+        enum Backend : byte_t
+        {
+            /* The binary tree above, written without any header */
+            TREE,
+            /* Canonical Huffman codes for the letters and the counts */
+            HUFFMAN
+        };
+
+        /**
+         * Streams starting with it have the version and the backend
+         * after it, the ones without it are TREE streams. These start
+         * with max_count_occurs_bits, never more than 8.
+         */
+        static constexpr std::array<byte_t, 3> MAGIC { 'X', 'K', 'C' };
+        /* 1 had no long runs, its counts were bytes */
+        static constexpr byte_t VERSION               = 2;
+        static constexpr std::size_t HEADER_SIZE      = MAGIC.size() + 2;
+        static constexpr std::size_t MAX_CODE_LENGTH  = 24;
+        static constexpr std::size_t MAX_TREE_COUNT   = 255;
+        /**
+         * Longer counts are escaped, symbol MAX_SHORT_COUNT + 1 + their
+         * bit width - 9, then their bits below the highest one. A MB of
+         * zeros is a single run.
+         */
+        static constexpr std::size_t MAX_SHORT_COUNT = 255;
+        static constexpr std::size_t COUNT_SYMBOLS_COUNT = MAX_SHORT_COUNT
+                                                           + 1 + 64 - 8;
+        /* Codes up to that length are decoded with one lookup */
+        static constexpr std::size_t TABLE_BITS = 11;
+
+        /* Least significant bit first, like the TREE streams */
+        class BitWriter
+        {
+          public:
+            explicit BitWriter(bytes_t& bytes);
+
+          public:
+            auto write(const std::uint32_t bits, const std::size_t count)
+              -> void;
+            /* Also pads a word, so readers can always load one */
+            auto flush() -> void;
+
+          private:
+            bytes_t& _bytes;
+            std::uint64_t _value {};
+            std::size_t _count {};
+        };
+
+        class BitReader
+        {
+          public:
+            BitReader() = default;
+            BitReader(const data_t data, const std::size_t size);
+
+          public:
+            /* The next 57 bits at least */
+            auto peek() const -> std::uint64_t;
+            auto skip(const std::size_t count) -> void;
+            /* Up to 32 bits */
+            auto read(const std::size_t count) -> std::uint32_t;
+
+          private:
+            data_t _data {};
+            std::size_t _size {};
+            std::size_t _bit_pos {};
+        };
+
+        /**
+         * Symbols are numbered by the length of their code, codes are
+         * given in that order, so the count of codes of each length is
+         * enough to rebuild them.
+         */
+        class HuffmanCode
+        {
+          public:
+            using length_counts_t = std::array<std::uint32_t,
+                                               MAX_CODE_LENGTH + 1>;
+
+          public:
+            /* Of every symbol, limited to MAX_CODE_LENGTH */
+            static auto Lengths(
+              const std::vector<std::size_t>& frequencies)
+              -> std::vector<byte_t>;
+
+          public:
+            HuffmanCode() = default;
+            /* Throws when the lengths can't make a prefix code */
+            explicit HuffmanCode(const length_counts_t& lengthCounts);
+
+          public:
+            auto write(BitWriter& writer, const std::uint32_t symbol) const
+              -> void;
+            auto read(BitReader& reader) const -> std::uint32_t;
+
+          private:
+            length_counts_t _length_counts {};
+            length_counts_t _first_codes {};
+            length_counts_t _first_symbols {};
+            /* Bit reversed, since the streams start with the low bits */
+            std::vector<std::uint32_t> _codes;
+            std::vector<byte_t> _lengths;
+            /* (symbol << 5) | length, length at 0 for longer codes */
+            std::vector<std::uint32_t> _table;
+        };
+
+        /**
+         * Decodes incrementally into buffers given by the caller, so
+         * big streams can be processed with a bounded amount of memory.
+         * Runs are kept pending between calls, a window can end in the
+         * middle of one.
+         */
+        class Decoder
+        {
+          public:
+            Decoder(const data_t data, const std::size_t size);
+
+          public:
+            auto finished() const -> bool;
+
+          public:
+            auto decode(const data_t out, const std::size_t maxSize)
+              -> std::size_t;
+
+          private:
+            auto initTree() -> void;
+            auto initHuffman() -> void;
+            auto readBit() -> std::uint32_t;
+            auto readOccurrence() -> void;
+
+          private:
+            data_t _data;
+            std::size_t _size;
+            Backend _backend { TREE };
+            byte_t _version {};
+            Occurrence _pending {};
+
+            /* TREE */
+            BinaryTree _binary_tree;
+            byte_t _max_count_occurs_bits {};
+            std::uint32_t _max_depth_bits {};
+            std::size_t _bit_pos {};
+            std::size_t _end_bit_pos {};
+
+            /* HUFFMAN, the two streams are read in turns */
+            std::vector<T> _letters;
+            std::vector<std::uint16_t> _counts;
+            HuffmanCode _letters_code;
+            HuffmanCode _counts_code;
+            BitReader _letters_reader;
+            BitReader _counts_reader;
+            std::uint64_t _occurrences_left {};
+        };
+
+        static constexpr std::size_t DECODE_CHUNK_SIZE = 0x10000;
+
       public:
-        static auto encode(const data_t data, const std::size_t size)
-          -> bytes_t;
-        static auto encode(const bytes_t& bytes) -> bytes_t;
+        static auto encode(const data_t data,
+                           const std::size_t size,
+                           const Backend backend = HUFFMAN) -> bytes_t;
+        static auto encode(const bytes_t& bytes,
+                           const Backend backend = HUFFMAN) -> bytes_t;
 
         static auto decode(const data_t data, const std::size_t size)
           -> bytes_t;
         static auto decode(const bytes_t& bytes) -> bytes_t;
+
+      private:
+        /* Of values[0], from 1 to maxLength */
+        static auto runLength(const T* values, const std::size_t maxLength)
+          -> std::size_t;
+        /* Calls callback(letter, count) for every run, in order */
+        static auto forEachOccurrence(const data_t data,
+                                      const std::size_t size,
+                                      const std::size_t maxCount,
+                                      const auto& callback) -> void;
+        static auto encodeTree(const occurrences_t& occurrences)
+          -> bytes_t;
+        static auto encodeHuffman(const data_t data, const std::size_t size)
+          -> bytes_t;
+
+        static auto countSymbol(const std::uint64_t count) -> std::uint16_t;
+        static auto readCount(const std::uint16_t symbol, BitReader& reader)
+          -> std::uint64_t;
     };
 }
 
@@ -212,9 +389,10 @@ auto Asura::XKC<T>::BinaryTree::insert(const T value) -> void
 }
 
 template <Asura::XKCAlphabetType T>
-auto Asura::XKC<T>::encode(const bytes_t& bytes) -> Asura::bytes_t
+auto Asura::XKC<T>::encode(const bytes_t& bytes, const Backend backend)
+  -> Asura::bytes_t
 {
-    return encode(view_as<data_t>(bytes.data()), bytes.size());
+    return encode(view_as<data_t>(bytes.data()), bytes.size(), backend);
 }
 
 template <Asura::XKCAlphabetType T>
@@ -436,47 +614,128 @@ auto Asura::XKC<T>::BinaryTree::dot_format() const -> std::string
     return result;
 }
 
+/**
+ * Compares a SIMD value of letters at once with the first one, the first
+ * different byte gives the end of the run. Long runs of zeros or 0xCC
+ * go 4 values at a time.
+ */
 template <Asura::XKCAlphabetType T>
-auto Asura::XKC<T>::encode(const data_t data, const std::size_t size)
-  -> bytes_t
+auto Asura::XKC<T>::runLength(const T* values, const std::size_t maxLength)
+  -> std::size_t
 {
-    bytes_t result;
-    alphabet_t alphabet;
-    occurrences_t occurrences;
+    const auto value   = values[0];
+    std::size_t length = 1;
 
-    const auto values       = view_as<T*>(data);
-    std::size_t value_index = 0;
-    const auto max_values   = size / sizeof(T);
+    /* Most runs in code or random data stop right away */
+    if (maxLength == 1 or values[1] != value)
+    {
+        return 1;
+    }
 
-    /**
-     * Store contiguous values
-     */
-    while (value_index < max_values)
+#ifdef ASURA_HAS_SIMD
+    constexpr auto simd_values = sizeof(SIMD::value_t) / sizeof(T);
+
+    SIMD::value_t letters;
+
+    for (std::size_t i = 0; i < simd_values; i++)
     {
-        std::size_t start_occurrence_index = value_index++;
-        Occurrence occurrence;
+        std::memcpy(view_as<byte_t*>(&letters) + i * sizeof(T),
+                    &value,
+                    sizeof(T));
+    }
 
-        occurrence.letter_value = values[start_occurrence_index];
-        occurrence.count        = 1;
+    const auto compare = [&](const std::size_t index)
+    {
+        return SIMD::CMPMask8bits(
+          SIMD::LoadUnaligned(view_as<SIMD::value_t*>(&values[index])),
+          letters);
+    };
 
-        for (; value_index < max_values; value_index++)
+    for (; length + simd_values * 4 <= maxLength;
+         length += simd_values * 4)
+    {
+        if ((compare(length) & compare(length + simd_values)
+             & compare(length + simd_values * 2)
+             & compare(length + simd_values * 3))
+            != SIMD::cmp_all)
         {
-            if (occurrence.count
-                == std::numeric_limits<decltype(Occurrence::count)>::max())
-            {
-                break;
-            }
+            break;
+        }
+    }
 
-            if (values[start_occurrence_index] != values[value_index])
-            {
-                break;
-            }
+    for (; length + simd_values <= maxLength; length += simd_values)
+    {
+        const auto mask = compare(length);
 
-            occurrence.count++;
+        if (mask != SIMD::cmp_all)
+        {
+            return length + Builtins::CTZ(~mask) / sizeof(T);
         }
+    }
+#endif
+
+    while (length < maxLength and values[length] == value)
+    {
+        length++;
+    }
+
+    return length;
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::forEachOccurrence(const data_t data,
+                                      const std::size_t size,
+                                      const std::size_t maxCount,
+                                      const auto& callback) -> void
+{
+    const auto values     = view_as<const T*>(data);
+    const auto max_values = size / sizeof(T);
+
+    for (std::size_t value_index = 0; value_index < max_values;)
+    {
+        const auto count = runLength(&values[value_index],
+                                     std::min(maxCount,
+                                              max_values - value_index));
+
+        callback(values[value_index], count);
+        value_index += count;
+    }
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::encode(const data_t data,
+                           const std::size_t size,
+                           const Backend backend) -> bytes_t
+{
+    switch (backend)
+    {
+        case TREE:
+        {
+            occurrences_t occurrences;
 
-        occurrences.push_back(occurrence);
+            forEachOccurrence(data,
+                              size,
+                              MAX_TREE_COUNT,
+                              [&](const T letter, const std::size_t count)
+                              {
+                                  occurrences.push_back({ letter, count });
+                              });
+
+            return encodeTree(occurrences);
+        }
+        case HUFFMAN:
+            return encodeHuffman(data, size);
+        default:
+            ASURA_EXCEPTION("Unknown XKC backend");
     }
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::encodeTree(const occurrences_t& occurrences)
+  -> bytes_t
+{
+    bytes_t result;
+    alphabet_t alphabet;
 
     /* Construct the alphabet */
     for (const auto& occurrence : occurrences)
@@ -523,7 +782,7 @@ auto Asura::XKC<T>::encode(const data_t data, const std::size_t size)
     const auto max_count_occurs = std::max_element(
       occurrences.begin(),
       occurrences.end(),
-      [](Occurrence& a, Occurrence& b)
+      [](const Occurrence& a, const Occurrence& b)
       {
           return (a.count < b.count);
       });
@@ -639,14 +898,53 @@ auto Asura::XKC<T>::decode(const bytes_t& bytes) -> bytes_t
 }
 
 template <Asura::XKCAlphabetType T>
-auto Asura::XKC<T>::decode(const data_t data, const std::size_t size)
-  -> Asura::bytes_t
+Asura::XKC<T>::Decoder::Decoder(const data_t data, const std::size_t size)
+ : _data(data),
+   _size(size)
 {
-    bytes_t result;
+    if (size >= HEADER_SIZE
+        and std::equal(MAGIC.begin(), MAGIC.end(), data))
+    {
+        _version = data[MAGIC.size()];
+
+        if (_version == 0 or _version > VERSION)
+        {
+            ASURA_EXCEPTION("Unsupported XKC version "
+                            + std::to_string(_version));
+        }
+
+        _backend = view_as<Backend>(data[MAGIC.size() + 1]);
+        _data += HEADER_SIZE;
+        _size -= HEADER_SIZE;
+    }
+
+    switch (_backend)
+    {
+        case TREE:
+            initTree();
+            break;
+        case HUFFMAN:
+            initHuffman();
+            break;
+        default:
+            ASURA_EXCEPTION("Unknown XKC backend");
+    }
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::Decoder::initTree() -> void
+{
+    const auto data = _data;
+    const auto size = _size;
 
     std::size_t read_bytes = 0;
 
-    auto written_bits = *view_as<std::uint32_t*>(
+    if (size < sizeof(byte_t) + sizeof(std::uint32_t) * 2)
+    {
+        ASURA_EXCEPTION("Not enough bytes to decode.");
+    }
+
+    const auto written_bits = *view_as<std::uint32_t*>(
       view_as<std::uintptr_t>(data) + size - sizeof(std::uint32_t));
 
     if (written_bits / CHAR_BIT >= size)
@@ -654,105 +952,808 @@ auto Asura::XKC<T>::decode(const data_t data, const std::size_t size)
         ASURA_EXCEPTION("there's too much bits to decode.");
     }
 
-    const auto max_count_occurs_bits = data[read_bytes];
+    _max_count_occurs_bits = data[read_bytes];
     read_bytes += sizeof(byte_t);
 
     const auto alphabet_size = *view_as<std::uint32_t*>(&data[read_bytes]);
     read_bytes += sizeof(std::uint32_t);
 
-    alphabet_t alphabet;
+    if (read_bytes + alphabet_size * sizeof(T) > size)
+    {
+        ASURA_EXCEPTION("Alphabet is bigger than the data.");
+    }
 
+    /* Construct the tree */
     for (std::size_t alphabet_index = 0; alphabet_index < alphabet_size;
          alphabet_index++)
     {
-        auto letter_value = *view_as<T*>(&data[read_bytes]);
+        _binary_tree.insert(*view_as<T*>(&data[read_bytes]));
         read_bytes += sizeof(T);
+    }
+
+    _max_depth_bits = view_as<std::uint32_t>(
+      bits_needed(_binary_tree.root->height()));
 
-        alphabet.push_back({ letter_value });
+    _bit_pos     = read_bytes * CHAR_BIT;
+    _end_bit_pos = _bit_pos + written_bits;
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::Decoder::finished() const -> bool
+{
+    if (_backend == HUFFMAN)
+    {
+        return _pending.count == 0 and _occurrences_left == 0;
     }
 
-    BinaryTree binary_tree;
+    return _pending.count == 0 and _bit_pos >= _end_bit_pos;
+}
 
-    /* Construct the tree */
-    for (const auto& letter : alphabet)
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::Decoder::readBit() -> std::uint32_t
+{
+    const auto read_bytes = _bit_pos / CHAR_BIT;
+
+    if (read_bytes >= _size - sizeof(std::uint32_t))
     {
-        binary_tree.insert(letter.value);
+        ASURA_EXCEPTION("Too much bytes decoded.. "
+                        "Something is wrong.");
     }
 
-    const auto max_tree_depth = binary_tree.root->height();
+    const auto value = (_data[read_bytes] & (1u << (_bit_pos % CHAR_BIT))) ?
+                         1u :
+                         0;
 
-    const auto max_depth_bits = view_as<std::uint32_t>(
-      bits_needed(max_tree_depth));
+    _bit_pos++;
 
-    std::size_t read_bits_on_result_byte = 0;
-    std::size_t bits_read                = 0;
-    occurrences_t occurrences;
+    return value;
+}
 
-    while (bits_read < written_bits)
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::Decoder::readOccurrence() -> void
+{
+    PathInfoResult path_info;
+    byte_t count = 0;
+
+    for (std::size_t count_bit = 0; count_bit < _max_count_occurs_bits;
+         count_bit++)
     {
-        const auto read_bit = [&read_bytes,
-                               &read_bits_on_result_byte,
-                               &bits_read,
-                               &data,
-                               &size]()
-        {
-            const auto value = (data[read_bytes]
-                                & (1u << read_bits_on_result_byte)) ?
-                                 1u :
-                                 0;
+        count |= readBit() << count_bit;
+    }
+
+    for (std::uint32_t depth_bit = 0; depth_bit < _max_depth_bits;
+         depth_bit++)
+    {
+        path_info.depth |= readBit() << depth_bit;
+    }
+
+    for (std::size_t depth = 0; depth < path_info.depth; depth++)
+    {
+        path_info.bit_path[depth] = readBit();
+    }
+
+    _binary_tree.find_value(path_info);
 
-            read_bits_on_result_byte++;
-            bits_read++;
+    _pending = { path_info.letter_value, count };
+}
 
-            if (read_bits_on_result_byte == CHAR_BIT)
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::Decoder::decode(const data_t out,
+                                    const std::size_t maxSize)
+  -> std::size_t
+{
+    std::size_t written = 0;
+
+    /**
+     * Writing bytes could change any member for the compiler, the state
+     * is kept in locals so it isn't loaded again after every run.
+     */
+    auto pending          = _pending;
+    auto letters_reader   = _letters_reader;
+    auto counts_reader    = _counts_reader;
+    auto occurrences_left = _occurrences_left;
+    const auto letters    = _letters.data();
+    const auto counts     = _counts.data();
+
+    while (written + sizeof(T) <= maxSize)
+    {
+        if (pending.count == 0)
+        {
+            if (_backend == HUFFMAN)
             {
-                read_bytes++;
-                read_bits_on_result_byte = 0;
+                if (occurrences_left == 0)
+                {
+                    break;
+                }
 
-                if (read_bytes >= size)
+                const auto letter = letters[_letters_code.read(
+                  letters_reader)];
+                const auto count_symbol = counts[_counts_code.read(
+                  counts_reader)];
+
+                pending = { letter, readCount(count_symbol, counts_reader) };
+                occurrences_left--;
+            }
+            else
+            {
+                if (_bit_pos >= _end_bit_pos)
                 {
-                    ASURA_EXCEPTION("Too much bytes decoded.. "
-                                    "Something is wrong.");
+                    break;
                 }
+
+                readOccurrence();
+                pending = _pending;
+            }
+        }
+
+        const auto count = std::min<std::size_t>(
+          pending.count,
+          (maxSize - written) / sizeof(T));
+
+        /* Most runs are short, not worth a call */
+        if (count == 1)
+        {
+            std::memcpy(&out[written], &pending.letter_value, sizeof(T));
+        }
+        else if constexpr (sizeof(T) == sizeof(byte_t))
+        {
+            std::memset(&out[written], pending.letter_value, count);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                std::memcpy(&out[written + i * sizeof(T)],
+                            &pending.letter_value,
+                            sizeof(T));
             }
+        }
 
-            return value;
+        written += count * sizeof(T);
+        pending.count -= count;
+    }
+
+    _pending          = pending;
+    _letters_reader   = letters_reader;
+    _counts_reader    = counts_reader;
+    _occurrences_left = occurrences_left;
+
+    return written;
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::decode(const data_t data, const std::size_t size)
+  -> Asura::bytes_t
+{
+    bytes_t result;
+    Decoder decoder(data, size);
+
+    while (not decoder.finished())
+    {
+        const auto old_size = result.size();
+
+        result.resize(old_size + DECODE_CHUNK_SIZE);
+        result.resize(old_size
+                      + decoder.decode(&result[old_size],
+                                       DECODE_CHUNK_SIZE));
+    }
+
+    return result;
+}
+
+template <Asura::XKCAlphabetType T>
+Asura::XKC<T>::BitWriter::BitWriter(bytes_t& bytes)
+ : _bytes(bytes)
+{
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::BitWriter::write(const std::uint32_t bits,
+                                     const std::size_t count) -> void
+{
+    _value |= (view_as<std::uint64_t>(bits)
+               & ((std::uint64_t { 1 } << count) - 1))
+              << _count;
+    _count += count;
+
+    if (_count >= sizeof(std::uint32_t) * CHAR_BIT)
+    {
+        const auto bytes = view_as<const byte_t*>(&_value);
+        _bytes.insert(_bytes.end(), bytes, bytes + sizeof(std::uint32_t));
+
+        _value >>= sizeof(std::uint32_t) * CHAR_BIT;
+        _count  -= sizeof(std::uint32_t) * CHAR_BIT;
+    }
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::BitWriter::flush() -> void
+{
+    for (; _count > 0; _count -= std::min<std::size_t>(_count, CHAR_BIT))
+    {
+        _bytes.push_back(view_as<byte_t>(_value));
+        _value >>= CHAR_BIT;
+    }
+
+    _bytes.insert(_bytes.end(), sizeof(std::uint64_t), 0);
+}
+
+template <Asura::XKCAlphabetType T>
+Asura::XKC<T>::BitReader::BitReader(const data_t data,
+                                    const std::size_t size)
+ : _data(data),
+   _size(size)
+{
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::BitReader::peek() const -> std::uint64_t
+{
+    const auto read_bytes = _bit_pos / CHAR_BIT;
+
+    /* The writer padded a word, only a broken stream gets there */
+    if (read_bytes + sizeof(std::uint64_t) > _size)
+    {
+        ASURA_EXCEPTION("Too much bytes decoded.. "
+                        "Something is wrong.");
+    }
+
+    std::uint64_t value;
+    std::memcpy(&value, _data + read_bytes, sizeof(value));
+
+    return value >> (_bit_pos % CHAR_BIT);
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::BitReader::skip(const std::size_t count) -> void
+{
+    _bit_pos += count;
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::BitReader::read(const std::size_t count)
+  -> std::uint32_t
+{
+    const auto value = view_as<std::uint32_t>(
+      peek() & ((std::uint64_t { 1 } << count) - 1));
+
+    skip(count);
+
+    return value;
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::countSymbol(const std::uint64_t count) -> std::uint16_t
+{
+    if (count <= MAX_SHORT_COUNT)
+    {
+        return view_as<std::uint16_t>(count);
+    }
+
+    return view_as<std::uint16_t>(MAX_SHORT_COUNT + 1 + std::bit_width(count)
+                                  - 9);
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::readCount(const std::uint16_t symbol,
+                              BitReader& reader) -> std::uint64_t
+{
+    if (symbol <= MAX_SHORT_COUNT)
+    {
+        return symbol;
+    }
+
+    const auto bits_count     = view_as<std::size_t>(symbol
+                                                 - (MAX_SHORT_COUNT + 1))
+                            + 8;
+    const auto low_bits_count = std::min<std::size_t>(bits_count, 32);
+
+    std::uint64_t count = reader.read(low_bits_count);
+
+    if (bits_count > low_bits_count)
+    {
+        count |= view_as<std::uint64_t>(
+                   reader.read(bits_count - low_bits_count))
+                 << 32;
+    }
+
+    return count | (std::uint64_t { 1 } << bits_count);
+}
+
+/**
+ * Huffman tree built with a heap, the frequencies are halved until no
+ * code is longer than MAX_CODE_LENGTH. That's less optimal than
+ * package-merge, but it only happens with very skewed alphabets.
+ */
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::HuffmanCode::Lengths(
+  const std::vector<std::size_t>& frequencies) -> std::vector<byte_t>
+{
+    const auto symbols_count = frequencies.size();
+
+    std::vector<byte_t> lengths(symbols_count);
+
+    if (symbols_count == 1)
+    {
+        lengths.front() = 1;
+    }
+
+    if (symbols_count <= 1)
+    {
+        return lengths;
+    }
+
+    if (symbols_count > (std::size_t { 1 } << MAX_CODE_LENGTH))
+    {
+        ASURA_EXCEPTION("Too many symbols for the Huffman codes");
+    }
+
+    using node_t = std::pair<std::size_t, std::size_t>;
+
+    auto weights = frequencies;
+
+    for (;;)
+    {
+        /* Min heap of the weights */
+        std::vector<node_t> heap(symbols_count);
+
+        for (std::size_t i = 0; i < symbols_count; i++)
+        {
+            heap[i] = { weights[i], i };
+        }
+
+        std::make_heap(heap.begin(), heap.end(), std::greater<>());
+
+        const auto pop = [&heap]()
+        {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+            const auto node = heap.back();
+            heap.pop_back();
+
+            return node;
         };
 
-        PathInfoResult path_info;
-        byte_t count = 0;
+        /* Nodes are made in order, parents always come after */
+        std::vector<std::size_t> parents(symbols_count * 2 - 1);
+        auto next_node = symbols_count;
 
-        for (std::size_t count_bit = 0; count_bit < max_count_occurs_bits;
-             count_bit++)
+        while (heap.size() > 1)
         {
-            count |= read_bit() << count_bit;
+            const auto first  = pop();
+            const auto second = pop();
+
+            parents[first.second]  = next_node;
+            parents[second.second] = next_node;
+
+            heap.push_back({ first.first + second.first, next_node++ });
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
         }
 
-        for (std::uint32_t depth_bit = 0; depth_bit < max_depth_bits;
-             depth_bit++)
+        std::vector<std::size_t> depths(next_node);
+        std::size_t max_depth = 0;
+
+        for (auto node = next_node - 1; node-- > 0;)
         {
-            path_info.depth |= read_bit() << depth_bit;
+            depths[node] = depths[parents[node]] + 1;
+            max_depth    = std::max(max_depth, depths[node]);
         }
 
-        for (std::size_t depth = 0; depth < path_info.depth; depth++)
+        if (max_depth <= MAX_CODE_LENGTH)
         {
-            path_info.bit_path[depth] = read_bit();
+            for (std::size_t i = 0; i < symbols_count; i++)
+            {
+                lengths[i] = view_as<byte_t>(depths[i]);
+            }
+
+            return lengths;
+        }
+
+        for (auto&& weight : weights)
+        {
+            weight = (weight >> 1) | 1;
+        }
+    }
+}
+
+template <Asura::XKCAlphabetType T>
+Asura::XKC<T>::HuffmanCode::HuffmanCode(
+  const length_counts_t& lengthCounts)
+ : _length_counts(lengthCounts),
+   _table(std::size_t { 1 } << TABLE_BITS)
+{
+    _length_counts[0] = 0;
+
+    std::uint64_t code   = 0;
+    std::uint32_t symbol = 0;
+
+    for (std::size_t length = 1; length <= MAX_CODE_LENGTH; length++)
+    {
+        code <<= 1;
+
+        if (_length_counts[length] > (std::uint64_t { 1 } << length) - code)
+        {
+            ASURA_EXCEPTION("The Huffman code lengths are invalid");
         }
 
-        binary_tree.find_value(path_info);
+        _first_codes[length]   = view_as<std::uint32_t>(code);
+        _first_symbols[length] = symbol;
 
-        occurrences.push_back({ path_info.letter_value, count });
+        code   += _length_counts[length];
+        symbol += _length_counts[length];
     }
 
-    for (const auto& occurrence : occurrences)
+    _codes.resize(symbol);
+    _lengths.resize(symbol);
+
+    for (std::size_t length = 1; length <= MAX_CODE_LENGTH; length++)
+    {
+        for (std::uint32_t i = 0; i < _length_counts[length]; i++)
+        {
+            const auto current_symbol = _first_symbols[length] + i;
+            const auto current_code   = _first_codes[length] + i;
+
+            std::uint32_t reversed_code = 0;
+
+            for (std::size_t bit = 0; bit < length; bit++)
+            {
+                reversed_code |= ((current_code >> bit) & 1)
+                                 << (length - 1 - bit);
+            }
+
+            _codes[current_symbol]   = reversed_code;
+            _lengths[current_symbol] = view_as<byte_t>(length);
+
+            /* Every entry starting with the code */
+            if (length <= TABLE_BITS)
+            {
+                for (auto entry = reversed_code; entry < _table.size();
+                     entry     += 1u << length)
+                {
+                    _table[entry] = (current_symbol << 5)
+                                    | view_as<std::uint32_t>(length);
+                }
+            }
+        }
+    }
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::HuffmanCode::write(BitWriter& writer,
+                                       const std::uint32_t symbol) const
+  -> void
+{
+    writer.write(_codes[symbol], _lengths[symbol]);
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::HuffmanCode::read(BitReader& reader) const
+  -> std::uint32_t
+{
+    const auto bits  = reader.peek();
+    const auto entry = _table[bits & ((1u << TABLE_BITS) - 1)];
+
+    if (entry & 0x1F) [[likely]]
+    {
+        reader.skip(entry & 0x1F);
+        return entry >> 5;
+    }
+
+    /* The stream has the first bit of the code first */
+    std::uint32_t code = 0;
+
+    for (std::size_t length = 1; length <= MAX_CODE_LENGTH; length++)
+    {
+        code = (code << 1) | view_as<std::uint32_t>((bits >> (length - 1)) & 1);
+
+        if (code - _first_codes[length] < _length_counts[length])
+        {
+            reader.skip(length);
+            return _first_symbols[length] + code - _first_codes[length];
+        }
+    }
+
+    ASURA_EXCEPTION("Invalid Huffman code");
+}
+
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::encodeHuffman(const data_t data,
+                                  const std::size_t size) -> bytes_t
+{
+    constexpr auto is_small_alphabet = sizeof(T) <= sizeof(std::uint16_t);
+    constexpr auto no_number = std::numeric_limits<std::uint32_t>::max();
+
+    using numbers_t = std::conditional_t<is_small_alphabet,
+                                         std::vector<std::uint32_t>,
+                                         std::unordered_map<T, std::uint32_t>>;
+    using length_counts_t = typename HuffmanCode::length_counts_t;
+
+    /* Letters by order of appearance first */
+    numbers_t letter_numbers;
+
+    if constexpr (is_small_alphabet)
+    {
+        letter_numbers.assign(std::size_t { std::numeric_limits<T>::max() }
+                                + 1,
+                              no_number);
+    }
+
+    const auto letter_number = [&](const T letter) -> std::uint32_t&
+    {
+        if constexpr (is_small_alphabet)
+        {
+            return letter_numbers[letter];
+        }
+        else
+        {
+            return letter_numbers.try_emplace(letter, no_number)
+              .first->second;
+        }
+    };
+
+    std::vector<T> letters;
+    std::vector<std::size_t> letter_frequencies;
+    std::vector<std::uint16_t> counts;
+    std::vector<std::size_t> count_frequencies;
+    std::array<std::uint32_t, COUNT_SYMBOLS_COUNT> count_numbers;
+    count_numbers.fill(no_number);
+    std::uint64_t occurrences_count = 0;
+
+    /**
+     * Runs are found again to write them, it's cheaper than keeping
+     * them all in memory.
+     */
+    forEachOccurrence(
+      data,
+      size,
+      std::numeric_limits<std::size_t>::max(),
+      [&](const T letter, const std::size_t count)
+      {
+          auto&& number = letter_number(letter);
+
+          if (number == no_number)
+          {
+              number = view_as<std::uint32_t>(letters.size());
+              letters.push_back(letter);
+              letter_frequencies.push_back(0);
+          }
+
+          letter_frequencies[number]++;
+
+          const auto count_symbol = countSymbol(count);
+          auto&& count_number     = count_numbers[count_symbol];
+
+          if (count_number == no_number)
+          {
+              count_number = view_as<std::uint32_t>(counts.size());
+              counts.push_back(count_symbol);
+              count_frequencies.push_back(0);
+          }
+
+          count_frequencies[count_number]++;
+          occurrences_count++;
+      });
+
+    /* Sorts the symbols by code length then value, their new numbers */
+    const auto make_code = [](auto& symbols,
+                              const std::vector<std::size_t>& frequencies,
+                              length_counts_t& lengthCounts,
+                              HuffmanCode& code)
     {
-        for (std::size_t count = 0; count < occurrence.count; count++)
+        const auto lengths = HuffmanCode::Lengths(frequencies);
+
+        std::vector<std::uint32_t> order(symbols.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        std::sort(order.begin(),
+                  order.end(),
+                  [&](const std::uint32_t left, const std::uint32_t right)
+                  {
+                      return std::tie(lengths[left], symbols[left])
+                             < std::tie(lengths[right], symbols[right]);
+                  });
+
+        auto sorted_symbols = symbols;
+
+        for (std::size_t i = 0; i < order.size(); i++)
         {
-            result.push_back(occurrence.letter_value);
+            sorted_symbols[i] = symbols[order[i]];
+            lengthCounts[lengths[order[i]]]++;
         }
+
+        symbols = std::move(sorted_symbols);
+        code    = HuffmanCode(lengthCounts);
+    };
+
+    length_counts_t letter_length_counts {}, count_length_counts {};
+    HuffmanCode letters_code, counts_code;
+
+    make_code(letters, letter_frequencies, letter_length_counts, letters_code);
+    make_code(counts, count_frequencies, count_length_counts, counts_code);
+
+    for (std::size_t i = 0; i < letters.size(); i++)
+    {
+        letter_number(letters[i]) = view_as<std::uint32_t>(i);
+    }
+
+    for (std::size_t i = 0; i < counts.size(); i++)
+    {
+        count_numbers[counts[i]] = view_as<std::uint32_t>(i);
     }
 
+    bytes_t result(MAGIC.begin(), MAGIC.end());
+    result.push_back(VERSION);
+    result.push_back(HUFFMAN);
+
+    const auto append = [&result](const auto value)
+    {
+        const auto bytes = view_as<const byte_t*>(&value);
+        result.insert(result.end(), bytes, bytes + sizeof(value));
+    };
+
+    /* The longest length, the count of each length, then the symbols */
+    const auto append_code = [&](const length_counts_t& lengthCounts,
+                                 const auto& symbols)
+    {
+        auto max_length = MAX_CODE_LENGTH;
+
+        while (max_length > 0 and lengthCounts[max_length] == 0)
+        {
+            max_length--;
+        }
+
+        append(view_as<byte_t>(max_length));
+
+        for (std::size_t length = 1; length <= max_length; length++)
+        {
+            append(lengthCounts[length]);
+        }
+
+        for (const auto symbol : symbols)
+        {
+            append(symbol);
+        }
+    };
+
+    append_code(letter_length_counts, letters);
+    append_code(count_length_counts, counts);
+    append(occurrences_count);
+
+    bytes_t letters_stream, counts_stream;
+    BitWriter letters_writer(letters_stream), counts_writer(counts_stream);
+
+    forEachOccurrence(
+      data,
+      size,
+      std::numeric_limits<std::size_t>::max(),
+      [&](const T letter, const std::size_t count)
+      {
+          const auto count_symbol = countSymbol(count);
+
+          letters_code.write(letters_writer, letter_number(letter));
+          counts_code.write(counts_writer, count_numbers[count_symbol]);
+
+          if (count_symbol <= MAX_SHORT_COUNT)
+          {
+              return;
+          }
+
+          /* The highest bit is known from the symbol */
+          const auto bits_count = view_as<std::size_t>(std::bit_width(count))
+                                  - 1;
+          const auto low_bits_count = std::min<std::size_t>(bits_count, 32);
+
+          counts_writer.write(view_as<std::uint32_t>(count),
+                              low_bits_count);
+
+          if (bits_count > low_bits_count)
+          {
+              counts_writer.write(view_as<std::uint32_t>(count >> 32),
+                                  bits_count - low_bits_count);
+          }
+      });
+
+    letters_writer.flush();
+    counts_writer.flush();
+
+    append(view_as<std::uint64_t>(letters_stream.size()));
+    append(view_as<std::uint64_t>(counts_stream.size()));
+    result.insert(result.end(), letters_stream.begin(), letters_stream.end());
+    result.insert(result.end(), counts_stream.begin(), counts_stream.end());
+
     return result;
 }
 
+template <Asura::XKCAlphabetType T>
+auto Asura::XKC<T>::Decoder::initHuffman() -> void
+{
+    std::size_t read_bytes = 0;
+
+    const auto read = [&]<typename V>()
+    {
+        if (_size - read_bytes < sizeof(V))
+        {
+            ASURA_EXCEPTION("Not enough bytes to decode.");
+        }
+
+        V value;
+        std::memcpy(&value, _data + read_bytes, sizeof(value));
+        read_bytes += sizeof(value);
+
+        return value;
+    };
+
+    const auto read_code = [&]<typename S>(std::vector<S>& symbols,
+                                           HuffmanCode& code)
+    {
+        const auto max_length = read.template operator()<byte_t>();
+
+        if (max_length > MAX_CODE_LENGTH)
+        {
+            ASURA_EXCEPTION("The Huffman codes are too long");
+        }
+
+        typename HuffmanCode::length_counts_t length_counts {};
+        std::uint64_t symbols_count = 0;
+
+        for (std::size_t length = 1; length <= max_length; length++)
+        {
+            length_counts[length] = read.template
+                                    operator()<std::uint32_t>();
+            symbols_count += length_counts[length];
+        }
+
+        if (symbols_count > (_size - read_bytes) / sizeof(S))
+        {
+            ASURA_EXCEPTION("Alphabet is bigger than the data.");
+        }
+
+        code = HuffmanCode(length_counts);
+        symbols.resize(view_as<std::size_t>(symbols_count));
+
+        for (auto&& symbol : symbols)
+        {
+            symbol = read.template operator()<S>();
+        }
+    };
+
+    read_code(_letters, _letters_code);
+
+    if (_version == 1)
+    {
+        std::vector<byte_t> counts;
+        read_code(counts, _counts_code);
+        _counts.assign(counts.begin(), counts.end());
+    }
+    else
+    {
+        read_code(_counts, _counts_code);
+
+        if (std::any_of(_counts.begin(),
+                        _counts.end(),
+                        [](const std::uint16_t symbol)
+                        {
+                            return symbol >= COUNT_SYMBOLS_COUNT;
+                        }))
+        {
+            ASURA_EXCEPTION("Invalid run count");
+        }
+    }
+
+    _occurrences_left = read.template operator()<std::uint64_t>();
+
+    const auto letters_size = read.template operator()<std::uint64_t>();
+    const auto counts_size  = read.template operator()<std::uint64_t>();
+
+    if (letters_size > _size - read_bytes
+        or counts_size > _size - read_bytes - letters_size)
+    {
+        ASURA_EXCEPTION("The streams are bigger than the data.");
+    }
+
+    _letters_reader = BitReader(_data + read_bytes,
+                                view_as<std::size_t>(letters_size));
+    _counts_reader  = BitReader(_data + read_bytes + letters_size,
+                               view_as<std::size_t>(counts_size));
+}
+
 #endif